@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Geometry scaling of the B2a tracker: placements vs. parameterised chambers.
+
+Usage: chamber_scaling.py <exampleB2a executable> [count ...]
+
+For every chamber count, runs the same geantino beam through the tracker in
+both chamber modes and prints a markdown table of setup time, peak RSS,
+volumes in the geometry store and navigation time per chamber crossed.
+Geantinos do not interact, so every event crosses every chamber and the
+per-crossing time isolates the navigation cost.
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+COUNTS = [5, 100, 1000, 10000]
+MODES = ["placement", "parameterised"]
+EVENTS = 200
+
+MACRO = """\
+/control/verbose 0
+/run/verbose 0
+/B2a/checkOverlaps false
+/B2a/chamberMode {mode}
+/B2a/nbOfChambers {count}
+/B2a/chamberSpacing 4 cm
+/B2a/chamberWidth 2 cm
+/B2a/firstChamberRadius 50 cm
+/B2a/lastChamberRadius 100 cm
+/run/initialize
+/tracking/verbose 0
+/gps/particle geantino
+/gps/ene/mono 1 GeV
+/gps/pos/centre 0 0 -{start} cm
+/gps/direction 0 0 1
+/run/beamOn {events}
+"""
+
+LOOP_RE = re.compile(r"Event loop time:\s+([\d.eE+-]+) s")
+STORE_RE = re.compile(r"Geometry store:\s+(\d+) logical, (\d+) physical")
+
+
+def run(executable: str, mode: str, count: int, workdir: Path) -> dict:
+    """Run one configuration and return its measurements."""
+    macro = workdir / f"{mode}_{count}.mac"
+    # Start in front of the target, which sits before the first chamber
+    macro.write_text(MACRO.format(mode=mode, count=count, start=(count + 1) * 2 + 10,
+                                  events=EVENTS))
+    log = workdir / f"{mode}_{count}.log"
+
+    with open(log, "w") as out:
+        start = time.perf_counter()
+        proc = subprocess.Popen([executable, str(macro)], stdout=out, stderr=subprocess.STDOUT)
+        # wait4 gives the resource usage of this child only
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+    if status != 0:
+        raise RuntimeError(f"{executable} {macro} failed, see {log}")
+
+    output = log.read_text()
+    loop = LOOP_RE.findall(output)
+    store = STORE_RE.search(output)
+    if not loop or not store:
+        raise RuntimeError(f"Could not parse {log}")
+
+    loop_time = float(loop[-1])
+    return {
+        "setup": wall - loop_time,
+        "rss": usage.ru_maxrss / 1024.0,  # kB on Linux
+        "logical": int(store.group(1)),
+        "physical": int(store.group(2)),
+        "crossing": loop_time / (EVENTS * count) * 1e9,
+    }
+
+
+def main() -> int:
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    executable = sys.argv[1]
+    counts = [int(c) for c in sys.argv[2:]] or COUNTS
+
+    print(f"| {'chambers':>8} | {'mode':13} | {'setup [s]':>9} | {'peak RSS [MB]':>13} | "
+          f"{'LV':>6} | {'PV':>6} | {'ns/crossing':>11} |")
+    print(f"|{'-' * 10}|{'-' * 15}|{'-' * 11}|{'-' * 15}|{'-' * 8}|{'-' * 8}|{'-' * 13}|")
+    with tempfile.TemporaryDirectory() as tmp:
+        for count in counts:
+            for mode in MODES:
+                r = run(executable, mode, count, Path(tmp))
+                print(f"| {count:8d} | {mode:13} | {r['setup']:9.2f} | {r['rss']:13.1f} | "
+                      f"{r['logical']:6d} | {r['physical']:6d} | {r['crossing']:11.1f} |")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+// ********************************************************************
+// * B2a Field Map Microbenchmark
+// ********************************************************************
+//
+// Usage: fieldBenchmark <field map> [evaluations]
+//
+// Times FieldMap lookups on two access patterns: points along straight
+// tracks with 1 mm steps (as the integrator sees them) and uniformly random
+// points. Each pattern is run through the cached lookup and through the
+// uncached reference, and the evaluations per second are printed.
+//
+
+#include "FieldMap.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Point { G4double x[4]; };
+
+// Sum of the results, printed so that the loop is not optimised away
+template <typename Lookup>
+G4double Time(const std::vector<Point>& points, Lookup lookup, G4double& checksum)
+{
+    G4double field[3];
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& p : points) {
+        lookup(p.x, field);
+        checksum += field[0] + field[1] + field[2];
+    }
+    std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - start;
+    return points.size() / elapsed.count();
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        G4cerr << "Usage: fieldBenchmark <field map> [evaluations]" << G4endl;
+        return 1;
+    }
+    std::size_t nofPoints = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+    B2a::FieldMap fieldMap(argv[1]);
+
+    // Points inside +-1 m, within the grid written by make_field_map.py
+    std::mt19937_64 engine(12345);
+    std::uniform_real_distribution<G4double> uniform(-1.*m, 1.*m);
+    std::uniform_real_distribution<G4double> unit(-1., 1.);
+
+    std::vector<Point> tracks(nofPoints);
+    G4double pos[3] = {0., 0., 0.};
+    G4double dir[3] = {0., 0., 1.};
+    for (std::size_t i = 0; i < nofPoints; i++) {
+        // New track every 1000 steps
+        if (i % 1000 == 0) {
+            for (G4int a = 0; a < 3; a++) {
+                pos[a] = uniform(engine);
+                dir[a] = unit(engine);
+            }
+            G4double norm = std::sqrt(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+            for (G4int a = 0; a < 3; a++) dir[a] /= norm;
+        }
+        for (G4int a = 0; a < 3; a++) {
+            pos[a] += 1.*mm * dir[a];
+            tracks[i].x[a] = pos[a];
+        }
+        tracks[i].x[3] = 0.;
+    }
+
+    std::vector<Point> random(nofPoints);
+    for (auto& p : random) {
+        for (G4int a = 0; a < 3; a++) p.x[a] = uniform(engine);
+        p.x[3] = 0.;
+    }
+
+    auto cached = [&](const G4double* x, G4double* b) { fieldMap.GetFieldValue(x, b); };
+    auto direct = [&](const G4double* x, G4double* b) { fieldMap.GetFieldValueDirect(x, b); };
+
+    G4double checksum = 0.;
+    G4cout << "| pattern | lookup   | evaluations/s |" << G4endl;
+    G4cout << "|---------|----------|---------------|" << G4endl;
+    G4cout << "| tracks  | cached   | " << Time(tracks, cached, checksum) << " |" << G4endl;
+    G4cout << "| tracks  | uncached | " << Time(tracks, direct, checksum) << " |" << G4endl;
+    G4cout << "| random  | cached   | " << Time(random, cached, checksum) << " |" << G4endl;
+    G4cout << "| random  | uncached | " << Time(random, direct, checksum) << " |" << G4endl;
+    G4cout << "(checksum " << checksum/tesla << ")" << G4endl;
+
+    return 0;
+}
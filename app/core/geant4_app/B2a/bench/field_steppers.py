@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+End-to-end events/s of the B2a tracker for each field integration stepper.
+
+Usage: field_steppers.py <exampleB2a executable> [field map] [stepper ...]
+
+Without a map the tracker runs in a uniform 1 T field along x; with a map
+(see make_field_map.py) the map is used. The same 3 GeV proton beam and
+seeds are used for every stepper.
+"""
+
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+STEPPERS = ["ClassicalRK4", "CashKarpRKF45", "BogackiShampine23", "DormandPrince745",
+            "TsitourasRK45", "NystromRK4", "HelixSimpleRunge", "ExactHelix"]
+
+MACRO = """\
+/control/verbose 0
+/run/verbose 0
+{field}
+/B2a/field/stepper {stepper}
+/run/initialize
+/gps/particle proton
+/gps/ene/mono 3 GeV
+/gps/pos/centre 0 0 -250 cm
+/gps/direction 0 0 1
+/random/setSeeds 12345 67890
+/run/beamOn 500
+"""
+
+RATE_RE = re.compile(r"\(([\d.eE+-]+) events/s\)")
+HITS_RE = re.compile(r"Hits: (\d+) \| Total Edep: ([\d.eE+-]+) keV")
+
+
+def main() -> int:
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    executable = sys.argv[1]
+    field_map = sys.argv[2] if len(sys.argv) > 2 else None
+    steppers = sys.argv[3:] or STEPPERS
+    if field_map:
+        field = f"/B2a/field/map {Path(field_map).resolve()}"
+        steppers = [s for s in steppers if s != "ExactHelix"]
+    else:
+        field = "/B2a/field/uniform 1 0 0 tesla"
+
+    print(f"| {'stepper':18} | {'events/s':>10} | {'hits':>8} | {'edep [MeV]':>10} |")
+    print(f"|{'-' * 20}|{'-' * 12}|{'-' * 10}|{'-' * 12}|")
+    with tempfile.TemporaryDirectory() as tmp:
+        for stepper in steppers:
+            macro = Path(tmp) / f"{stepper}.mac"
+            macro.write_text(MACRO.format(field=field, stepper=stepper))
+            output = subprocess.run([executable, str(macro)], capture_output=True,
+                                    text=True, check=True).stdout
+            rate = RATE_RE.search(output)
+            totals = HITS_RE.findall(output)
+            if not rate or not totals:
+                raise RuntimeError(f"Could not parse output for {stepper}")
+            hits, edep = totals[-1]
+            print(f"| {stepper:18} | {float(rate.group(1)):10.1f} | {int(hits):8d} | "
+                  f"{float(edep) / 1000:10.2f} |")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""
+Write a synthetic solenoid field map in the FieldMap binary format.
+
+Usage: make_field_map.py <output file> [B0 tesla] [spacing mm]
+
+The grid spans +-1 m in x and y and +-3 m in z. Inside a radius of 0.8 m the
+field is axial with strength B0 and falls off smoothly past |z| = 2 m; a
+radial component keeps the field roughly divergence free at the ends.
+"""
+
+import math
+import struct
+import sys
+from array import array
+
+HALF = (1000.0, 1000.0, 3000.0)  # mm
+RADIUS = 800.0
+LENGTH = 2000.0
+
+
+def field(x: float, y: float, z: float, b0: float) -> tuple:
+    r = math.hypot(x, y)
+    radial = 1.0 / (1.0 + math.exp((r - RADIUS) / 50.0))
+    axial = 1.0 / (1.0 + (z / LENGTH) ** 8)
+    bz = b0 * radial * axial
+    # d(axial)/dz, so that div B ~ 0 near the axis: Br = -r/2 dBz/dz
+    daxial = -8.0 * z ** 7 / LENGTH ** 8 * axial ** 2
+    br = -0.5 * r * b0 * radial * daxial
+    if r > 0.0:
+        return br * x / r, br * y / r, bz
+    return 0.0, 0.0, bz
+
+
+def main() -> int:
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    b0 = float(sys.argv[2]) if len(sys.argv) > 2 else 1.0
+    spacing = float(sys.argv[3]) if len(sys.argv) > 3 else 20.0
+
+    n = [int(round(2 * h / spacing)) + 1 for h in HALF]
+    with open(sys.argv[1], "wb") as out:
+        out.write(struct.pack("<3i", *n))
+        out.write(struct.pack("<3d", *(-h for h in HALF)))
+        out.write(struct.pack("<3d", *HALF))
+        for k in range(n[2]):
+            z = -HALF[2] + k * spacing
+            plane = array("f")
+            for j in range(n[1]):
+                y = -HALF[1] + j * spacing
+                for i in range(n[0]):
+                    plane.extend(field(-HALF[0] + i * spacing, y, z, b0))
+            if sys.byteorder != "little":
+                plane.byteswap()
+            plane.tofile(out)
+
+    print(f"{sys.argv[1]}: {n[0]}x{n[1]}x{n[2]} points, B0 = {b0} T")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
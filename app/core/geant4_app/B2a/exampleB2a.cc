@@ -11,6 +11,7 @@
 
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "GeometryScan.hh"
 
 #include "G4RunManagerFactory.hh"
 #include "G4SteppingVerbose.hh"
@@ -40,7 +41,11 @@ int main(int argc, char** argv)
     auto runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
 
     // Set mandatory initialization classes
-    runManager->SetUserInitialization(new B2a::DetectorConstruction());
+    auto detector = new B2a::DetectorConstruction();
+    runManager->SetUserInitialization(detector);
+
+    // Geometry variant scans (/B2a/scan/...)
+    auto geometryScan = new B2a::GeometryScan(detector);
 
     // Physics list
     G4VModularPhysicsList* physicsList = new FTFP_BERT;
@@ -82,6 +87,7 @@ int main(int argc, char** argv)
 
     // Job termination
     delete visManager;
+    delete geometryScan;
     delete runManager;
 
     return 0;
@@ -0,0 +1,72 @@
+// ********************************************************************
+// * B2a Chamber Parameterisation Header
+// * Based on: https://github.com/Geant4/geant4/tree/master/examples/basic/B2/B2b
+// ********************************************************************
+
+#ifndef B2aChamberParameterisation_h
+#define B2aChamberParameterisation_h 1
+
+#include "G4VPVParameterisation.hh"
+#include "globals.hh"
+
+class G4VPhysicalVolume;
+class G4Box;
+
+// Dummy declarations to get rid of warnings ...
+class G4Trd;
+class G4Trap;
+class G4Cons;
+class G4Orb;
+class G4Sphere;
+class G4Ellipsoid;
+class G4Torus;
+class G4Para;
+class G4Hype;
+class G4Tubs;
+class G4Polycone;
+class G4Polyhedra;
+
+namespace B2a
+{
+
+// Tracker chambers as one parameterised volume: equally spaced along z,
+// with the outer radius growing linearly from the first to the last chamber
+
+class ChamberParameterisation : public G4VPVParameterisation
+{
+  public:
+    ChamberParameterisation(G4int nbOfChambers, G4double startZ, G4double spacing,
+                            G4double widthChamber, G4double rmaxFirst, G4double rmaxLast);
+    ~ChamberParameterisation() override = default;
+
+    void ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const override;
+
+    void ComputeDimensions(G4Tubs& trackerChamber, const G4int copyNo,
+                           const G4VPhysicalVolume* physVol) const override;
+
+  private:
+    // Dummy declarations to get rid of warnings ...
+    void ComputeDimensions(G4Trd&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Trap&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Cons&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Sphere&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Orb&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Ellipsoid&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Torus&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Para&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Hype&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Box&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Polycone&, const G4int, const G4VPhysicalVolume*) const override {}
+    void ComputeDimensions(G4Polyhedra&, const G4int, const G4VPhysicalVolume*) const override {}
+
+    G4int fNbOfChambers = 0;
+    G4double fStartZ = 0.;
+    G4double fHalfWidth = 0.;
+    G4double fSpacing = 0.;
+    G4double fRmaxFirst = 0.;
+    G4double fRmaxIncr = 0.;
+};
+
+}
+
+#endif
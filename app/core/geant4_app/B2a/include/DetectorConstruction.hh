@@ -7,10 +7,17 @@
 #define B2aDetectorConstruction_h 1
 
 #include "G4VUserDetectorConstruction.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4VPhysicalVolume;
 class G4LogicalVolume;
+class G4VPVParameterisation;
+class G4Mag_UsualEqRhs;
+class G4MagIntegratorStepper;
 class G4Material;
 class G4UserLimits;
 class G4GenericMessenger;
@@ -19,6 +26,7 @@ namespace B2a
 {
 
 class DetectorMessenger;
+class FieldMap;
 
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -35,23 +43,72 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     void SetMaxStep(G4double);
     void SetCheckOverlaps(G4bool);
 
+    // Target and tracker layout (before /run/initialize)
+    void SetTargetLength(G4double);
+    void SetNbOfChambers(G4int);
+    void SetChamberSpacing(G4double);
+    void SetChamberWidth(G4double);
+    void SetFirstChamberRadius(G4double);
+    void SetLastChamberRadius(G4double);
+    void SetChamberMode(G4String);
+
+    // Magnetic field (before /run/initialize); a map takes precedence over
+    // the uniform value
+    void SetFieldMap(G4String fileName) { fFieldMapFile = fileName; }
+    void SetStepper(G4String name) { fStepperName = name; }
+
+    // Applies a geometry variant between runs, rebuilding only the volumes
+    // that change and re-optimising only their mothers
+    void UpdateGeometry(G4String targetMaterial, G4double targetLength, G4int nbOfChambers);
+
     // Get methods
     const G4VPhysicalVolume* GetTargetPV() const { return fTargetPV; }
     const G4VPhysicalVolume* GetChamberPV() const { return fChamberPV; }
 
   private:
+    // Dimensions derived from the target length and the chamber settings
+    struct Layout
+    {
+        G4double trackerLength;
+        G4double trackerRadius;
+        G4double worldLength;
+        G4double rmaxFirst;
+        G4double rmaxLast;
+        G4double firstPosition;
+        G4ThreeVector targetPosition;
+    };
+
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    Layout ComputeLayout() const;
+    void PlaceChambers(const Layout& layout);
+    void ParameteriseChambers(const Layout& layout);
+    void ReoptimiseVoxels(G4LogicalVolume* mother);
+    void ConstructField();
+    G4MagIntegratorStepper* CreateStepper(G4Mag_UsualEqRhs* equation) const;
 
     G4GenericMessenger* fMessenger = nullptr;
+    G4GenericMessenger* fFieldMessenger = nullptr;
     
+    G4double fTargetLength = 5*CLHEP::cm;
     G4int fNbOfChambers = 5;
-
+    G4double fChamberSpacing = 80*CLHEP::cm;
+    G4double fChamberWidth = 20*CLHEP::cm;
+    // Zero: derived from the tracker length as in the original B2a layout
+    G4double fFirstChamberRadius = 0.;
+    G4double fLastChamberRadius = 0.;
+    // One G4PVPlacement per chamber, or a single G4PVParameterised
+    G4bool fParameterisedChambers = false;
+
+    G4LogicalVolume* fLogicWorld = nullptr;
     G4LogicalVolume* fLogicTarget = nullptr;
-    G4LogicalVolume* fLogicChamber = nullptr;
+    G4LogicalVolume* fLogicTracker = nullptr;
+    // One per chamber in placement mode, a single one when parameterised
+    std::vector<G4LogicalVolume*> fLogicChambers;
 
     G4VPhysicalVolume* fTargetPV = nullptr;
     G4VPhysicalVolume* fChamberPV = nullptr;
+    G4VPVParameterisation* fChamberParam = nullptr;
 
     G4Material* fTargetMaterial = nullptr;
     G4Material* fChamberMaterial = nullptr;
@@ -59,6 +116,17 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     G4UserLimits* fStepLimit = nullptr;
 
     G4bool fCheckOverlaps = true;
+
+    // Field settings; the map is loaded once on the master and copied per thread
+    G4ThreeVector fUniformField;
+    G4String fFieldMapFile;
+    FieldMap* fFieldMap = nullptr;
+    G4String fStepperName = "DormandPrince745";
+    G4double fMinStep = 0.01*CLHEP::mm;
+    G4double fDeltaChord = 0.25*CLHEP::mm;
+    G4double fDeltaOneStep = 0.01*CLHEP::mm;
+    G4double fEpsilonMin = 5.0e-5;
+    G4double fEpsilonMax = 1.0e-3;
 };
 
 }
@@ -6,19 +6,45 @@
 #define B2aEventAction_h 1
 
 #include "G4UserEventAction.hh"
+#include "TrackFitter.hh"
+#include "TrackerHit.hh"
 #include "globals.hh"
 
+#include <utility>
+#include <vector>
+
 namespace B2a
 {
 
+class RunAction;
+class TrackerSD;
+
 class EventAction : public G4UserEventAction
 {
   public:
-    EventAction() = default;
+    EventAction(RunAction* runAction) : fRunAction(runAction) {}
     ~EventAction() override = default;
 
     void BeginOfEventAction(const G4Event*) override;
     void EndOfEventAction(const G4Event*) override;
+
+  private:
+    // End-of-event reconstruction: one energy-weighted cluster per chamber,
+    // then a line or helix fit through the clusters
+    void Reconstruct(const G4Event* event, TrackerHitsCollection* hits);
+
+    RunAction* fRunAction = nullptr;
+    G4int fHCID = -1;
+    TrackerSD* fTrackerSD = nullptr;
+    // Summed deposit per chamber, reused between events
+    std::vector<G4double> fChamberEdep;
+
+    TrackFitter fFitter;
+    TrackFit fFit;
+    // Reused between events: (chamber, hit index), cluster chambers and points
+    std::vector<std::pair<G4int, G4int>> fHitOrder;
+    std::vector<G4int> fChambers;
+    std::vector<G4ThreeVector> fClusters;
 };
 
 }
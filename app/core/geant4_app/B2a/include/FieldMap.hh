@@ -0,0 +1,79 @@
+// ********************************************************************
+// * B2a Field Map Header
+// ********************************************************************
+
+#ifndef B2aFieldMap_h
+#define B2aFieldMap_h 1
+
+#include "G4MagneticField.hh"
+#include "globals.hh"
+
+#include <memory>
+#include <vector>
+
+namespace B2a
+{
+
+// Magnetic field from a regular 3D grid, interpolated trilinearly.
+//
+// Binary file (little endian):
+//   int32   nx, ny, nz              grid points per axis (>= 2)
+//   float64 xmin, ymin, zmin        first grid point [mm]
+//   float64 xmax, ymax, zmax        last grid point [mm]
+//   float32 Bx, By, Bz [tesla]      nx*ny*nz points, x fastest
+//
+// The grid is stored in blocks of kBlockCells^3 cells that also hold the
+// points on their upper faces, so the 8 corners of any cell are in one
+// contiguous block. The corners of the last cell are kept, and points of a
+// track that stay in that cell only recompute the weights.
+//
+// The grid is loaded once and shared; each thread uses its own copy of this
+// object (see the copy constructor) for the cell cache.
+
+class FieldMap : public G4MagneticField
+{
+  public:
+    FieldMap(const G4String& fileName);
+    FieldMap(const FieldMap& other);
+    ~FieldMap() override = default;
+
+    void GetFieldValue(const G4double point[4], G4double* field) const override;
+
+    // Same interpolation without the cell cache, for validation and benchmarks
+    void GetFieldValueDirect(const G4double point[4], G4double* field) const;
+
+    // Field of grid point (ix, iy, iz) in Geant4 units
+    void GetGridValue(G4int ix, G4int iy, G4int iz, G4double* field) const;
+
+  private:
+    static constexpr G4int kBlockCells = 4;
+    static constexpr G4int kBlockPoints = kBlockCells + 1;
+    static constexpr G4int kBlockSize = 3 * kBlockPoints * kBlockPoints * kBlockPoints;
+
+    struct Grid
+    {
+        G4int n[3];
+        G4double min[3];
+        G4double step[3];
+        G4int nBlocks[3];
+        std::vector<float> blocks;   // kBlockSize floats per block, in tesla
+    };
+
+    void Load(const G4String& fileName, Grid& grid) const;
+    // Grid point (ix, iy, iz) within the block of cell (cx, cy, cz)
+    const float* BlockPoint(G4int cx, G4int cy, G4int cz, G4int ix, G4int iy, G4int iz) const;
+    // Lower corner of the cell containing a point; false outside the grid
+    G4bool FindCell(const G4double point[4], G4int* cell, G4double* frac) const;
+    void FetchCorners(const G4int* cell, G4double corners[8][3]) const;
+    static void Interpolate(const G4double corners[8][3], const G4double* frac, G4double* field);
+
+    std::shared_ptr<const Grid> fGrid;
+
+    // Last cell looked up: lower corner indices and corner fields
+    mutable G4int fCell[3] = {-1, -1, -1};
+    mutable G4double fCorners[8][3];
+};
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+// ********************************************************************
+// * B2a Geometry Scan Header
+// ********************************************************************
+
+#ifndef B2aGeometryScan_h
+#define B2aGeometryScan_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B2a
+{
+
+class DetectorConstruction;
+
+// Runs a list of geometry variants in one process. Each variant is applied
+// with DetectorConstruction::UpdateGeometry, so only what changed is rebuilt,
+// and writes its run summary to <outputDir>/<variant name>.
+//
+// Variants file, one per line ('#' starts a comment):
+//   <name> <target material> <target length [cm]> <number of chambers>
+
+class GeometryScan
+{
+  public:
+    GeometryScan(DetectorConstruction* detector);
+    ~GeometryScan();
+
+    void LoadVariants(G4String fileName);
+    void SetOutputDirectory(G4String dir) { fOutputDirectory = dir; }
+    void BeamOn(G4int nofEvents);
+
+  private:
+    struct Variant
+    {
+        G4String name;
+        G4String targetMaterial;
+        G4double targetLength;
+        G4int nbOfChambers;
+    };
+
+    DetectorConstruction* fDetector = nullptr;
+    G4GenericMessenger* fMessenger = nullptr;
+
+    std::vector<Variant> fVariants;
+    G4String fOutputDirectory = "scan";
+};
+
+}
+
+#endif
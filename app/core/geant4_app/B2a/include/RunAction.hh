@@ -6,9 +6,15 @@
 #define B2aRunAction_h 1
 
 #include "G4UserRunAction.hh"
+#include "G4Accumulable.hh"
+#include "G4Timer.hh"
+#include "G4SystemOfUnits.hh"
+#include "EventTrigger.hh"
+#include "LogSink.hh"
 #include "globals.hh"
 
 class G4Run;
+class G4GenericMessenger;
 
 namespace B2a
 {
@@ -16,11 +22,55 @@ namespace B2a
 class RunAction : public G4UserRunAction
 {
   public:
-    RunAction() = default;
-    ~RunAction() override = default;
+    RunAction();
+    ~RunAction() override;
 
     void BeginOfRunAction(const G4Run*) override;
     void EndOfRunAction(const G4Run*) override;
+
+    void AddEvent(G4int nofHits, G4double edep);
+    void AddFitAttempt(G4double fitTime);
+    void AddTrack(G4double chi2, G4int ndf);
+
+    // End-of-event selection (/B2a/trigger/); run totals count every event,
+    // the printout and the reconstruction only accepted ones
+    EventTrigger& GetTrigger() { return fTrigger; }
+    void CountAccepted() { fNofAccepted += 1; }
+
+    // Track reconstruction settings (/B2a/reco/)
+    G4bool IsRecoEnabled() const { return fRecoEnabled; }
+    G4double GetRecoResolution() const { return fRecoResolution; }
+    G4int GetRecoMinChambers() const { return fRecoMinChambers; }
+
+    // Buffered, rate-limited log of this thread's event loop (/B2a/log/)
+    LogSink* GetLog() { return &fLog; }
+
+    // The master writes run_summary.txt there at the end of each run;
+    // empty (the default) writes nothing
+    static void SetOutputDirectory(const G4String& dir) { fgOutputDirectory = dir; }
+
+  private:
+    void WriteSummary(const G4Run* run, G4double elapsed) const;
+
+    G4Timer fTimer;
+    G4Accumulable<G4int> fNofHits = 0;
+    G4Accumulable<G4double> fEdep = 0.;
+
+    EventTrigger fTrigger;
+    G4Accumulable<G4int> fNofAccepted = 0;
+
+    LogSink fLog{"/B2a/log/"};
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fRecoEnabled = false;
+    G4double fRecoResolution = 0.1*CLHEP::mm;
+    G4int fRecoMinChambers = 3;
+    G4Accumulable<G4int> fNofFits = 0;
+    G4Accumulable<G4int> fNofTracks = 0;
+    G4Accumulable<G4double> fChi2PerNdf = 0.;
+    G4Accumulable<G4double> fFitTime = 0.;
+
+    static G4String fgOutputDirectory;
 };
 
 }
@@ -0,0 +1,72 @@
+// ********************************************************************
+// * B2a Track Fitter Header
+// ********************************************************************
+
+#ifndef B2aTrackFitter_h
+#define B2aTrackFitter_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+namespace B2a
+{
+
+// Result of one track fit. Line: params = {x0, y0, tx, ty} at z = z0 with
+// x = x0 + tx*(z - z0). Helix: coordinates (u, v) span the bending plane and
+// w runs along the field; params = {uc, vc, R, w0, tanLambda} with the circle
+// centre, its radius and w = w0 + tanLambda * (arc length from the first point).
+
+struct TrackFit
+{
+    G4bool helix = false;
+    G4int nofPoints = 0;
+    G4double z0 = 0.;
+    G4double params[5] = {0., 0., 0., 0., 0.};
+    G4double chi2 = 0.;
+    G4int ndf = 0;
+    G4double pT = 0.;      // helix only, unit charge
+    // Two residuals per point: (x, y) for lines, (radial, w) for helices
+    std::vector<G4double> residuals;
+};
+
+// Least-squares fits of one track through points ordered along the beam.
+// Sums run over structure-of-arrays buffers in blocks of kLanes independent
+// accumulators so the compiler can vectorise them without reassociating.
+
+class TrackFitter
+{
+  public:
+    TrackFitter() = default;
+    ~TrackFitter() = default;
+
+    // Point resolution in both measured coordinates
+    void SetResolution(G4double sigma) { fSigma = sigma; }
+    // Uniform field used for helix fits; zero selects straight lines
+    void SetField(const G4ThreeVector& field);
+
+    // Needs 3 points or more; returns false if the fit is not possible
+    G4bool Fit(const std::vector<G4ThreeVector>& points, TrackFit& fit);
+
+  private:
+    static constexpr G4int kLanes = 4;
+
+    G4bool FitLine(TrackFit& fit);
+    G4bool FitHelix(TrackFit& fit);
+    // Straight line y = a + b*x: returns false if degenerate
+    G4bool LinearFit(const std::vector<G4double>& x, const std::vector<G4double>& y,
+                     G4double& a, G4double& b) const;
+
+    G4double fSigma = 0.1*CLHEP::mm;
+    G4double fField = 0.;
+    // Orthonormal frame with fW along the field
+    G4ThreeVector fU, fV, fW;
+
+    // Scratch buffers, reused between events
+    std::vector<G4double> fA, fB, fC, fS;
+};
+
+}
+
+#endif
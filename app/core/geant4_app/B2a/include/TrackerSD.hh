@@ -8,6 +8,7 @@
 
 #include "G4VSensitiveDetector.hh"
 #include "TrackerHit.hh"
+#include "LogSink.hh"
 
 class G4Step;
 class G4HCofThisEvent;
@@ -24,7 +25,10 @@ class TrackerSD : public G4VSensitiveDetector
     // Methods from base class
     void   Initialize(G4HCofThisEvent* hitCollection) override;
     G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
-    void   EndOfEvent(G4HCofThisEvent* hitCollection) override;
+
+    // Event summary record (and hit details above verbose 1), written by
+    // the event action for events accepted by the trigger
+    void   PrintEvent(G4int eventID, LogSink* log) const;
 
   private:
     TrackerHitsCollection* fHitsCollection = nullptr;
@@ -23,9 +23,11 @@ void ActionInitialization::BuildForMaster() const
 void ActionInitialization::Build() const
 {
     SetUserAction(new PrimaryGeneratorAction);
-    SetUserAction(new RunAction);
+
+    auto runAction = new RunAction;
+    SetUserAction(runAction);
     
-    auto eventAction = new EventAction;
+    auto eventAction = new EventAction(runAction);
     SetUserAction(eventAction);
     
     SetUserAction(new SteppingAction(eventAction));
@@ -0,0 +1,62 @@
+// ********************************************************************
+// * B2a Chamber Parameterisation Implementation
+// * Based on: https://github.com/Geant4/geant4/tree/master/examples/basic/B2/B2b
+// ********************************************************************
+
+#include "ChamberParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4ThreeVector.hh"
+#include "G4Tubs.hh"
+#include "G4SystemOfUnits.hh"
+
+namespace B2a
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ChamberParameterisation::ChamberParameterisation(G4int nbOfChambers, G4double startZ,
+                                                 G4double spacing, G4double widthChamber,
+                                                 G4double rmaxFirst, G4double rmaxLast)
+ : fNbOfChambers(nbOfChambers),
+   fStartZ(startZ),
+   fHalfWidth(0.5*widthChamber),
+   fSpacing(spacing),
+   fRmaxFirst(rmaxFirst)
+{
+    if (nbOfChambers > 1) {
+        fRmaxIncr = (rmaxLast - rmaxFirst) / (nbOfChambers - 1);
+        if (spacing < widthChamber) {
+            G4Exception("ChamberParameterisation::ChamberParameterisation()",
+                        "InvalidSetup", FatalException,
+                        "Width>Spacing");
+        }
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ChamberParameterisation::ComputeTransformation(const G4int copyNo,
+                                                    G4VPhysicalVolume* physVol) const
+{
+    // Note: copyNo will start with zero!
+    G4double Zposition = fStartZ + copyNo * fSpacing;
+    physVol->SetTranslation(G4ThreeVector(0, 0, Zposition));
+    physVol->SetRotation(nullptr);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ChamberParameterisation::ComputeDimensions(G4Tubs& trackerChamber, const G4int copyNo,
+                                                const G4VPhysicalVolume*) const
+{
+    // Note: copyNo will start with zero!
+    G4double rmax = fRmaxFirst + copyNo * fRmaxIncr;
+    trackerChamber.SetInnerRadius(0);
+    trackerChamber.SetOuterRadius(rmax);
+    trackerChamber.SetZHalfLength(fHalfWidth);
+    trackerChamber.SetStartPhiAngle(0.*deg);
+    trackerChamber.SetDeltaPhiAngle(360.*deg);
+}
+
+}
@@ -5,6 +5,8 @@
 
 #include "DetectorConstruction.hh"
 #include "DetectorMessenger.hh"
+#include "ChamberParameterisation.hh"
+#include "FieldMap.hh"
 #include "TrackerSD.hh"
 
 #include "G4Material.hh"
@@ -16,11 +18,31 @@
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
-#include "G4GlobalMagFieldMessenger.hh"
+#include "G4PVParameterised.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
 #include "G4AutoDelete.hh"
 
+#include "G4UniformMagField.hh"
+#include "G4FieldManager.hh"
+#include "G4TransportationManager.hh"
+#include "G4Mag_UsualEqRhs.hh"
+#include "G4ChordFinder.hh"
+#include "G4ClassicalRK4.hh"
+#include "G4CashKarpRKF45.hh"
+#include "G4DormandPrince745.hh"
+#include "G4BogackiShampine23.hh"
+#include "G4TsitourasRK45.hh"
+#include "G4NystromRK4.hh"
+#include "G4HelixExplicitEuler.hh"
+#include "G4HelixSimpleRunge.hh"
+#include "G4ExactHelixStepper.hh"
+
 #include "G4GeometryTolerance.hh"
 #include "G4GeometryManager.hh"
+#include "G4SmartVoxelHeader.hh"
+#include "voxeldefs.hh"
+#include "G4RunManager.hh"
 
 #include "G4UserLimits.hh"
 
@@ -31,6 +53,8 @@
 
 #include "G4GenericMessenger.hh"
 
+#include <algorithm>
+
 namespace B2a
 {
 
@@ -51,6 +75,95 @@ DetectorConstruction::DetectorConstruction()
         .SetParameterName("choice", false)
         .SetStates(G4State_PreInit, G4State_Idle);
 
+    fMessenger->DeclareMethodWithUnit("targetLength", "cm", &DetectorConstruction::SetTargetLength)
+        .SetGuidance("Target thickness along z.")
+        .SetParameterName("length", false)
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethod("nbOfChambers", &DetectorConstruction::SetNbOfChambers)
+        .SetGuidance("Number of tracker chambers.")
+        .SetParameterName("n", false)
+        .SetRange("n>0")
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethodWithUnit("chamberSpacing", "cm", &DetectorConstruction::SetChamberSpacing)
+        .SetGuidance("Distance between the centres of consecutive chambers.")
+        .SetParameterName("spacing", false)
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethodWithUnit("chamberWidth", "cm", &DetectorConstruction::SetChamberWidth)
+        .SetGuidance("Chamber thickness along z (must not exceed the spacing).")
+        .SetParameterName("width", false)
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethodWithUnit("firstChamberRadius", "cm", &DetectorConstruction::SetFirstChamberRadius)
+        .SetGuidance("Outer radius of the first chamber; radii grow linearly to the last one.")
+        .SetGuidance("0 derives it from the tracker length.")
+        .SetParameterName("radius", false)
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethodWithUnit("lastChamberRadius", "cm", &DetectorConstruction::SetLastChamberRadius)
+        .SetGuidance("Outer radius of the last chamber.")
+        .SetGuidance("0 derives it from the tracker length.")
+        .SetParameterName("radius", false)
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethod("chamberMode", &DetectorConstruction::SetChamberMode)
+        .SetGuidance("placement: one physical volume per chamber.")
+        .SetGuidance("parameterised: a single G4PVParameterised for all chambers.")
+        .SetParameterName("mode", false)
+        .SetCandidates("placement parameterised")
+        .SetStates(G4State_PreInit);
+
+    fMessenger->DeclareMethod("checkOverlaps", &DetectorConstruction::SetCheckOverlaps)
+        .SetGuidance("Check volume overlaps while building the geometry.")
+        .SetParameterName("check", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger = new G4GenericMessenger(this, "/B2a/field/", "Magnetic field control");
+
+    fFieldMessenger->DeclarePropertyWithUnit("uniform", "tesla", fUniformField)
+        .SetGuidance("Uniform magnetic field over the whole setup.")
+        .SetParameterName("B", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclareMethod("map", &DetectorConstruction::SetFieldMap)
+        .SetGuidance("Binary 3D field map (see FieldMap.hh); overrides the uniform field.")
+        .SetParameterName("file", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclareMethod("stepper", &DetectorConstruction::SetStepper)
+        .SetGuidance("Integration stepper.")
+        .SetParameterName("name", false)
+        .SetCandidates("ClassicalRK4 CashKarpRKF45 DormandPrince745 BogackiShampine23 "
+                       "TsitourasRK45 NystromRK4 HelixExplicitEuler HelixSimpleRunge ExactHelix")
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclarePropertyWithUnit("minStep", "mm", fMinStep)
+        .SetGuidance("Minimum step of the chord finder.")
+        .SetParameterName("step", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclarePropertyWithUnit("deltaChord", "mm", fDeltaChord)
+        .SetGuidance("Maximum miss distance between chord and trajectory.")
+        .SetParameterName("delta", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclarePropertyWithUnit("deltaOneStep", "mm", fDeltaOneStep)
+        .SetGuidance("Position accuracy of one integration step.")
+        .SetParameterName("delta", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclareProperty("epsMin", fEpsilonMin)
+        .SetGuidance("Minimum relative integration accuracy.")
+        .SetParameterName("eps", false)
+        .SetStates(G4State_PreInit);
+
+    fFieldMessenger->DeclareProperty("epsMax", fEpsilonMax)
+        .SetGuidance("Maximum relative integration accuracy.")
+        .SetParameterName("eps", false)
+        .SetStates(G4State_PreInit);
+
     DefineMaterials();
 }
 
@@ -59,7 +172,9 @@ DetectorConstruction::DetectorConstruction()
 DetectorConstruction::~DetectorConstruction()
 {
     delete fMessenger;
+    delete fFieldMessenger;
     delete fStepLimit;
+    delete fFieldMap;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -86,6 +201,11 @@ void DetectorConstruction::DefineMaterials()
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    // Master only: threads share the grid through their FieldMap copies
+    if (!fFieldMapFile.empty() && !fFieldMap) {
+        fFieldMap = new FieldMap(fFieldMapFile);
+    }
+
     return DefineVolumes();
 }
 
@@ -96,34 +216,29 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
     G4Material* air = G4Material::GetMaterial("G4_AIR");
 
     // Sizes of the principal geometrical components
-    G4double chamberSpacing = 80*cm;
-    G4double chamberWidth = 20*cm;
-    G4double targetLength = 5*cm;
-    G4double trackerLength = (fNbOfChambers + 1) * chamberSpacing;
-
-    G4double worldLength = 1.2 * (2*targetLength + trackerLength);
-
-    G4double targetRadius = 0.5*targetLength;
-    G4double trackerSize = 0.5*trackerLength;
+    Layout layout = ComputeLayout();
+    G4double targetRadius = 2.5*cm;
+    G4double trackerSize = 0.5*layout.trackerLength;
 
     // Definitions of Solids, Logical Volumes, Physical Volumes
 
     // World
-    G4GeometryManager::GetInstance()->SetWorldMaximumExtent(worldLength);
+    G4GeometryManager::GetInstance()->SetWorldMaximumExtent(layout.worldLength);
 
     G4cout << G4endl << "Geometry parameters:" << G4endl;
-    G4cout << "  World extent: " << worldLength/m << " m" << G4endl;
-    G4cout << "  Target length: " << targetLength/cm << " cm" << G4endl;
-    G4cout << "  Tracker length: " << trackerLength/cm << " cm" << G4endl;
+    G4cout << "  World extent: " << layout.worldLength/m << " m" << G4endl;
+    G4cout << "  Target length: " << fTargetLength/cm << " cm" << G4endl;
+    G4cout << "  Tracker length: " << layout.trackerLength/cm << " cm" << G4endl;
     G4cout << "  Number of chambers: " << fNbOfChambers << G4endl;
 
-    G4Box* worldS = new G4Box("world", worldLength/2, worldLength/2, worldLength/2);
-    G4LogicalVolume* worldLV = new G4LogicalVolume(worldS, air, "World");
+    G4double worldSize = 0.5*layout.worldLength;
+    G4Box* worldS = new G4Box("world", worldSize, worldSize, worldSize);
+    fLogicWorld = new G4LogicalVolume(worldS, air, "World");
 
     G4VPhysicalVolume* worldPV = new G4PVPlacement(
         nullptr,           // no rotation
         G4ThreeVector(),   // at (0,0,0)
-        worldLV,           // its logical volume
+        fLogicWorld,       // its logical volume
         "World",           // its name
         nullptr,           // its mother volume
         false,             // no boolean operations
@@ -131,90 +246,165 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         fCheckOverlaps);   // checking overlaps
 
     // Target
-    G4ThreeVector positionTarget = G4ThreeVector(0, 0, -(targetLength + trackerLength)/2);
-
-    G4Tubs* targetS = new G4Tubs("target", 0., targetRadius, targetLength/2, 0.*deg, 360.*deg);
+    G4Tubs* targetS = new G4Tubs("target", 0., targetRadius, fTargetLength/2, 0.*deg, 360.*deg);
     fLogicTarget = new G4LogicalVolume(targetS, fTargetMaterial, "Target", nullptr, nullptr, nullptr);
     fTargetPV = new G4PVPlacement(
-        nullptr,           // no rotation
-        positionTarget,    // at (x,y,z)
-        fLogicTarget,      // its logical volume
-        "Target",          // its name
-        worldLV,           // its mother volume
-        false,             // no boolean operations
-        0,                 // copy number
-        fCheckOverlaps);   // checking overlaps
-
-    G4cout << "  Target positioned at z = " << positionTarget.z()/cm << " cm" << G4endl;
-
-    // Tracker (5 chambers)
+        nullptr,                  // no rotation
+        layout.targetPosition,    // at (x,y,z)
+        fLogicTarget,             // its logical volume
+        "Target",                 // its name
+        fLogicWorld,              // its mother volume
+        false,                    // no boolean operations
+        0,                        // copy number
+        fCheckOverlaps);          // checking overlaps
+
+    G4cout << "  Target positioned at z = " << layout.targetPosition.z()/cm << " cm" << G4endl;
+
+    // Tracker
     G4ThreeVector positionTracker = G4ThreeVector(0, 0, 0);
 
-    G4Tubs* trackerS = new G4Tubs("tracker", 0., trackerSize, trackerSize, 0.*deg, 360.*deg);
-    G4LogicalVolume* trackerLV = new G4LogicalVolume(trackerS, air, "Tracker", nullptr, nullptr, nullptr);
+    G4Tubs* trackerS = new G4Tubs("tracker", 0., layout.trackerRadius, trackerSize, 0.*deg, 360.*deg);
+    fLogicTracker = new G4LogicalVolume(trackerS, air, "Tracker", nullptr, nullptr, nullptr);
     new G4PVPlacement(
         nullptr,           // no rotation
         positionTracker,   // at (x,y,z)
-        trackerLV,         // its logical volume
+        fLogicTracker,     // its logical volume
         "Tracker",         // its name
-        worldLV,           // its mother volume
+        fLogicWorld,       // its mother volume
         false,             // no boolean operations
         0,                 // copy number
         fCheckOverlaps);   // checking overlaps
 
     // Tracker chambers
-    G4double firstPosition = -trackerSize + chamberSpacing;
-    G4double firstLength = trackerLength/10;
-    G4double lastLength = trackerLength;
+    if (fChamberWidth > fChamberSpacing) {
+        G4Exception("DetectorConstruction::DefineVolumes()",
+                    "InvalidSetup", FatalException,
+                    "Width>Spacing");
+    }
+
+    fLogicChambers.clear();
+    if (fParameterisedChambers) {
+        ParameteriseChambers(layout);
+    }
+    else {
+        PlaceChambers(layout);
+    }
+
+    G4cout << "  Geometry store: " << G4LogicalVolumeStore::GetInstance()->size()
+           << " logical, " << G4PhysicalVolumeStore::GetInstance()->size()
+           << " physical volumes" << G4endl;
+
+    // Visualization attributes
+    fLogicWorld->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+    G4VisAttributes* boxVisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
+    G4VisAttributes* chamberVisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 0.0));
+    fLogicTarget->SetVisAttributes(boxVisAtt);
+    fLogicTracker->SetVisAttributes(boxVisAtt);
+
+    // Set step limit (the geometry is rebuilt when the chamber layout changes)
+    G4double maxStep = 0.5*fChamberWidth;
+    delete fStepLimit;
+    fStepLimit = new G4UserLimits(maxStep);
+
+    for (auto chamberLV : fLogicChambers) {
+        chamberLV->SetVisAttributes(chamberVisAtt);
+        chamberLV->SetUserLimits(fStepLimit);
+    }
+
+    return worldPV;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorConstruction::Layout DetectorConstruction::ComputeLayout() const
+{
+    Layout layout;
+    layout.trackerLength = (fNbOfChambers + 1) * fChamberSpacing;
+
+    layout.rmaxFirst = fFirstChamberRadius > 0. ? fFirstChamberRadius : layout.trackerLength/20;
+    layout.rmaxLast = fLastChamberRadius > 0. ? fLastChamberRadius : layout.trackerLength/2;
+
+    G4double trackerSize = 0.5*layout.trackerLength;
+    layout.trackerRadius = std::max(trackerSize, std::max(layout.rmaxFirst, layout.rmaxLast));
+    layout.worldLength = 1.2 * std::max(2*fTargetLength + layout.trackerLength, 2*layout.trackerRadius);
 
-    G4double halfWidth = 0.5*chamberWidth;
-    G4double rmaxFirst = 0.5 * firstLength;
+    layout.firstPosition = -trackerSize + fChamberSpacing;
+    layout.targetPosition = G4ThreeVector(0, 0, -(fTargetLength + layout.trackerLength)/2);
+    return layout;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DetectorConstruction::PlaceChambers(const Layout& layout)
+{
+    G4double rmaxFirst = layout.rmaxFirst;
+    G4double halfWidth = 0.5*fChamberWidth;
     G4double rmaxIncr = 0.;
-    if (fNbOfChambers > 0) {
-        rmaxIncr = 0.5 * (lastLength - firstLength) / (fNbOfChambers - 1);
-        if (chamberSpacing < chamberWidth) {
-            G4Exception("DetectorConstruction::DefineVolumes()",
-                        "InvalidSetup", FatalException,
-                        "Width>Spacing");
-        }
+    if (fNbOfChambers > 1) {
+        rmaxIncr = (layout.rmaxLast - rmaxFirst) / (fNbOfChambers - 1);
     }
 
+    // Geometry memory grows with the number of chambers: a solid, a logical
+    // and a physical volume each
     for (G4int copyNo = 0; copyNo < fNbOfChambers; copyNo++) {
-        G4double Zposition = firstPosition + copyNo * chamberSpacing;
+        G4double Zposition = layout.firstPosition + copyNo * fChamberSpacing;
         G4double rmax = rmaxFirst + copyNo * rmaxIncr;
 
         G4Tubs* chamberS = new G4Tubs("Chamber_solid", 0, rmax, halfWidth, 0.*deg, 360.*deg);
-        fLogicChamber = new G4LogicalVolume(chamberS, fChamberMaterial, "Chamber_LV", nullptr, nullptr, nullptr);
+        G4LogicalVolume* chamberLV = new G4LogicalVolume(chamberS, fChamberMaterial, "Chamber_LV", nullptr, nullptr, nullptr);
+        fLogicChambers.push_back(chamberLV);
 
         fChamberPV = new G4PVPlacement(
             nullptr,                              // no rotation
             G4ThreeVector(0, 0, Zposition),       // at (x,y,z)
-            fLogicChamber,                        // its logical volume
+            chamberLV,                            // its logical volume
             "Chamber_PV",                         // its name
-            trackerLV,                            // its mother volume
+            fLogicTracker,                        // its mother volume
             false,                                // no boolean operations
             copyNo,                               // copy number
             fCheckOverlaps);                      // checking overlaps
 
-        G4cout << "  Chamber " << copyNo << " at z = " << Zposition/cm << " cm, rmax = " << rmax/cm << " cm" << G4endl;
+        if (fNbOfChambers <= 20) {
+            G4cout << "  Chamber " << copyNo << " at z = " << Zposition/cm << " cm, rmax = " << rmax/cm << " cm" << G4endl;
+        }
     }
+    G4cout << "  Chambers: " << fNbOfChambers << " placements" << G4endl;
+}
 
-    // Visualization attributes
-    worldLV->SetVisAttributes(G4VisAttributes::GetInvisible());
-
-    G4VisAttributes* boxVisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0));
-    G4VisAttributes* chamberVisAtt = new G4VisAttributes(G4Colour(1.0, 1.0, 0.0));
-    fLogicTarget->SetVisAttributes(boxVisAtt);
-    trackerLV->SetVisAttributes(boxVisAtt);
-    fLogicChamber->SetVisAttributes(chamberVisAtt);
-
-    // Set step limit
-    G4double maxStep = 0.5*chamberWidth;
-    fStepLimit = new G4UserLimits(maxStep);
-    fLogicChamber->SetUserLimits(fStepLimit);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    return worldPV;
+void DetectorConstruction::ParameteriseChambers(const Layout& layout)
+{
+    // Dimensions of this solid are set per copy by the parameterisation.
+    // The logical volume is kept when only the chamber count changes.
+    if (fLogicChambers.empty()) {
+        G4Tubs* chamberS = new G4Tubs("Chamber_solid", 0, layout.rmaxFirst, 0.5*fChamberWidth, 0.*deg, 360.*deg);
+        fLogicChambers.push_back(new G4LogicalVolume(chamberS, fChamberMaterial, "Chamber_LV", nullptr, nullptr, nullptr));
+    }
+    G4LogicalVolume* chamberLV = fLogicChambers.front();
+
+    fChamberParam = new ChamberParameterisation(
+        fNbOfChambers,          // NoChambers
+        layout.firstPosition,   // Z of center of first
+        fChamberSpacing,        // Z spacing of centers
+        fChamberWidth,          // chamber width
+        layout.rmaxFirst,       // initial radius
+        layout.rmaxLast);       // final radius
+
+    // kZAxis lets the navigator voxelise along z, so locating a chamber does
+    // not depend on the number of copies
+    fChamberPV = new G4PVParameterised(
+        "Chamber_PV",       // their name
+        chamberLV,          // their logical volume
+        fLogicTracker,      // Mother logical volume
+        kZAxis,             // Are placed along this axis
+        fNbOfChambers,      // Number of chambers
+        fChamberParam,      // The parametrisation
+        fCheckOverlaps);    // checking overlaps
+
+    G4cout << "  Chambers: " << fNbOfChambers << " parameterised copies, rmax "
+           << layout.rmaxFirst/cm << " -> " << layout.rmaxLast/cm << " cm" << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -222,12 +412,84 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
 void DetectorConstruction::ConstructSDandField()
 {
     // Sensitive detectors
+    // Reused when the geometry is rebuilt, so the hits collection keeps its ID
     G4String trackerChamberSDname = "/TrackerChamberSD";
-    TrackerSD* aTrackerSD = new TrackerSD(trackerChamberSDname, "TrackerHitsCollection");
-    G4SDManager::GetSDMpointer()->AddNewDetector(aTrackerSD);
-    SetSensitiveDetector(fLogicChamber, aTrackerSD);
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    G4VSensitiveDetector* aTrackerSD = sdManager->FindSensitiveDetector(trackerChamberSDname, false);
+    if (!aTrackerSD) {
+        aTrackerSD = new TrackerSD(trackerChamberSDname, "TrackerHitsCollection");
+        sdManager->AddNewDetector(aTrackerSD);
+    }
+    for (auto chamberLV : fLogicChambers) {
+        SetSensitiveDetector(chamberLV, aTrackerSD);
+    }
 
     G4cout << G4endl << "Sensitive detector attached to chambers" << G4endl;
+
+    ConstructField();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ConstructField()
+{
+    // Called on every thread: the field and its integration objects are
+    // thread-local
+    G4MagneticField* field = nullptr;
+    if (fFieldMap) {
+        field = new FieldMap(*fFieldMap);
+    }
+    else if (fUniformField.mag() > 0.) {
+        field = new G4UniformMagField(fUniformField);
+    }
+    if (!field) return;
+
+    auto equation = new G4Mag_UsualEqRhs(field);
+    G4MagIntegratorStepper* stepper = CreateStepper(equation);
+    auto chordFinder = new G4ChordFinder(field, fMinStep, stepper);
+    chordFinder->SetDeltaChord(fDeltaChord);
+
+    G4FieldManager* fieldManager = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+    fieldManager->SetDetectorField(field);
+    fieldManager->SetChordFinder(chordFinder);
+    fieldManager->SetDeltaOneStep(fDeltaOneStep);
+    fieldManager->SetMinimumEpsilonStep(fEpsilonMin);
+    fieldManager->SetMaximumEpsilonStep(fEpsilonMax);
+
+    G4AutoDelete::Register(field);
+    G4AutoDelete::Register(equation);
+    G4AutoDelete::Register(stepper);
+    G4AutoDelete::Register(chordFinder);
+
+    G4cout << "Magnetic field: " << (fFieldMap ? "map " + fFieldMapFile : G4String("uniform"))
+           << ", stepper " << fStepperName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4MagIntegratorStepper* DetectorConstruction::CreateStepper(G4Mag_UsualEqRhs* equation) const
+{
+    if (fStepperName == "ClassicalRK4") return new G4ClassicalRK4(equation);
+    if (fStepperName == "CashKarpRKF45") return new G4CashKarpRKF45(equation);
+    if (fStepperName == "DormandPrince745") return new G4DormandPrince745(equation);
+    if (fStepperName == "BogackiShampine23") return new G4BogackiShampine23(equation);
+    if (fStepperName == "TsitourasRK45") return new G4TsitourasRK45(equation);
+    if (fStepperName == "NystromRK4") return new G4NystromRK4(equation);
+    if (fStepperName == "HelixExplicitEuler") return new G4HelixExplicitEuler(equation);
+    if (fStepperName == "HelixSimpleRunge") return new G4HelixSimpleRunge(equation);
+    if (fStepperName == "ExactHelix") {
+        if (fFieldMap) {
+            G4Exception("DetectorConstruction::CreateStepper()", "InvalidStepper",
+                        JustWarning, "ExactHelix assumes a uniform field");
+        }
+        return new G4ExactHelixStepper(equation);
+    }
+
+    G4ExceptionDescription msg;
+    msg << "Unknown stepper: " << fStepperName;
+    G4Exception("DetectorConstruction::CreateStepper()", "InvalidStepper",
+                FatalErrorInArgument, msg);
+    return nullptr;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -240,7 +502,11 @@ void DetectorConstruction::SetTargetMaterial(G4String materialName)
     if (fTargetMaterial != pttoMaterial) {
         if (pttoMaterial) {
             fTargetMaterial = pttoMaterial;
-            if (fLogicTarget) fLogicTarget->SetMaterial(fTargetMaterial);
+            if (fLogicTarget) {
+                fLogicTarget->SetMaterial(fTargetMaterial);
+                // Material-cuts couples are rebuilt at the next run
+                G4RunManager::GetRunManager()->PhysicsHasBeenModified();
+            }
             G4cout << "Target material changed to: " << materialName << G4endl;
         }
     }
@@ -256,7 +522,8 @@ void DetectorConstruction::SetChamberMaterial(G4String materialName)
     if (fChamberMaterial != pttoMaterial) {
         if (pttoMaterial) {
             fChamberMaterial = pttoMaterial;
-            if (fLogicChamber) fLogicChamber->SetMaterial(fChamberMaterial);
+            for (auto chamberLV : fLogicChambers) chamberLV->SetMaterial(fChamberMaterial);
+            if (!fLogicChambers.empty()) G4RunManager::GetRunManager()->PhysicsHasBeenModified();
             G4cout << "Chamber material changed to: " << materialName << G4endl;
         }
     }
@@ -276,5 +543,127 @@ void DetectorConstruction::SetCheckOverlaps(G4bool checkOverlaps)
     fCheckOverlaps = checkOverlaps;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetTargetLength(G4double length)
+{
+    fTargetLength = length;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetNbOfChambers(G4int nbOfChambers)
+{
+    fNbOfChambers = nbOfChambers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetChamberSpacing(G4double spacing)
+{
+    fChamberSpacing = spacing;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetChamberWidth(G4double width)
+{
+    fChamberWidth = width;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetFirstChamberRadius(G4double radius)
+{
+    fFirstChamberRadius = radius;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetLastChamberRadius(G4double radius)
+{
+    fLastChamberRadius = radius;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::SetChamberMode(G4String mode)
+{
+    fParameterisedChambers = (mode == "parameterised");
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::UpdateGeometry(G4String targetMaterial, G4double targetLength,
+                                          G4int nbOfChambers)
+{
+    SetTargetMaterial(targetMaterial);
+
+    G4bool targetChanged = (targetLength != fTargetLength);
+    G4bool chambersChanged = (nbOfChambers != fNbOfChambers);
+    fTargetLength = targetLength;
+    fNbOfChambers = nbOfChambers;
+
+    // Not built yet: the next /run/initialize uses the new values
+    if (!fLogicWorld || (!targetChanged && !chambersChanged)) return;
+
+    if (chambersChanged && !fParameterisedChambers) {
+        // New chamber logical volumes need their sensitive detector on every
+        // thread, so placements are rebuilt from scratch
+        G4cout << "Chamber count changed: rebuilding the whole geometry" << G4endl;
+        G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+        return;
+    }
+
+    Layout layout = ComputeLayout();
+
+    // Solids are resized in place; the world only grows so that nothing
+    // placed in it ends up outside
+    auto worldS = static_cast<G4Box*>(fLogicWorld->GetSolid());
+    G4double worldSize = std::max(worldS->GetZHalfLength(), 0.5*layout.worldLength);
+    worldS->SetXHalfLength(worldSize);
+    worldS->SetYHalfLength(worldSize);
+    worldS->SetZHalfLength(worldSize);
+
+    static_cast<G4Tubs*>(fLogicTarget->GetSolid())->SetZHalfLength(0.5*fTargetLength);
+    fTargetPV->SetTranslation(layout.targetPosition);
+
+    if (chambersChanged) {
+        auto trackerS = static_cast<G4Tubs*>(fLogicTracker->GetSolid());
+        trackerS->SetOuterRadius(layout.trackerRadius);
+        trackerS->SetZHalfLength(0.5*layout.trackerLength);
+
+        // Same chamber logical volume (and sensitive detector), new copies
+        fLogicTracker->RemoveDaughter(fChamberPV);
+        delete fChamberPV;
+        delete fChamberParam;
+        ParameteriseChambers(layout);
+        ReoptimiseVoxels(fLogicTracker);
+    }
+    // Target and tracker extents changed inside the world
+    ReoptimiseVoxels(fLogicWorld);
+
+    G4cout << "Geometry updated: target " << fTargetMaterial->GetName() << ", "
+           << fTargetLength/cm << " cm at z = " << layout.targetPosition.z()/cm << " cm, "
+           << fNbOfChambers << " chambers" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ReoptimiseVoxels(G4LogicalVolume* mother)
+{
+    // Same criteria as G4GeometryManager::BuildOptimisations, restricted to
+    // one mother instead of the whole tree
+    delete mother->GetVoxelHeader();
+    mother->SetVoxelHeader(nullptr);
+
+    G4bool replicated = (mother->GetNoDaughters() == 1)
+        && mother->GetDaughter(0)->IsReplicated()
+        && (mother->GetDaughter(0)->GetRegularStructureId() != 1);
+    if ((mother->IsToOptimise() && mother->GetNoDaughters() >= kMinVoxelVolumesLevel1)
+        || replicated) {
+        mother->SetVoxelHeader(new G4SmartVoxelHeader(mother));
+    }
+}
+
+}
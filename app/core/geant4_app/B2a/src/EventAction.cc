@@ -3,8 +3,19 @@
 // ********************************************************************
 
 #include "EventAction.hh"
+#include "RunAction.hh"
+#include "TrackerHit.hh"
+#include "TrackerSD.hh"
 
 #include "G4Event.hh"
+#include "G4SDManager.hh"
+#include "G4TransportationManager.hh"
+#include "G4FieldManager.hh"
+#include "G4MagneticField.hh"
+#include "g4csv.hh"
+
+#include <algorithm>
+#include <chrono>
 
 namespace B2a
 {
@@ -18,9 +29,113 @@ void EventAction::BeginOfEventAction(const G4Event*)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::EndOfEventAction(const G4Event*)
+void EventAction::EndOfEventAction(const G4Event* event)
+{
+    // Totals go to the run for every event; the hit summary and the
+    // reconstruction only for events accepted by the trigger
+    G4HCofThisEvent* hce = event->GetHCofThisEvent();
+    if (!hce) return;
+
+    if (fHCID < 0) {
+        fHCID = G4SDManager::GetSDMpointer()->GetCollectionID("TrackerHitsCollection");
+    }
+    auto hits = static_cast<TrackerHitsCollection*>(hce->GetHC(fHCID));
+    if (!hits) return;
+
+    // Summed deposit per chamber for the trigger
+    G4double edep = 0.;
+    fChamberEdep.assign(fChamberEdep.size(), 0.);
+    for (size_t i = 0; i < hits->entries(); i++) {
+        const TrackerHit* hit = (*hits)[i];
+        edep += hit->GetEdep();
+        G4int chamber = hit->GetChamberNb();
+        if (chamber < 0) continue;
+        if (chamber >= G4int(fChamberEdep.size())) fChamberEdep.resize(chamber + 1, 0.);
+        fChamberEdep[chamber] += hit->GetEdep();
+    }
+    fRunAction->AddEvent(G4int(hits->entries()), edep);
+
+    if (!fRunAction->GetTrigger().Accept(fChamberEdep)) return;
+    fRunAction->CountAccepted();
+
+    if (!fTrackerSD) {
+        fTrackerSD = static_cast<TrackerSD*>(
+            G4SDManager::GetSDMpointer()->FindSensitiveDetector("/TrackerChamberSD"));
+    }
+    if (fTrackerSD) fTrackerSD->PrintEvent(event->GetEventID(), fRunAction->GetLog());
+
+    if (fRunAction->IsRecoEnabled()) Reconstruct(event, hits);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::Reconstruct(const G4Event* event, TrackerHitsCollection* hits)
 {
-    // Hit summary is printed by TrackerSD::EndOfEvent
+    // The field of this thread, taken at the tracker centre
+    G4FieldManager* fieldManager = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+    auto field = static_cast<const G4MagneticField*>(fieldManager->GetDetectorField());
+    G4double point[4] = {0., 0., 0., 0.};
+    G4double value[3] = {0., 0., 0.};
+    if (field) field->GetFieldValue(point, value);
+    fFitter.SetField(G4ThreeVector(value[0], value[1], value[2]));
+    fFitter.SetResolution(fRunAction->GetRecoResolution());
+
+    // Group hits by chamber; chambers are numbered along the beam
+    fHitOrder.clear();
+    for (size_t i = 0; i < hits->entries(); i++) {
+        fHitOrder.emplace_back((*hits)[i]->GetChamberNb(), G4int(i));
+    }
+    std::sort(fHitOrder.begin(), fHitOrder.end());
+
+    fChambers.clear();
+    fClusters.clear();
+    for (size_t first = 0; first < fHitOrder.size();) {
+        G4int chamber = fHitOrder[first].first;
+        G4double sum = 0.;
+        G4ThreeVector weighted;
+        size_t last = first;
+        for (; last < fHitOrder.size() && fHitOrder[last].first == chamber; last++) {
+            const TrackerHit* hit = (*hits)[fHitOrder[last].second];
+            sum += hit->GetEdep();
+            weighted += hit->GetEdep() * hit->GetPos();
+        }
+        fChambers.push_back(chamber);
+        fClusters.push_back(weighted / sum);
+        first = last;
+    }
+
+    if (G4int(fClusters.size()) < fRunAction->GetRecoMinChambers()) return;
+
+    // Only the fit is timed, failed attempts included
+    auto start = std::chrono::steady_clock::now();
+    G4bool fitted = fFitter.Fit(fClusters, fFit);
+    std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - start;
+    fRunAction->AddFitAttempt(elapsed.count());
+    if (!fitted) return;
+
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    G4int eventID = event->GetEventID();
+    analysisManager->FillNtupleIColumn(0, 0, eventID);
+    analysisManager->FillNtupleIColumn(0, 1, fFit.helix ? 1 : 0);
+    analysisManager->FillNtupleIColumn(0, 2, fFit.nofPoints);
+    for (G4int p = 0; p < 5; p++) {
+        analysisManager->FillNtupleDColumn(0, 3 + p, fFit.params[p]);
+    }
+    analysisManager->FillNtupleDColumn(0, 8, fFit.z0);
+    analysisManager->FillNtupleDColumn(0, 9, fFit.chi2);
+    analysisManager->FillNtupleIColumn(0, 10, fFit.ndf);
+    analysisManager->FillNtupleDColumn(0, 11, fFit.pT);
+    analysisManager->AddNtupleRow(0);
+
+    for (size_t i = 0; i < fChambers.size(); i++) {
+        analysisManager->FillNtupleIColumn(1, 0, eventID);
+        analysisManager->FillNtupleIColumn(1, 1, fChambers[i]);
+        analysisManager->FillNtupleDColumn(1, 2, fFit.residuals[2*i]);
+        analysisManager->FillNtupleDColumn(1, 3, fFit.residuals[2*i + 1]);
+        analysisManager->AddNtupleRow(1);
+    }
+
+    fRunAction->AddTrack(fFit.chi2, fFit.ndf);
 }
 
 }
@@ -0,0 +1,202 @@
+// ********************************************************************
+// * B2a Field Map Implementation
+// ********************************************************************
+
+#include "FieldMap.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+namespace B2a
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FieldMap::FieldMap(const G4String& fileName)
+{
+    auto grid = std::make_shared<Grid>();
+    Load(fileName, *grid);
+    fGrid = grid;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FieldMap::FieldMap(const FieldMap& other)
+ : G4MagneticField(other),
+   fGrid(other.fGrid)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::Load(const G4String& fileName, Grid& grid) const
+{
+    std::ifstream in(fileName, std::ios::binary);
+    std::int32_t n[3];
+    G4double min[3], max[3];
+    in.read(reinterpret_cast<char*>(n), sizeof(n));
+    in.read(reinterpret_cast<char*>(min), sizeof(min));
+    in.read(reinterpret_cast<char*>(max), sizeof(max));
+    if (!in || n[0] < 2 || n[1] < 2 || n[2] < 2) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read field map header from " << fileName;
+        G4Exception("FieldMap::Load()", "FieldMapFile", FatalException, msg);
+        return;
+    }
+
+    for (G4int a = 0; a < 3; a++) {
+        grid.n[a] = n[a];
+        grid.min[a] = min[a]*mm;
+        grid.step[a] = (max[a] - min[a])*mm / (n[a] - 1);
+        grid.nBlocks[a] = (n[a] - 2) / kBlockCells + 1;
+    }
+    grid.blocks.assign(std::size_t(grid.nBlocks[0]) * grid.nBlocks[1] * grid.nBlocks[2] * kBlockSize, 0.f);
+
+    // Read one z plane at a time and scatter every point into each block
+    // that contains it (up to 8 at block corners)
+    const std::size_t planeSize = std::size_t(n[0]) * n[1];
+    std::vector<float> plane(3 * planeSize);
+    for (G4int iz = 0; iz < n[2]; iz++) {
+        in.read(reinterpret_cast<char*>(plane.data()), plane.size() * sizeof(float));
+        if (!in) {
+            G4ExceptionDescription msg;
+            msg << "Field map " << fileName << " ends at plane " << iz;
+            G4Exception("FieldMap::Load()", "FieldMapFile", FatalException, msg);
+            return;
+        }
+        for (G4int iy = 0; iy < n[1]; iy++) {
+            for (G4int ix = 0; ix < n[0]; ix++) {
+                const float* value = &plane[3 * (std::size_t(iy) * n[0] + ix)];
+                G4int index[3] = {ix, iy, iz};
+                G4int first[3], last[3];
+                for (G4int a = 0; a < 3; a++) {
+                    // A point on a block boundary is shared with the previous block
+                    first[a] = std::max(0, (index[a] - 1) / kBlockCells);
+                    last[a] = std::min(index[a] / kBlockCells, grid.nBlocks[a] - 1);
+                }
+                for (G4int bz = first[2]; bz <= last[2]; bz++) {
+                    for (G4int by = first[1]; by <= last[1]; by++) {
+                        for (G4int bx = first[0]; bx <= last[0]; bx++) {
+                            std::size_t block = (std::size_t(bz) * grid.nBlocks[1] + by) * grid.nBlocks[0] + bx;
+                            G4int lx = ix - bx * kBlockCells;
+                            G4int ly = iy - by * kBlockCells;
+                            G4int lz = iz - bz * kBlockCells;
+                            float* target = &grid.blocks[block * kBlockSize
+                                + 3 * ((lz * kBlockPoints + ly) * kBlockPoints + lx)];
+                            std::copy(value, value + 3, target);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    G4cout << "Field map " << fileName << ": " << n[0] << "x" << n[1] << "x" << n[2]
+           << " points, " << grid.blocks.size() * sizeof(float) / 1024 << " kB in blocks" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const float* FieldMap::BlockPoint(G4int cx, G4int cy, G4int cz, G4int ix, G4int iy, G4int iz) const
+{
+    const Grid& grid = *fGrid;
+    G4int bx = cx / kBlockCells, by = cy / kBlockCells, bz = cz / kBlockCells;
+    std::size_t block = (std::size_t(bz) * grid.nBlocks[1] + by) * grid.nBlocks[0] + bx;
+    G4int lx = ix - bx * kBlockCells;
+    G4int ly = iy - by * kBlockCells;
+    G4int lz = iz - bz * kBlockCells;
+    return &grid.blocks[block * kBlockSize + 3 * ((lz * kBlockPoints + ly) * kBlockPoints + lx)];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FieldMap::FindCell(const G4double point[4], G4int* cell, G4double* frac) const
+{
+    const Grid& grid = *fGrid;
+    for (G4int a = 0; a < 3; a++) {
+        G4double u = (point[a] - grid.min[a]) / grid.step[a];
+        if (u < 0. || u > grid.n[a] - 1) return false;
+        cell[a] = std::min(G4int(u), grid.n[a] - 2);
+        frac[a] = u - cell[a];
+    }
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::FetchCorners(const G4int* cell, G4double corners[8][3]) const
+{
+    // Corner c has offsets (c & 1, (c >> 1) & 1, c >> 2)
+    for (G4int c = 0; c < 8; c++) {
+        const float* value = BlockPoint(cell[0], cell[1], cell[2],
+                                        cell[0] + (c & 1), cell[1] + ((c >> 1) & 1), cell[2] + (c >> 2));
+        for (G4int a = 0; a < 3; a++) corners[c][a] = value[a] * tesla;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::Interpolate(const G4double corners[8][3], const G4double* frac, G4double* field)
+{
+    G4double fx = frac[0], fy = frac[1], fz = frac[2];
+    G4double w[8] = {
+        (1-fx)*(1-fy)*(1-fz), fx*(1-fy)*(1-fz), (1-fx)*fy*(1-fz), fx*fy*(1-fz),
+        (1-fx)*(1-fy)*fz,     fx*(1-fy)*fz,     (1-fx)*fy*fz,     fx*fy*fz
+    };
+    for (G4int a = 0; a < 3; a++) {
+        G4double sum = 0.;
+        for (G4int c = 0; c < 8; c++) sum += w[c] * corners[c][a];
+        field[a] = sum;
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::GetFieldValue(const G4double point[4], G4double* field) const
+{
+    G4int cell[3];
+    G4double frac[3];
+    if (!FindCell(point, cell, frac)) {
+        field[0] = field[1] = field[2] = 0.;
+        return;
+    }
+
+    // Steps along a track mostly stay in the cell of the previous call
+    if (cell[0] != fCell[0] || cell[1] != fCell[1] || cell[2] != fCell[2]) {
+        FetchCorners(cell, fCorners);
+        std::copy(cell, cell + 3, fCell);
+    }
+    Interpolate(fCorners, frac, field);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::GetFieldValueDirect(const G4double point[4], G4double* field) const
+{
+    G4int cell[3];
+    G4double frac[3];
+    if (!FindCell(point, cell, frac)) {
+        field[0] = field[1] = field[2] = 0.;
+        return;
+    }
+
+    G4double corners[8][3];
+    FetchCorners(cell, corners);
+    Interpolate(corners, frac, field);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FieldMap::GetGridValue(G4int ix, G4int iy, G4int iz, G4double* field) const
+{
+    const Grid& grid = *fGrid;
+    G4int cx = std::min(ix, grid.n[0] - 2);
+    G4int cy = std::min(iy, grid.n[1] - 2);
+    G4int cz = std::min(iz, grid.n[2] - 2);
+    const float* value = BlockPoint(cx, cy, cz, ix, iy, iz);
+    for (G4int a = 0; a < 3; a++) field[a] = value[a] * tesla;
+}
+
+}
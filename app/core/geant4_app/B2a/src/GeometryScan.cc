@@ -0,0 +1,115 @@
+// ********************************************************************
+// * B2a Geometry Scan Implementation
+// ********************************************************************
+
+#include "GeometryScan.hh"
+#include "DetectorConstruction.hh"
+#include "RunAction.hh"
+
+#include "G4RunManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Timer.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace B2a
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GeometryScan::GeometryScan(DetectorConstruction* detector)
+ : fDetector(detector)
+{
+    fMessenger = new G4GenericMessenger(this, "/B2a/scan/", "Geometry variant scan");
+
+    fMessenger->DeclareMethod("load", &GeometryScan::LoadVariants)
+        .SetGuidance("Read variants: <name> <target material> <target length [cm]> <chambers>.")
+        .SetParameterName("file", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("outputDir", &GeometryScan::SetOutputDirectory)
+        .SetGuidance("Parent directory of the per-variant output directories.")
+        .SetParameterName("dir", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("beamOn", &GeometryScan::BeamOn)
+        .SetGuidance("Run every loaded variant with this number of events.")
+        .SetParameterName("events", false)
+        .SetRange("events>0")
+        .SetStates(G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+GeometryScan::~GeometryScan()
+{
+    delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryScan::LoadVariants(G4String fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open variants file " << fileName;
+        G4Exception("GeometryScan::LoadVariants()", "ScanFile", FatalErrorInArgument, msg);
+        return;
+    }
+
+    fVariants.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream is(line);
+        Variant variant;
+        if (!(is >> variant.name)) continue;
+        if (!(is >> variant.targetMaterial >> variant.targetLength >> variant.nbOfChambers)
+            || variant.targetLength <= 0. || variant.nbOfChambers <= 0) {
+            G4ExceptionDescription msg;
+            msg << "Invalid variant in " << fileName << ": " << line;
+            G4Exception("GeometryScan::LoadVariants()", "ScanFile", FatalErrorInArgument, msg);
+            return;
+        }
+        variant.targetLength *= cm;
+        fVariants.push_back(variant);
+    }
+
+    G4cout << "Geometry scan: " << fVariants.size() << " variants from " << fileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void GeometryScan::BeamOn(G4int nofEvents)
+{
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    G4Timer timer;
+
+    for (const auto& variant : fVariants) {
+        G4String dir = fOutputDirectory + "/" + variant.name;
+        std::filesystem::create_directories(dir.c_str());
+        RunAction::SetOutputDirectory(dir);
+
+        G4cout << G4endl << "=== Geometry variant " << variant.name << " ===" << G4endl;
+
+        timer.Start();
+        fDetector->UpdateGeometry(variant.targetMaterial, variant.targetLength, variant.nbOfChambers);
+        runManager->BeamOn(nofEvents);
+        timer.Stop();
+
+        std::ofstream out(dir + "/variant.txt");
+        out << "name " << variant.name << "\n"
+            << "target_material " << variant.targetMaterial << "\n"
+            << "target_length_cm " << variant.targetLength/cm << "\n"
+            << "chambers " << variant.nbOfChambers << "\n"
+            << "wall_s " << timer.GetRealElapsed() << "\n";
+    }
+
+    RunAction::SetOutputDirectory("");
+}
+
+}
@@ -6,10 +6,99 @@
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "g4csv.hh"
+
+#include <fstream>
+#include <sstream>
 
 namespace B2a
 {
 
+namespace
+{
+
+// Trigger detectors are the chambers, by copy number
+G4int ChamberIndex(const G4String& detector)
+{
+    std::istringstream is(detector);
+    G4int chamber = -1;
+    if (!(is >> chamber) || !is.eof()) return -1;
+    return chamber;
+}
+
+}
+
+G4String RunAction::fgOutputDirectory;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunAction::RunAction()
+  : fTrigger("/B2a/trigger/", "keV", ChamberIndex)
+{
+    G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+    accumulableManager->RegisterAccumulable(fNofHits);
+    accumulableManager->RegisterAccumulable(fEdep);
+    accumulableManager->RegisterAccumulable(fNofAccepted);
+    accumulableManager->RegisterAccumulable(fNofFits);
+    accumulableManager->RegisterAccumulable(fNofTracks);
+    accumulableManager->RegisterAccumulable(fChi2PerNdf);
+    accumulableManager->RegisterAccumulable(fFitTime);
+
+    // Created on every thread so that commands reach the workers
+    fMessenger = new G4GenericMessenger(this, "/B2a/reco/", "Track reconstruction");
+
+    fMessenger->DeclareProperty("enable", fRecoEnabled)
+        .SetGuidance("Fit a track through the chamber hits of every event.")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclarePropertyWithUnit("resolution", "mm", fRecoResolution)
+        .SetGuidance("Chamber point resolution used in the chi2.")
+        .SetParameterName("sigma", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("minChambers", fRecoMinChambers)
+        .SetGuidance("Minimum number of chambers with hits for a fit (>= 3).")
+        .SetParameterName("n", false)
+        .SetRange("n>=3")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    // Ntuples of fitted tracks (ID 0) and their residuals (ID 1)
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    analysisManager->CreateNtuple("tracks", "Fitted track per event");
+    analysisManager->CreateNtupleIColumn("eventID");     // ID 0
+    analysisManager->CreateNtupleIColumn("helix");       // ID 1
+    analysisManager->CreateNtupleIColumn("chambers");    // ID 2
+    analysisManager->CreateNtupleDColumn("p0");          // ID 3  x0 | uc
+    analysisManager->CreateNtupleDColumn("p1");          // ID 4  y0 | vc
+    analysisManager->CreateNtupleDColumn("p2");          // ID 5  tx | R
+    analysisManager->CreateNtupleDColumn("p3");          // ID 6  ty | w0
+    analysisManager->CreateNtupleDColumn("p4");          // ID 7  -  | tanLambda
+    analysisManager->CreateNtupleDColumn("z0");          // ID 8
+    analysisManager->CreateNtupleDColumn("chi2");        // ID 9
+    analysisManager->CreateNtupleIColumn("ndf");         // ID 10
+    analysisManager->CreateNtupleDColumn("pT");          // ID 11
+    analysisManager->FinishNtuple();
+
+    analysisManager->CreateNtuple("residuals", "Track residual per chamber");
+    analysisManager->CreateNtupleIColumn("eventID");     // ID 0
+    analysisManager->CreateNtupleIColumn("chamber");     // ID 1
+    analysisManager->CreateNtupleDColumn("r1");          // ID 2  x | radial
+    analysisManager->CreateNtupleDColumn("r2");          // ID 3  y | along field
+    analysisManager->FinishNtuple();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunAction::~RunAction()
+{
+    delete fMessenger;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void RunAction::BeginOfRunAction(const G4Run* run)
@@ -22,12 +111,31 @@ void RunAction::BeginOfRunAction(const G4Run* run)
 
     // Inform the runManager to save random number seed
     G4RunManager::GetRunManager()->SetRandomNumberStore(false);
+
+    G4AccumulableManager::Instance()->Reset();
+
+    if (fRecoEnabled) {
+        G4String dir = fgOutputDirectory.empty() ? G4String(".") : fgOutputDirectory;
+        G4AnalysisManager::Instance()->OpenFile(dir + "/B2a_reco");
+    }
+
+    fTimer.Start();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void RunAction::EndOfRunAction(const G4Run* run)
 {
+    fTimer.Stop();
+    fLog.Flush();
+    G4AccumulableManager::Instance()->Merge();
+
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    if (analysisManager->IsOpenFile()) {
+        analysisManager->Write();
+        analysisManager->CloseFile();
+    }
+
     G4int nofEvents = run->GetNumberOfEvent();
     if (nofEvents == 0) return;
 
@@ -35,8 +143,77 @@ void RunAction::EndOfRunAction(const G4Run* run)
     G4cout << "========================================" << G4endl;
     G4cout << "### Run " << run->GetRunID() << " ended." << G4endl;
     G4cout << "    Processed events: " << nofEvents << G4endl;
+    if (IsMaster()) {
+        G4double elapsed = fTimer.GetRealElapsed();
+        G4cout << "    Event loop time: " << elapsed << " s";
+        if (elapsed > 0.) G4cout << " (" << nofEvents / elapsed << " events/s)";
+        G4cout << G4endl;
+        G4cout << "    Hits: " << fNofHits.GetValue()
+               << " | Total Edep: " << fEdep.GetValue()/keV << " keV" << G4endl;
+        if (fTrigger.IsActive()) {
+            fTrigger.Print();
+            G4cout << "    Accepted events: " << fNofAccepted.GetValue() << " of " << nofEvents
+                   << " (" << 100. * fNofAccepted.GetValue() / nofEvents << " %)" << G4endl;
+        }
+        if (fNofFits.GetValue() > 0) {
+            G4cout << "    Tracks fitted: " << fNofTracks.GetValue() << " of " << fNofFits.GetValue();
+            if (fNofTracks.GetValue() > 0) {
+                G4cout << " | Mean chi2/ndf: " << fChi2PerNdf.GetValue() / fNofTracks.GetValue();
+            }
+            G4cout << " | Fit time: " << fFitTime.GetValue() / fNofFits.GetValue() * 1e6 << " us/fit"
+                   << G4endl;
+        }
+        if (!fgOutputDirectory.empty()) WriteSummary(run, elapsed);
+    }
     G4cout << "========================================" << G4endl;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::AddEvent(G4int nofHits, G4double edep)
+{
+    fNofHits += nofHits;
+    fEdep += edep;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::AddFitAttempt(G4double fitTime)
+{
+    fNofFits += 1;
+    fFitTime += fitTime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::AddTrack(G4double chi2, G4int ndf)
+{
+    fNofTracks += 1;
+    if (ndf > 0) fChi2PerNdf += chi2 / ndf;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::WriteSummary(const G4Run* run, G4double elapsed) const
+{
+    G4String fileName = fgOutputDirectory + "/run_summary.txt";
+    std::ofstream out(fileName);
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName;
+        G4Exception("RunAction::WriteSummary()", "OutputFile", JustWarning, msg);
+        return;
+    }
+
+    G4int nofEvents = run->GetNumberOfEvent();
+    out << "run " << run->GetRunID() << "\n"
+        << "events " << nofEvents << "\n"
+        << "hits " << fNofHits.GetValue() << "\n"
+        << "edep_keV " << fEdep.GetValue()/keV << "\n"
+        << "edep_per_event_keV " << fEdep.GetValue()/keV / nofEvents << "\n"
+        << "event_loop_s " << elapsed << "\n"
+        << "accepted " << fNofAccepted.GetValue() << "\n"
+        << "tracks " << fNofTracks.GetValue() << "\n";
+}
+
+}
@@ -0,0 +1,207 @@
+// ********************************************************************
+// * B2a Track Fitter Implementation
+// ********************************************************************
+
+#include "TrackFitter.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+namespace B2a
+{
+
+namespace
+{
+
+// Sum of f(i) over [0, n) with kLanes partial sums
+template <G4int Lanes, typename F>
+inline G4double LaneSum(std::size_t n, F f)
+{
+    G4double lanes[Lanes] = {};
+    std::size_t i = 0;
+    for (; i + Lanes <= n; i += Lanes) {
+        for (G4int l = 0; l < Lanes; l++) lanes[l] += f(i + l);
+    }
+    G4double sum = 0.;
+    for (; i < n; i++) sum += f(i);
+    for (G4int l = 0; l < Lanes; l++) sum += lanes[l];
+    return sum;
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackFitter::SetField(const G4ThreeVector& field)
+{
+    fField = field.mag();
+    if (fField <= 0.) return;
+
+    fW = field.unit();
+    // Any vector not parallel to the field completes the frame
+    G4ThreeVector axis = std::abs(fW.z()) < 0.9 ? G4ThreeVector(0, 0, 1) : G4ThreeVector(1, 0, 0);
+    fU = fW.cross(axis).unit();
+    fV = fW.cross(fU);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TrackFitter::Fit(const std::vector<G4ThreeVector>& points, TrackFit& fit)
+{
+    std::size_t n = points.size();
+    fit.nofPoints = G4int(n);
+    if (n < 3) return false;
+
+    fA.resize(n);
+    fB.resize(n);
+    fC.resize(n);
+    fS.resize(n);
+
+    if (fField > 0.) {
+        for (std::size_t i = 0; i < n; i++) {
+            fA[i] = points[i].dot(fU);
+            fB[i] = points[i].dot(fV);
+            fC[i] = points[i].dot(fW);
+        }
+        if (FitHelix(fit)) return true;
+        // Collinear points in the bending plane: fall through to a line
+    }
+
+    for (std::size_t i = 0; i < n; i++) {
+        fA[i] = points[i].x();
+        fB[i] = points[i].y();
+        fC[i] = points[i].z();
+    }
+    return FitLine(fit);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TrackFitter::LinearFit(const std::vector<G4double>& x, const std::vector<G4double>& y,
+                              G4double& a, G4double& b) const
+{
+    std::size_t n = x.size();
+    const G4double* px = x.data();
+    const G4double* py = y.data();
+
+    // Centred sums keep the normal equations well conditioned
+    G4double xm = LaneSum<kLanes>(n, [px](std::size_t i) { return px[i]; }) / n;
+    G4double ym = LaneSum<kLanes>(n, [py](std::size_t i) { return py[i]; }) / n;
+    G4double sxx = LaneSum<kLanes>(n, [px, xm](std::size_t i) { return (px[i]-xm)*(px[i]-xm); });
+    G4double sxy = LaneSum<kLanes>(n, [px, py, xm, ym](std::size_t i) { return (px[i]-xm)*(py[i]-ym); });
+    if (sxx <= 0.) return false;
+
+    b = sxy / sxx;
+    a = ym - b * xm;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TrackFitter::FitLine(TrackFit& fit)
+{
+    // x(z) and y(z) are independent fits; parameters refer to the first point
+    std::size_t n = fA.size();
+    G4double ax, bx, ay, by;
+    if (!LinearFit(fC, fA, ax, bx) || !LinearFit(fC, fB, ay, by)) return false;
+
+    fit.helix = false;
+    fit.z0 = fC[0];
+    fit.params[0] = ax + bx * fit.z0;
+    fit.params[1] = ay + by * fit.z0;
+    fit.params[2] = bx;
+    fit.params[3] = by;
+    fit.params[4] = 0.;
+    fit.pT = 0.;
+
+    fit.residuals.resize(2 * n);
+    G4double chi2 = 0.;
+    for (std::size_t i = 0; i < n; i++) {
+        G4double rx = fA[i] - (ax + bx * fC[i]);
+        G4double ry = fB[i] - (ay + by * fC[i]);
+        fit.residuals[2*i] = rx;
+        fit.residuals[2*i + 1] = ry;
+        chi2 += rx*rx + ry*ry;
+    }
+    fit.chi2 = chi2 / (fSigma * fSigma);
+    fit.ndf = G4int(2*n) - 4;
+    return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TrackFitter::FitHelix(TrackFit& fit)
+{
+    std::size_t n = fA.size();
+    const G4double* pu = fA.data();
+    const G4double* pv = fB.data();
+
+    // Algebraic circle fit (Kasa) in centred coordinates:
+    // minimise sum (u^2 + v^2 + D u + E v + F)^2, linear in D, E, F
+    G4double um = LaneSum<kLanes>(n, [pu](std::size_t i) { return pu[i]; }) / n;
+    G4double vm = LaneSum<kLanes>(n, [pv](std::size_t i) { return pv[i]; }) / n;
+    auto du = [pu, um](std::size_t i) { return pu[i] - um; };
+    auto dv = [pv, vm](std::size_t i) { return pv[i] - vm; };
+    auto r2 = [&](std::size_t i) { return du(i)*du(i) + dv(i)*dv(i); };
+
+    G4double suu = LaneSum<kLanes>(n, [&](std::size_t i) { return du(i)*du(i); });
+    G4double svv = LaneSum<kLanes>(n, [&](std::size_t i) { return dv(i)*dv(i); });
+    G4double suv = LaneSum<kLanes>(n, [&](std::size_t i) { return du(i)*dv(i); });
+    G4double sru = LaneSum<kLanes>(n, [&](std::size_t i) { return r2(i)*du(i); });
+    G4double srv = LaneSum<kLanes>(n, [&](std::size_t i) { return r2(i)*dv(i); });
+    G4double sr = LaneSum<kLanes>(n, [&](std::size_t i) { return r2(i); });
+
+    // Centred sums of u and v vanish, so F decouples: F = -sr/n
+    G4double det = suu*svv - suv*suv;
+    if (std::abs(det) <= 1e-12 * (suu*svv + 1.)) return false;
+    G4double D = (-sru*svv + srv*suv) / det;
+    G4double E = (-srv*suu + sru*suv) / det;
+    G4double F = -sr / n;
+
+    G4double uc = -0.5*D, vc = -0.5*E;
+    G4double radius2 = uc*uc + vc*vc - F;
+    if (radius2 <= 0.) return false;
+    G4double radius = std::sqrt(radius2);
+
+    // Arc length from the first point, unwrapped along the track
+    G4double phi0 = std::atan2(dv(0) - vc, du(0) - uc);
+    G4double previous = 0.;
+    for (std::size_t i = 0; i < n; i++) {
+        G4double dphi = std::atan2(dv(i) - vc, du(i) - uc) - phi0;
+        while (dphi - previous > pi) dphi -= twopi;
+        while (dphi - previous < -pi) dphi += twopi;
+        previous = dphi;
+        fS[i] = radius * dphi;
+    }
+
+    G4double w0, tanLambda;
+    if (!LinearFit(fS, fC, w0, tanLambda)) return false;
+
+    fit.helix = true;
+    fit.z0 = 0.;
+    fit.params[0] = uc + um;
+    fit.params[1] = vc + vm;
+    fit.params[2] = radius;
+    fit.params[3] = w0;
+    fit.params[4] = tanLambda;
+    // p_T = |q| c B R for unit charge
+    fit.pT = c_light * fField * radius;
+
+    fit.residuals.resize(2 * n);
+    G4double chi2 = 0.;
+    for (std::size_t i = 0; i < n; i++) {
+        G4double eu = du(i) - uc, ev = dv(i) - vc;
+        G4double rr = std::sqrt(eu*eu + ev*ev) - radius;
+        G4double rw = fC[i] - (w0 + tanLambda * fS[i]);
+        fit.residuals[2*i] = rr;
+        fit.residuals[2*i + 1] = rw;
+        chi2 += rr*rr + rw*rw;
+    }
+    fit.chi2 = chi2 / (fSigma * fSigma);
+    fit.ndf = G4int(2*n) - 5;
+    return true;
+}
+
+}
@@ -11,7 +11,6 @@
 #include "G4SDManager.hh"
 #include "G4ios.hh"
 #include "G4SystemOfUnits.hh"
-#include "G4RunManager.hh"
 
 namespace B2a
 {
@@ -61,25 +60,22 @@ G4bool TrackerSD::ProcessHits(G4Step* aStep, G4TouchableHistory*)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void TrackerSD::EndOfEvent(G4HCofThisEvent*)
+void TrackerSD::PrintEvent(G4int eventID, LogSink* log) const
 {
     G4int nofHits = fHitsCollection->entries();
     
-    // Get event ID
-    G4int eventID = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
-    
-    // Print summary for API parsing
-    G4cout << ">>> Event " << eventID << " | Hits: " << nofHits;
-    
     G4double totalEdep = 0.;
     for (G4int i = 0; i < nofHits; i++) {
         totalEdep += (*fHitsCollection)[i]->GetEdep();
     }
     
-    G4cout << " | Total Edep: " << totalEdep/keV << " keV" << G4endl;
+    // Summary record for API parsing
+    log->Log(LogSink::kInfo, "event")
+        .Add("event", eventID).Add("hits", nofHits).Add("edep_kev", totalEdep/keV);
     
     // Output detailed hit info (for API)
     if (verboseLevel > 1) {
+        log->Flush();
         G4cout << "---------- Hit Details ----------" << G4endl;
         for (G4int i = 0; i < nofHits; i++) {
             (*fHitsCollection)[i]->Print();
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""
+Compare per-event energy deposits of a full and a fast-shower run.
+
+Usage: compare_showers.py <full_output_dir> <fast_output_dir>
+
+Reads the "hits" ntuple (output_nt_hits*.csv) written by geant4api in each
+directory and prints mean deposit, RMS and resolution (RMS/mean) side by side.
+"""
+
+import math
+import sys
+from pathlib import Path
+
+
+def read_edep(output_dir: Path) -> list:
+    """Return the per-event edep column (MeV) from all ntuple files."""
+    values = []
+    for path in sorted(output_dir.glob("output_nt_hits*.csv")):
+        columns = []
+        with open(path) as f:
+            for line in f:
+                if line.startswith("#column"):
+                    columns.append(line.split()[2])
+                elif line.strip() and not line.startswith("#"):
+                    row = line.strip().split(",")
+                    values.append(float(row[columns.index("edep")]))
+    return values
+
+
+def summarize(values: list) -> tuple:
+    n = len(values)
+    mean = sum(values) / n
+    rms = math.sqrt(sum((v - mean) ** 2 for v in values) / (n - 1)) if n > 1 else 0.0
+    return n, mean, rms
+
+
+def main() -> int:
+    if len(sys.argv) != 3:
+        print(__doc__)
+        return 1
+
+    results = {}
+    for label, directory in (("full", sys.argv[1]), ("fast", sys.argv[2])):
+        values = read_edep(Path(directory))
+        if not values:
+            print(f"No hits ntuple found in {directory}")
+            return 1
+        results[label] = summarize(values)
+
+    print(f"{'':6} {'events':>8} {'mean [MeV]':>12} {'rms [MeV]':>12} {'resolution':>11}")
+    for label, (n, mean, rms) in results.items():
+        print(f"{label:6} {n:8d} {mean:12.3f} {rms:12.3f} {rms / mean:11.4f}")
+
+    full_mean, fast_mean = results["full"][1], results["fast"][1]
+    print(f"\nMean deposit ratio fast/full: {fast_mean / full_mean:.4f}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
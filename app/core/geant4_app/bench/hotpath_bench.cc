@@ -0,0 +1,153 @@
+/**
+ * Hot-path microbenchmark
+ * =======================
+ * Drives the user code that runs per step or per event without any
+ * transport: SensitiveDetector::ProcessHits on synthetic G4Steps,
+ * DetectorHit allocation and copy, Analysis::FillH1/FillH2 and ntuple
+ * rows (CSV output in a scratch directory). Reports ns/op and heap
+ * allocations per op, counted by replacing the global operator new.
+ *
+ * Usage: hotpath_bench [ops per case] [output dir]
+ */
+
+#include "SensitiveDetector.hh"
+#include "Analysis.hh"
+
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4StepLimiter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Heap allocations of the whole process; the benchmark is single-threaded
+long gAllocations = 0;
+
+struct Result {
+    double nsPerOp;
+    double allocationsPerOp;
+};
+
+template <typename Op>
+Result Measure(long ops, Op op) {
+    long allocations = gAllocations;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ops; ++i) op(i);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return {elapsed.count() / ops, double(gAllocations - allocations) / ops};
+}
+
+void Print(const char* name, const Result& result) {
+    std::printf("%-36s %10.1f %12.3f\n", name, result.nsPerOp, result.allocationsPerOp);
+}
+
+}
+
+void* operator new(std::size_t size) {
+    ++gAllocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+    long ops = argc > 1 ? std::atol(argv[1]) : 1000000;
+    G4String outputDir = argc > 2 ? argv[2] : ".";
+
+    // Sensitive detector registered as in DetectorConstruction
+    SensitiveDetector* sd = new SensitiveDetector("BenchSD", "BenchSD_HC");
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    sdManager->AddNewDetector(sd);
+
+    // One electron step with a deposit, ending in a step limit
+    G4DynamicParticle* particle =
+        new G4DynamicParticle(G4Electron::Definition(), G4ThreeVector(0., 0., 1.), 1.*MeV);
+    G4Track* track = new G4Track(particle, 0., G4ThreeVector());
+    track->SetTrackID(1);
+    track->SetParentID(0);
+    G4Step* step = new G4Step();
+    step->SetTrack(track);
+    track->SetStep(step);
+    G4StepLimiter limiter;
+    G4StepPoint* pre = step->GetPreStepPoint();
+    pre->SetPosition(G4ThreeVector(1.*mm, 2.*mm, 3.*mm));
+    pre->SetMomentumDirection(G4ThreeVector(0., 0., 1.));
+    pre->SetKineticEnergy(1.*MeV);
+    pre->SetMass(particle->GetMass());
+    pre->SetGlobalTime(1.*ns);
+    pre->SetLocalTime(1.*ns);
+    step->GetPostStepPoint()->SetProcessDefinedStep(&limiter);
+    step->SetTotalEnergyDeposit(10.*keV);
+
+    // Steps per simulated event: the collection is rebuilt per event
+    const long stepsPerEvent = 100;
+    G4HCofThisEvent* hce = nullptr;
+    auto newEvent = [&]() {
+        if (hce) sd->EndOfEvent(hce);
+        delete hce;
+        hce = new G4HCofThisEvent(sdManager->GetCollectionCapacity());
+        sd->Initialize(hce);
+    };
+    newEvent();
+
+    std::printf("%-36s %10s %12s\n", "case", "ns/op", "allocs/op");
+    Print("ProcessHits (100 hits per event)", Measure(ops, [&](long i) {
+        if (i % stepsPerEvent == 0) newEvent();
+        sd->ProcessHits(step, nullptr);
+    }));
+    Print("ProcessHits (no deposit)", Measure(ops, [&](long) {
+        step->SetTotalEnergyDeposit(0.);
+        sd->ProcessHits(step, nullptr);
+        step->SetTotalEnergyDeposit(10.*keV);
+    }));
+    delete hce;
+    hce = nullptr;
+
+    DetectorHit reference;
+    reference.SetParticleName("e-");
+    reference.SetProcessName("StepLimiter");
+    Print("DetectorHit new + delete", Measure(ops, [&](long) {
+        DetectorHit* hit = new DetectorHit();
+        delete hit;
+    }));
+    Print("DetectorHit copy (new)", Measure(ops, [&](long) {
+        DetectorHit* hit = new DetectorHit(reference);
+        delete hit;
+    }));
+
+    Analysis* analysis = Analysis::Instance();
+    analysis->SetOutputDirectory(outputDir);
+    analysis->Book();
+    Print("Analysis::FillH1", Measure(ops, [&](long i) {
+        analysis->FillH1(0, (i % 1000) * 0.01);
+    }));
+    Print("Analysis::FillH2", Measure(ops, [&](long i) {
+        analysis->FillH2(0, (i % 400) - 200., (i % 300) - 150.);
+    }));
+    Print("ntuple row (6 columns)", Measure(ops, [&](long i) {
+        analysis->FillNtupleIColumn(0, G4int(i));
+        analysis->FillNtupleDColumn(1, 1.5);
+        analysis->FillNtupleDColumn(2, 1.);
+        analysis->FillNtupleDColumn(3, 2.);
+        analysis->FillNtupleDColumn(4, 3.);
+        analysis->FillNtupleDColumn(5, 4.);
+        analysis->AddNtupleRow();
+    }));
+    analysis->Save();
+
+    delete step;
+    delete track;
+    return 0;
+}
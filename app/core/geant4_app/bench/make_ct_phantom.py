@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+Write a synthetic CT volume for the voxel phantom benchmarks.
+
+Usage: make_ct_phantom.py [output_dir] [nx ny nz] [voxel_mm]
+
+Produces ct_phantom.hdr and ct_phantom.raw (int16 HU, x fastest): an
+elliptical soft-tissue body with two lungs and a bony spine, in air.
+Also writes ct_activity.hdr and ct_activity.raw (float32, same grid): a
+uniform background uptake in soft tissue and a hot spherical lesion,
+for /geant4api/source/beam/activity.
+"""
+
+import sys
+from pathlib import Path
+
+import numpy as np
+
+
+def main() -> int:
+    out_dir = Path(sys.argv[1]) if len(sys.argv) > 1 else Path(".")
+    nx, ny, nz = (int(v) for v in sys.argv[2:5]) if len(sys.argv) > 4 else (96, 96, 64)
+    voxel = float(sys.argv[5]) if len(sys.argv) > 5 else 3.0
+
+    # Voxel centres in mm, indexed [z, y, x] so that x varies fastest on disk
+    z, y, x = np.meshgrid(
+        (np.arange(nz) - nz / 2 + 0.5) * voxel,
+        (np.arange(ny) - ny / 2 + 0.5) * voxel,
+        (np.arange(nx) - nx / 2 + 0.5) * voxel,
+        indexing="ij",
+    )
+    half_x, half_y = nx * voxel / 2, ny * voxel / 2
+
+    hu = np.full((nz, ny, nx), -1000, dtype=np.int16)
+    body = (x / (0.9 * half_x)) ** 2 + (y / (0.6 * half_y)) ** 2 <= 1.0
+    hu[body] = 40
+    for side in (-1, 1):
+        lung = ((x - side * 0.4 * half_x) / (0.3 * half_x)) ** 2 + (y / (0.4 * half_y)) ** 2 <= 1.0
+        hu[lung] = -800
+    spine = (x / (0.1 * half_x)) ** 2 + ((y - 0.4 * half_y) / (0.1 * half_y)) ** 2 <= 1.0
+    hu[spine] = 700
+    # Small density variations within tissues
+    rng = np.random.default_rng(12345)
+    hu[body] += rng.integers(-20, 21, size=int(body.sum()), dtype=np.int16)
+
+    out_dir.mkdir(parents=True, exist_ok=True)
+    hu.astype("<i2").tofile(out_dir / "ct_phantom.raw")
+    (out_dir / "ct_phantom.hdr").write_text(
+        f"# Synthetic CT phantom\n"
+        f"dimensions {nx} {ny} {nz}\n"
+        f"voxel_size {voxel} {voxel} {voxel}\n"
+        f"data ct_phantom.raw\n"
+    )
+
+    # Activity: background in soft tissue only, lesion 20 times hotter
+    activity = np.zeros((nz, ny, nx), dtype=np.float32)
+    activity[(hu > -100) & (hu < 300)] = 1.0
+    lesion = (x - 0.3 * half_x) ** 2 + (y + 0.2 * half_y) ** 2 + z ** 2 <= (0.1 * half_x) ** 2
+    activity[lesion & body] = 20.0
+    activity.astype("<f4").tofile(out_dir / "ct_activity.raw")
+    (out_dir / "ct_activity.hdr").write_text(
+        f"# Synthetic activity map on the CT grid\n"
+        f"dimensions {nx} {ny} {nz}\n"
+        f"voxel_size {voxel} {voxel} {voxel}\n"
+        f"data ct_activity.raw\n"
+    )
+    print(f"Wrote {nx}x{ny}x{nz} voxels to {out_dir}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""
+Write a synthetic large GDML geometry for the throughput benchmark.
+
+Usage: make_large_gdml.py [output.gdml] [n] [cell_mm]
+
+A cubic grid of n^3 boxes (default 30^3 = 27000 placements) inside an air
+world. Cells cycle through water, compact bone and lung, and all three cell
+volumes are sensitive. Parsing, geometry closing and navigation then scale
+with the number of placements rather than with the physics.
+"""
+
+import sys
+from pathlib import Path
+
+MATERIALS = ["G4_WATER", "G4_BONE_COMPACT_ICRU", "G4_LUNG_ICRP"]
+
+
+def main() -> int:
+    out = Path(sys.argv[1]) if len(sys.argv) > 1 else Path("large_grid.gdml")
+    n = int(sys.argv[2]) if len(sys.argv) > 2 else 30
+    cell = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+    half = n * cell / 2
+    world = 2 * half + 1000.0
+
+    lines = [
+        '<?xml version="1.0" encoding="UTF-8"?>',
+        f"<!-- Synthetic grid of {n}x{n}x{n} cells of {cell} mm (make_large_gdml.py) -->",
+        '<gdml xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance"',
+        '      xsi:noNamespaceSchemaLocation="http://service-spi.web.cern.ch/service-spi/app/releases/GDML/schema/gdml.xsd">',
+        "  <materials/>",
+        "  <solids>",
+        f'    <box name="WorldSolid" x="{world}" y="{world}" z="{world}" lunit="mm"/>',
+        f'    <box name="CellSolid" x="{cell}" y="{cell}" z="{cell}" lunit="mm"/>',
+        "  </solids>",
+        "  <structure>",
+    ]
+    for i, material in enumerate(MATERIALS):
+        lines += [
+            f'    <volume name="Cell{i}">',
+            f'      <materialref ref="{material}"/>',
+            '      <solidref ref="CellSolid"/>',
+            f'      <auxiliary auxtype="SensDet" auxvalue="Cell{i}"/>',
+            "    </volume>",
+        ]
+    lines += ['    <volume name="World">', '      <materialref ref="G4_AIR"/>',
+              '      <solidref ref="WorldSolid"/>']
+    for iz in range(n):
+        for iy in range(n):
+            for ix in range(n):
+                x, y, z = ((i + 0.5) * cell - half for i in (ix, iy, iz))
+                name = f"cell_{ix}_{iy}_{iz}"
+                lines += [
+                    f'      <physvol name="{name}">',
+                    f'        <volumeref ref="Cell{(ix + iy + iz) % len(MATERIALS)}"/>',
+                    f'        <position name="{name}_pos" x="{x}" y="{y}" z="{z}" unit="mm"/>',
+                    "      </physvol>",
+                ]
+    lines += ["    </volume>", "  </structure>", '  <setup name="Default" version="1.0">',
+              '    <world ref="World"/>', "  </setup>", "</gdml>", ""]
+
+    out.parent.mkdir(parents=True, exist_ok=True)
+    out.write_text("\n".join(lines))
+    print(f"Wrote {n ** 3} cells to {out}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,112 @@
+/**
+ * Phase-space source check
+ * ========================
+ * Writes a three-record IAEA file (two histories, one particle going
+ * backwards) and checks that PhaseSpaceSource groups the records into
+ * events by the sign of the energy and takes the sign of w from the
+ * particle type.
+ *
+ * Usage: phsp_check [directory for the test files]
+ */
+
+#include "PhaseSpaceSource.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4UImanager.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Neutron.hh"
+#include "G4Proton.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+G4int failures = 0;
+
+void Check(bool condition, const char* what) {
+    std::printf("%-48s %s\n", what, condition ? "ok" : "FAILED");
+    if (!condition) ++failures;
+}
+
+// type, E [MeV], x, y, z [cm], u, v, weight
+void WriteRecord(std::ofstream& out, std::int8_t type, float energy, float u, float v, float weight) {
+    const float values[] = {energy, 0.f, 0.f, 0.f, u, v, weight};
+    out.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    out.write(reinterpret_cast<const char*>(values), sizeof(values));
+}
+
+G4bool Near(G4double a, G4double b) {
+    return std::abs(a - b) < 1e-6;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string base = std::string(argc > 1 ? argv[1] : ".") + "/phsp_check";
+
+    std::ofstream header(base + ".IAEAheader");
+    header << "$BYTE_ORDER:\n1234\n"
+           << "$RECORD_CONTENTS:\n"
+           << "1 // X is stored ?\n1 // Y is stored ?\n1 // Z is stored ?\n"
+           << "1 // U is stored ?\n1 // V is stored ?\n1 // W is stored ?\n"
+           << "1 // Weight is stored ?\n0 // Extra floats stored ?\n0 // Extra longs stored ?\n"
+           << "$RECORD_LENGTH:\n29\n";
+    header.close();
+
+    // History 1: a gamma going forward and an electron going backwards;
+    // history 2: a proton along the axis
+    std::ofstream records(base + ".IAEAphsp", std::ios::binary);
+    WriteRecord(records, 1, -1.f, 0.6f, 0.f, 1.f);
+    WriteRecord(records, -2, 0.5f, 0.f, 0.6f, 2.f);
+    WriteRecord(records, 5, -10.f, 0.f, 0.f, 1.f);
+    records.close();
+
+    G4Gamma::Definition();
+    G4Electron::Definition();
+    G4Positron::Definition();
+    G4Neutron::Definition();
+    G4Proton::Definition();
+
+    PhaseSpaceSource source;
+    G4UImanager::GetUIpointer()->ApplyCommand("/geant4api/source/phsp/file " + base);
+
+    G4Event first(0);
+    source.GeneratePrimaries(&first);
+    Check(first.GetNumberOfPrimaryVertex() == 2, "first history holds two particles");
+    if (first.GetNumberOfPrimaryVertex() == 2) {
+        const G4PrimaryParticle* gamma = first.GetPrimaryVertex(0)->GetPrimary();
+        const G4PrimaryParticle* electron = first.GetPrimaryVertex(1)->GetPrimary();
+        Check(gamma->GetPDGcode() == 22, "first particle is a gamma");
+        Check(Near(gamma->GetKineticEnergy(), 1.*MeV), "gamma energy is |E|");
+        Check(Near(gamma->GetMomentumDirection().z(), 0.8), "gamma goes forward (w = +0.8)");
+        Check(electron->GetPDGcode() == 11, "second particle is an electron");
+        Check(Near(electron->GetKineticEnergy(), 0.5*MeV), "electron energy is E");
+        Check(Near(electron->GetMomentumDirection().z(), -0.8), "negative type gives w = -0.8");
+        Check(Near(electron->GetWeight(), 2.), "electron keeps its weight");
+    }
+
+    G4Event second(1);
+    source.GeneratePrimaries(&second);
+    Check(second.GetNumberOfPrimaryVertex() == 1, "second history holds one particle");
+    if (second.GetNumberOfPrimaryVertex() == 1) {
+        const G4PrimaryParticle* proton = second.GetPrimaryVertex(0)->GetPrimary();
+        Check(proton->GetPDGcode() == 2212, "second history is the proton");
+        Check(Near(proton->GetKineticEnergy(), 10.*MeV), "proton energy is |E|");
+        Check(Near(proton->GetMomentumDirection().z(), 1.), "proton goes forward (w = +1)");
+    }
+
+    std::remove((base + ".IAEAheader").c_str());
+    std::remove((base + ".IAEAphsp").c_str());
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Throughput vs. accuracy table for the physics presets.
+
+Usage: physics_presets.py <geant4api executable> [preset ...]
+
+Runs every preset on the reference scenarios and prints events/s and the mean
+energy deposited per event. The deviation column is relative to the
+"accurate" preset (FTFP_BERT + EM option4) of the same scenario.
+"""
+
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+BENCH_DIR = Path(__file__).resolve().parent
+
+# name -> (extra arguments, macro)
+SCENARIOS = {
+    "water_gamma_1MeV": ([], "water_gamma.mac"),
+    "water_proton_100MeV": ([], "water_proton.mac"),
+    "bgo_electron_5GeV": (["-g", str(BENCH_DIR / "gdml" / "calorimeter.gdml")], "calorimeter.mac"),
+}
+
+PRESETS = ["fast", "balanced", "accurate", "medical", "lowenergy", "penelope", "shielding"]
+REFERENCE = "accurate"
+
+UNITS = {"eV": 1e-6, "keV": 1e-3, "MeV": 1.0, "GeV": 1e3, "TeV": 1e6}
+
+RATE_RE = re.compile(r"\(([\d.eE+-]+) events/s\)")
+EDEP_RE = re.compile(r"Mean energy per event:\s+([\d.eE+-]+)\s+(\w+)")
+
+
+def run(executable: str, preset: str, args: list, macro: str) -> tuple:
+    """Run one configuration, return (events/s, mean edep in MeV)."""
+    cmd = [executable, "--preset", preset, *args, str(BENCH_DIR / macro)]
+    output = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    rate = RATE_RE.search(output)
+    edep = EDEP_RE.search(output)
+    if not rate or not edep:
+        raise RuntimeError(f"Could not parse output of {' '.join(cmd)}")
+    return float(rate.group(1)), float(edep.group(1)) * UNITS[edep.group(2)]
+
+
+def main() -> int:
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    executable = sys.argv[1]
+    presets = sys.argv[2:] or PRESETS
+    if REFERENCE not in presets:
+        presets.append(REFERENCE)
+
+    print(f"| {'scenario':20} | {'preset':10} | {'events/s':>10} | {'edep/evt [MeV]':>14} | {'dev. vs ' + REFERENCE:>14} |")
+    print(f"|{'-' * 22}|{'-' * 12}|{'-' * 12}|{'-' * 16}|{'-' * 16}|")
+    for scenario, (args, macro) in SCENARIOS.items():
+        results = {preset: run(executable, preset, args, macro) for preset in presets}
+        reference = results[REFERENCE][1]
+        for preset, (rate, edep) in results.items():
+            deviation = (edep - reference) / reference * 100 if reference else 0.0
+            print(f"| {scenario:20} | {preset:10} | {rate:10.1f} | {edep:14.4f} | {deviation:13.2f}% |")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
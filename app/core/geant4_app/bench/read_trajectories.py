@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Decode compact trajectory files (/geant4api/trajectories/enable).
+
+Usage: read_trajectories.py <trajectories_run*.trj> [...] [--json out.json]
+
+Prints per-file totals. With --json, writes all tracks as a list in the
+TrajectoryData shape of app/models/results.py. Directions are those of the
+simplified polyline segments.
+"""
+
+import json
+import math
+import struct
+import sys
+
+MAGIC = b"G4TJ"
+VERSION = 1
+
+
+class Reader:
+    def __init__(self, data: bytes):
+        self.data = data
+        self.pos = 0
+
+    def raw(self, n: int) -> bytes:
+        chunk = self.data[self.pos:self.pos + n]
+        if len(chunk) != n:
+            raise EOFError
+        self.pos += n
+        return chunk
+
+    def varint(self) -> int:
+        value, shift = 0, 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    def signed(self) -> int:
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def float32(self) -> float:
+        return struct.unpack("<f", self.raw(4))[0]
+
+
+def direction(a: list, b: list) -> list:
+    d = [b[i] - a[i] for i in range(3)]
+    norm = math.sqrt(sum(c * c for c in d))
+    return [c / norm for c in d] if norm > 0 else [0.0, 0.0, 0.0]
+
+
+def read_file(path: str) -> tuple:
+    """Return (run, list of TrajectoryData dicts, number of events)."""
+    with open(path, "rb") as f:
+        reader = Reader(f.read())
+
+    if reader.raw(4) != MAGIC:
+        raise ValueError(f"{path}: not a trajectory file")
+    version, run = struct.unpack("<Ii", reader.raw(8))
+    if version != VERSION:
+        raise ValueError(f"{path}: unsupported version {version}")
+    quantum, time_quantum, energy_quantum = (reader.float32() for _ in range(3))
+
+    strings = []
+
+    def string() -> str:
+        index = reader.varint()
+        if index == len(strings):
+            strings.append(reader.raw(reader.varint()).decode())
+        return strings[index]
+
+    tracks, events = [], 0
+    while reader.pos < len(reader.data):
+        length = struct.unpack("<I", reader.raw(4))[0]
+        end = reader.pos + length
+        event_id = reader.varint()
+        for _ in range(reader.varint()):
+            track = {"event_id": event_id, "track_id": reader.varint(), "parent_id": reader.varint()}
+            track["generation"] = reader.varint()
+            track["particle_name"] = string()
+            track["particle_pdg"] = reader.signed()
+            track["initial_energy"] = reader.float32()
+            track["process_name"] = string()
+            track["end_process"] = string() or None
+
+            q = [0, 0, 0, 0, 0]
+            points = []
+            for _ in range(reader.varint()):
+                q = [q[c] + reader.signed() for c in range(5)]
+                points.append({
+                    "x": q[0] * quantum, "y": q[1] * quantum, "z": q[2] * quantum,
+                    "t": q[3] * time_quantum, "kinetic_energy": q[4] * energy_quantum,
+                })
+            for i, point in enumerate(points):
+                a, b = (i, i + 1) if i + 1 < len(points) else (i - 1, i)
+                xyz = [[points[j][k] for k in "xyz"] for j in (a, b)] if len(points) > 1 else None
+                point["momentum_direction"] = direction(*xyz) if xyz else [0.0, 0.0, 0.0]
+            track["points"] = points
+            tracks.append(track)
+        if reader.pos != end:
+            raise ValueError(f"{path}: event {event_id} block length mismatch")
+        events += 1
+    return run, tracks, events
+
+
+def main() -> None:
+    args = sys.argv[1:]
+    out = None
+    if "--json" in args:
+        i = args.index("--json")
+        out = args[i + 1]
+        del args[i:i + 2]
+    if not args:
+        sys.exit(__doc__)
+
+    all_tracks = []
+    for path in args:
+        run, tracks, events = read_file(path)
+        points = sum(len(t["points"]) for t in tracks)
+        print(f"{path}: run {run}, {events} events, {len(tracks)} tracks, {points} points")
+        all_tracks.extend(tracks)
+
+    if out:
+        with open(out, "w") as f:
+            json.dump(all_tracks, f)
+        print(f"Wrote {len(all_tracks)} trajectories to {out}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+End-to-end throughput benchmark (CMake target geant4api_bench).
+
+Usage: run_bench.py <geant4api executable> [options]
+
+  --b2a <exampleB2a>     also run the B2a scenario
+  --threads 1,2,4        thread counts (default: 1 and the number of cores)
+  --out <file.json>      results (default: bench_results.json)
+  --baseline <file>      compare with a stored result file
+  --threshold <percent>  regression threshold (default: 5)
+  --update-baseline      write the results to the baseline file instead
+
+Every scenario has a fixed seed and event count and runs once per thread
+count. Measured: events/s of the event loop, init time (wall time outside
+the event loop), peak RSS of the process and hits/s. Scaling is the rate
+at N threads over N times the rate at one thread. A change is a regression
+when it is worse than the baseline by more than the threshold: lower
+events/s or hits/s, higher init time or peak RSS. The exit status is 1 if
+any regression is flagged.
+"""
+
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+BENCH_DIR = Path(__file__).resolve().parent
+LARGE_GDML_CELLS = 30
+
+# name -> (application, extra arguments, macro)
+SCENARIOS = {
+    "water_gamma_1MeV": ("geant4api", [], BENCH_DIR / "water_gamma.mac"),
+    "water_proton_100MeV": ("geant4api", [], BENCH_DIR / "water_proton.mac"),
+    "b2a_proton_3GeV": ("b2a", [], BENCH_DIR.parent / "B2a" / "bench" / "proton_3GeV.mac"),
+    "large_gdml_gamma_10MeV": ("geant4api", ["-g", "{large_gdml}"], BENCH_DIR / "large_gdml.mac"),
+}
+
+# metric -> True if higher is better
+METRICS = {"events_per_s": True, "hits_per_s": True, "init_s": False, "peak_rss_mb": False}
+
+LOOP_RE = re.compile(r"Event loop time:\s+([\d.eE+-]+) s")
+EVENTS_RE = re.compile(r"/run/beamOn\s+(\d+)")
+HITS_RE = re.compile(r"Hits:\s+(\d+)")
+
+
+def parse_args(argv: list) -> dict:
+    options = {"b2a": None, "threads": None, "out": "bench_results.json",
+               "baseline": None, "threshold": 5.0, "update": False}
+    args = list(argv)
+    positional = []
+    while args:
+        arg = args.pop(0)
+        if arg == "--update-baseline":
+            options["update"] = True
+        elif arg.startswith("--") and args:
+            key = arg[2:]
+            if key not in options:
+                sys.exit(f"Unknown option {arg}\n{__doc__}")
+            options[key] = args.pop(0)
+        else:
+            positional.append(arg)
+    if not positional:
+        sys.exit(__doc__)
+    options["geant4api"] = positional[0]
+    cores = os.cpu_count() or 1
+    options["threads"] = ([int(t) for t in options["threads"].split(",")]
+                          if options["threads"] else sorted({1, cores}))
+    options["threshold"] = float(options["threshold"])
+    return options
+
+
+def run(command: list, threads: int, workdir: Path, log: Path) -> dict:
+    """Run one process and return its measurements."""
+    env = dict(os.environ, G4FORCENUMBEROFTHREADS=str(threads))
+    with open(log, "w") as out:
+        start = time.perf_counter()
+        proc = subprocess.Popen(command, stdout=out, stderr=subprocess.STDOUT,
+                                cwd=workdir, env=env)
+        # wait4 gives the resource usage of this child only
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+    if status != 0:
+        raise RuntimeError(f"{' '.join(command)} failed, see {log}")
+
+    output = log.read_text()
+    loop = LOOP_RE.findall(output)
+    hits = HITS_RE.findall(output)
+    if not loop:
+        raise RuntimeError(f"Could not parse {log}")
+    loop_time = float(loop[-1])
+    events = int(EVENTS_RE.findall(Path(command[-1]).read_text())[-1])
+    rss_kb = usage.ru_maxrss / (1024.0 if sys.platform == "darwin" else 1.0)
+    return {
+        "events": events,
+        "events_per_s": events / loop_time if loop_time > 0 else 0.0,
+        "hits_per_s": int(hits[-1]) / loop_time if hits and loop_time > 0 else 0.0,
+        "init_s": wall - loop_time,
+        "peak_rss_mb": rss_kb / 1024.0,
+    }
+
+
+def compare(results: dict, baseline: dict, threshold: float) -> list:
+    """Return the regressions as printable lines."""
+    regressions = []
+    for scenario, runs in results["scenarios"].items():
+        for threads, values in runs["threads"].items():
+            reference = baseline.get("scenarios", {}).get(scenario, {}).get("threads", {}).get(threads)
+            if not reference:
+                continue
+            for metric, higher_is_better in METRICS.items():
+                old, new = reference.get(metric), values[metric]
+                if not old:
+                    continue
+                change = (new - old) / old * 100
+                if (-change if higher_is_better else change) > threshold:
+                    regressions.append(f"{scenario} ({threads} threads): {metric} "
+                                       f"{old:.4g} -> {new:.4g} ({change:+.1f}%)")
+    return regressions
+
+
+def main() -> int:
+    options = parse_args(sys.argv[1:])
+    executables = {"geant4api": str(Path(options["geant4api"]).resolve()),
+                   "b2a": str(Path(options["b2a"]).resolve()) if options["b2a"] else None}
+
+    results = {
+        "schema": 1,
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cores": os.cpu_count(),
+        "scenarios": {},
+    }
+
+    print(f"| {'scenario':24} | {'threads':>7} | {'events/s':>10} | {'hits/s':>11} | "
+          f"{'init [s]':>8} | {'peak RSS [MB]':>13} | {'scaling':>7} |")
+    print(f"|{'-' * 26}|{'-' * 9}|{'-' * 12}|{'-' * 13}|{'-' * 10}|{'-' * 15}|{'-' * 9}|")
+    with tempfile.TemporaryDirectory() as tmp:
+        workdir = Path(tmp)
+        large_gdml = workdir / "large_grid.gdml"
+        subprocess.run([sys.executable, str(BENCH_DIR / "make_large_gdml.py"), str(large_gdml),
+                        str(LARGE_GDML_CELLS)], check=True, stdout=subprocess.DEVNULL)
+
+        for scenario, (app, extra, macro) in SCENARIOS.items():
+            executable = executables[app]
+            if not executable:
+                print(f"| {scenario:24} | skipped (no --b2a executable)")
+                continue
+            runs = {}
+            for threads in options["threads"]:
+                outdir = workdir / f"{scenario}_t{threads}"
+                outdir.mkdir()
+                args = [a.format(large_gdml=large_gdml) for a in extra]
+                if app == "geant4api":
+                    args = ["-t", str(threads), "-o", str(outdir)] + args
+                command = [executable] + args + [str(macro)]
+                values = run(command, threads, outdir, workdir / f"{scenario}_t{threads}.log")
+                single = runs.get("1", {}).get("events_per_s")
+                values["scaling"] = (values["events_per_s"] / (threads * single)
+                                     if single else None)
+                runs[str(threads)] = values
+                scaling = f"{values['scaling']:7.2f}" if values["scaling"] else f"{'-':>7}"
+                print(f"| {scenario:24} | {threads:7d} | {values['events_per_s']:10.1f} | "
+                      f"{values['hits_per_s']:11.4g} | {values['init_s']:8.2f} | "
+                      f"{values['peak_rss_mb']:13.1f} | {scaling} |")
+            results["scenarios"][scenario] = {"macro": macro.name, "threads": runs}
+
+    Path(options["out"]).write_text(json.dumps(results, indent=2) + "\n")
+    print(f"Wrote {options['out']}")
+
+    baseline_file = Path(options["baseline"]) if options["baseline"] else None
+    if baseline_file and options["update"]:
+        baseline_file.write_text(json.dumps(results, indent=2) + "\n")
+        print(f"Updated baseline {baseline_file}")
+        return 0
+    if not baseline_file:
+        return 0
+    if not baseline_file.exists():
+        print(f"No baseline at {baseline_file}; create one with --update-baseline")
+        return 0
+
+    regressions = compare(results, json.loads(baseline_file.read_text()), options["threshold"])
+    if regressions:
+        print(f"Regressions above {options['threshold']}% against {baseline_file}:")
+        for line in regressions:
+            print(f"  {line}")
+        return 1
+    print(f"No regression above {options['threshold']}% against {baseline_file}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,108 @@
+/**
+ * Detector statistics check
+ * =========================
+ * Checks the two merges of DetectorStats on a million exponential values
+ * (fixed seed): Moments::Merge of per-thread moments against one pass over
+ * all values, and TDigest quantiles, from one digest and from per-thread
+ * digests merged as at the end of a run, against the exact quantiles.
+ * Prints the relative quantile errors; fails when one exceeds the bound
+ * stated in TDigest.hh.
+ *
+ * Usage: stats_check [values]
+ */
+
+#include "DetectorStats.hh"
+#include "TDigest.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+const G4double kQuantiles[] = {0.05, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999};
+// Relative quantile error allowed from the 5th to the 99.9th percentile
+const G4double kBound = 0.02;
+
+G4int failures = 0;
+
+void Check(bool condition, const char* what) {
+    std::printf("%-52s %s\n", what, condition ? "ok" : "FAILED");
+    if (!condition) ++failures;
+}
+
+G4bool Near(G4double a, G4double b) {
+    return std::abs(a - b) <= 1e-9 * std::max(1., std::abs(b));
+}
+
+// Largest relative error of the digest over kQuantiles, printed per quantile
+G4double QuantileError(const char* name, TDigest& digest, const std::vector<G4double>& sorted) {
+    G4double worst = 0.;
+    std::printf("%-14s", name);
+    for (G4double q : kQuantiles) {
+        G4double exact = sorted[std::size_t(q * (sorted.size() - 1))];
+        G4double error = std::abs(digest.Quantile(q) - exact) / exact;
+        worst = std::max(worst, error);
+        std::printf(" %7.3f%%", 100. * error);
+    }
+    std::printf("   (%zu centroids)\n", digest.GetCentroids().size());
+    return worst;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::size_t nofValues = argc > 1 ? std::size_t(std::atol(argv[1])) : 1000000;
+    std::mt19937_64 engine(12345);
+    std::exponential_distribution<G4double> exponential(1.);
+    std::vector<G4double> values(nofValues);
+    for (G4double& value : values) value = exponential(engine);
+
+    // Moments: one pass, and four threads' moments merged
+    DetectorStats::Moments whole;
+    DetectorStats::Moments threads[4];
+    for (std::size_t i = 0; i < nofValues; i++) {
+        whole.Add(values[i]);
+        threads[i % 4].Add(values[i]);
+    }
+    DetectorStats::Moments merged;
+    for (const DetectorStats::Moments& moments : threads) merged.Merge(moments);
+    DetectorStats::Moments empty;
+    merged.Merge(empty);
+    Check(merged.count == whole.count, "merged moments: count");
+    Check(Near(merged.mean, whole.mean), "merged moments: mean");
+    Check(Near(merged.m2, whole.m2), "merged moments: M2");
+    Check(merged.min == whole.min && merged.max == whole.max, "merged moments: min and max");
+
+    std::vector<G4double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+
+    std::printf("%-14s", "quantile");
+    for (G4double q : kQuantiles) std::printf(" %8.3f", q);
+    std::printf("\n");
+
+    TDigest single;
+    for (G4double value : values) single.Add(value);
+    G4double singleError = QuantileError("one digest", single, sorted);
+
+    G4double mergedError[2] = {0., 0.};
+    const G4int kThreads[2] = {2, 8};
+    for (G4int k = 0; k < 2; k++) {
+        std::vector<TDigest> digests(kThreads[k]);
+        for (std::size_t i = 0; i < nofValues; i++) digests[i % kThreads[k]].Add(values[i]);
+        TDigest digest;
+        for (const TDigest& part : digests) digest.Merge(part);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%d merged", kThreads[k]);
+        mergedError[k] = QuantileError(name, digest, sorted);
+    }
+
+    Check(singleError <= kBound, "one digest within 2 %");
+    Check(std::max(mergedError[0], mergedError[1]) <= kBound, "merged digests within 2 %");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/**
+ * Woodcock tracking check
+ * =======================
+ * Narrow beam through a layered slab (four materials, mu from 0.005 to
+ * 0.05 /mm): flights sampled by WoodcockModel::SampleDistance with the
+ * largest mu. Checks the transmitted fraction against exp(-sum mu x) and
+ * the fraction of first interactions in each layer against the difference
+ * of the transmissions at its faces, within five standard deviations.
+ *
+ * Usage: woodcock_check [photons]
+ */
+
+#include "WoodcockModel.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// Thickness and attenuation coefficient of each layer, in beam order
+const G4double kThickness[] = {20.*mm, 10.*mm, 30.*mm, 20.*mm};
+const G4double kMu[] = {0.02/mm, 0.05/mm, 0.005/mm, 0.02/mm};
+const G4int kLayers = 4;
+
+G4int failures = 0;
+
+void Check(bool condition, const char* what) {
+    std::printf("%-52s %s\n", what, condition ? "ok" : "FAILED");
+    if (!condition) ++failures;
+}
+
+G4int Layer(G4double s) {
+    G4int layer = 0;
+    while (layer < kLayers - 1 && s >= kThickness[layer]) s -= kThickness[layer++];
+    return layer;
+}
+
+// Observed fraction within five binomial standard deviations of expected
+G4bool Agrees(const char* name, G4long count, G4long n, G4double expected) {
+    G4double observed = G4double(count) / n;
+    G4double sigma = std::sqrt(expected * (1. - expected) / n);
+    std::printf("%-14s %9.6f  expected %9.6f  (%+.2f sigma)\n", name, observed, expected,
+                (observed - expected) / sigma);
+    return std::abs(observed - expected) <= 5. * sigma;
+}
+
+}
+
+int main(int argc, char** argv) {
+    G4long nofPhotons = argc > 1 ? std::atol(argv[1]) : 1000000;
+    CLHEP::HepRandom::setTheSeed(12345);
+
+    G4double length = 0.;
+    G4double muMax = 0.;
+    for (G4int i = 0; i < kLayers; i++) {
+        length += kThickness[i];
+        muMax = std::max(muMax, kMu[i]);
+    }
+    auto mu = [](G4double s) { return kMu[Layer(s)]; };
+
+    G4long transmitted = 0;
+    G4long interactions[kLayers] = {0, 0, 0, 0};
+    for (G4long n = 0; n < nofPhotons; n++) {
+        G4double s = WoodcockModel::SampleDistance(length, muMax, mu);
+        if (s >= length) transmitted++;
+        else interactions[Layer(s)]++;
+    }
+
+    // Transmission through the faces of the layers
+    G4double faces[kLayers + 1] = {1.};
+    for (G4int i = 0; i < kLayers; i++) faces[i+1] = faces[i] * std::exp(-kMu[i] * kThickness[i]);
+
+    G4bool layers = true;
+    for (G4int i = 0; i < kLayers; i++) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "layer %d", i);
+        layers = Agrees(name, interactions[i], nofPhotons, faces[i] - faces[i+1]) && layers;
+    }
+    G4bool transmission = Agrees("transmitted", transmitted, nofPhotons, faces[kLayers]);
+
+    Check(layers, "first interactions per layer");
+    Check(transmission, "transmission exp(-sum mu x)");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
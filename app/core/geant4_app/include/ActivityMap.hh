@@ -0,0 +1,73 @@
+/**
+ * Activity Map
+ * ============
+ * Voxelised activity distribution (SPECT/PET-derived volume) for internal
+ * emitters, described by a header in the format of the CT phantom:
+ *
+ *   dimensions 128 128 100
+ *   voxel_size 2.0 2.0 2.5      (mm)
+ *   data       activity.raw     (float32 per voxel, x fastest)
+ *
+ * Only voxels with positive activity are kept, as a linear voxel index
+ * and an alias-table entry, so memory scales with the active voxels. A
+ * draw picks a voxel with probability proportional to its activity in
+ * O(1) and a point uniformly inside it. The grid is centred on the origin
+ * of the caller's frame, like the voxel phantom in the world.
+ *
+ * Maps are read-only after loading and shared by all threads that load
+ * the same header.
+ */
+
+#ifndef ActivityMap_h
+#define ActivityMap_h 1
+
+#include "AliasTable.hh"
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ActivityMap {
+public:
+    // Loads the map once per process; fatal on error
+    static std::shared_ptr<const ActivityMap> Load(const G4String& headerFile);
+
+    std::size_t GetNofActiveVoxels() const { return fVoxels.size(); }
+    G4double GetTotalActivity() const { return fTable.GetTotalWeight(); }
+
+    // Point in the grid frame; u1..u5 uniform in [0, 1)
+    inline G4ThreeVector Sample(G4double u1, G4double u2,
+                                G4double u3, G4double u4, G4double u5) const;
+
+private:
+    ActivityMap(const G4String& headerFile);
+    void ReadHeader();
+    void ReadData();
+
+    G4String fHeaderFile;
+    G4String fDataFile;
+    G4int fNVoxels[3];
+    G4double fVoxelSize[3];
+    G4ThreeVector fCorner;
+
+    // Linear index (x fastest) of every active voxel, same order as fTable
+    std::vector<std::uint32_t> fVoxels;
+    AliasTable fTable;
+};
+
+inline G4ThreeVector ActivityMap::Sample(G4double u1, G4double u2,
+                                         G4double u3, G4double u4, G4double u5) const {
+    std::uint32_t index = fVoxels[fTable.Sample(u1, u2)];
+    std::uint32_t ix = index % std::uint32_t(fNVoxels[0]);
+    index /= std::uint32_t(fNVoxels[0]);
+    std::uint32_t iy = index % std::uint32_t(fNVoxels[1]);
+    std::uint32_t iz = index / std::uint32_t(fNVoxels[1]);
+    return fCorner + G4ThreeVector((ix + u3) * fVoxelSize[0],
+                                   (iy + u4) * fVoxelSize[1],
+                                   (iz + u5) * fVoxelSize[2]);
+}
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * Alias Table
+ * ===========
+ * Walker/Vose alias method: after an O(n) build from non-negative weights,
+ * every draw costs one table lookup and one comparison, whatever the
+ * number of entries.
+ */
+
+#ifndef AliasTable_h
+#define AliasTable_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class AliasTable {
+public:
+    AliasTable();
+
+    // Returns false (and leaves the table empty) if no weight is positive
+    G4bool Build(const std::vector<G4double>& weights);
+
+    G4bool IsEmpty() const { return fEntries.empty(); }
+    std::size_t GetSize() const { return fEntries.size(); }
+    G4double GetTotalWeight() const { return fTotal; }
+
+    // Index drawn with probability weight/total; u1, u2 uniform in [0, 1)
+    std::size_t Sample(G4double u1, G4double u2) const {
+        std::size_t i = std::size_t(u1 * fEntries.size());
+        if (i >= fEntries.size()) i = fEntries.size() - 1;
+        const Entry& entry = fEntries[i];
+        return u2 < entry.probability ? i : entry.alias;
+    }
+
+private:
+    // Kept together so that a draw touches one cache line
+    struct Entry {
+        G4double probability;
+        std::uint32_t alias;
+    };
+
+    std::vector<Entry> fEntries;
+    G4double fTotal;
+};
+
+#endif
@@ -16,6 +16,10 @@
 #include <map>
 
 class G4GDMLParser;
+class G4GenericMessenger;
+class G4Region;
+struct G4GDMLAuxStructType;
+class VoxelPhantom;
 
 class DetectorConstruction : public G4VUserDetectorConstruction {
 public:
@@ -30,18 +34,46 @@ public:
     G4LogicalVolume* GetWorldLogical() const { return fWorldLogical; }
     const std::vector<G4String>& GetSensitiveVolumes() const { return fSensitiveVolumes; }
     
+    // Voxelised CT phantom replacing the default water box
+    void SetCTHeader(const G4String& headerFile) { fCTHeader = headerFile; }
+    void SetPhantomNavigation(const G4String& mode);
+    void SetDensityStep(G4double step) { fDensityStep = step; }
+    // Delta tracking of photons in the phantom (needs the fastsim builder)
+    void SetWoodcock(G4bool enable) { fWoodcock = enable; }
+    
 private:
     void ConstructDefaultGeometry();
+    void ConstructVoxelPhantom();
+    void AddSensitiveVolume(const G4String& name, G4LogicalVolume* lv);
     void LoadGDML();
     void FindSensitiveVolumes(G4LogicalVolume* lv);
     
+    // Regions with their own production cuts and user limits, built from
+    // Region / ProductionCut / MaxStep ... auxiliary tags on GDML volumes
+    void ConstructRegions();
+    G4bool ApplyRegionAuxiliary(G4Region* region, const G4GDMLAuxStructType& aux);
+    
+    // Envelopes for the parameterised shower model (FastShower auxiliary tag)
+    void ConstructFastShowerEnvelopes();
+    
     G4String fGdmlFile;
     G4GDMLParser* fParser;
     G4LogicalVolume* fWorldLogical;
     G4VPhysicalVolume* fWorldPhysical;
     
     std::vector<G4String> fSensitiveVolumes;
-    std::map<G4String, G4LogicalVolume*> fLogicalVolumes;
+    std::map<G4String, std::vector<G4LogicalVolume*>> fLogicalVolumes;
+    
+    // Fast shower envelope regions and their trigger thresholds
+    std::vector<std::pair<G4Region*, G4double>> fFastShowerEnvelopes;
+    
+    G4GenericMessenger* fMessenger;
+    G4String fCTHeader;
+    G4bool fRegularNavigation;
+    G4double fDensityStep;
+    G4bool fWoodcock;
+    VoxelPhantom* fVoxelPhantom;
+    G4Region* fWoodcockEnvelope;
 };
 
 #endif
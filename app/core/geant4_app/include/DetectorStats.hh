@@ -0,0 +1,90 @@
+/**
+ * Detector Statistics
+ * ===================
+ * Running statistics of the energy deposited per event in each sensitive
+ * detector, kept in constant memory whatever the number of events. For
+ * every event with hits in a detector, the weighted sum of its deposits
+ * [MeV] goes into Welford moments (count, mean, M2, min, max) and into a
+ * t-digest for quantiles.
+ *
+ * Each thread keeps its own statistics. At the end of the run they are
+ * merged by detector name: moments with Chan's pairwise formula, digests
+ * by merging their centroids. The master prints the summary, writes it
+ * as one "METRICS {"record": "detectors", ...}" line for the REST API,
+ * and writes it with the digest centroids to
+ * <output>/detector_stats_run<R>.json. The number of events of the run
+ * is included, so statistics over all events, zeros included, follow
+ * from the moments alone.
+ */
+
+#ifndef DetectorStats_h
+#define DetectorStats_h 1
+
+#include "TDigest.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+class G4GenericMessenger;
+class G4HCofThisEvent;
+
+class DetectorStats {
+public:
+    // Numerically stable running moments
+    struct Moments {
+        G4long count = 0;
+        G4double mean = 0.;
+        G4double m2 = 0.;
+        G4double min = std::numeric_limits<G4double>::max();
+        G4double max = std::numeric_limits<G4double>::lowest();
+
+        void Add(G4double value) {
+            count += 1;
+            G4double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        void Merge(const Moments& other) {
+            if (other.count == 0) return;
+            G4long total = count + other.count;
+            G4double delta = other.mean - mean;
+            mean += delta * other.count / total;
+            m2 += other.m2 + delta * delta * G4double(count) * other.count / total;
+            count = total;
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+        }
+    };
+
+    DetectorStats();
+    ~DetectorStats();
+
+    void BeginOfRun();
+    // Every complete event, with or without hits
+    void AddEvent(G4HCofThisEvent* hce);
+    // Merges this thread's statistics; the master then reports the run
+    void EndOfRun(const G4String& outputDir, G4int runID);
+
+private:
+    struct Detector {
+        G4String name;
+        G4long hits = 0;
+        Moments edep;
+        TDigest digest;
+    };
+
+    void Report(const G4String& outputDir, G4int runID) const;
+
+    G4double fCompression;
+    G4long fNofEvents;
+    // Indexed by hits collection ID
+    std::vector<Detector> fDetectors;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -6,8 +6,11 @@
 #define EventAction_h 1
 
 #include "G4UserEventAction.hh"
+#include "Timeline.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class RunAction;
 
 class EventAction : public G4UserEventAction {
@@ -23,6 +26,10 @@ public:
 private:
     RunAction* fRunAction;
     G4double fEdep;
+    // Start of the event, for the timeline
+    Timeline::Clock::time_point fStart;
+    // Summed deposit per hits collection ID for the trigger, reused between events
+    std::vector<G4double> fDetectorEdep;
 };
 
 #endif
@@ -0,0 +1,117 @@
+/**
+ * Event Guard
+ * ===========
+ * Bounds the time a single track or event can take, so that a low-energy
+ * looper or a pathological spot of the geometry cannot hold up the run.
+ * Three limits, each off at 0 (/geant4api/guard/):
+ *
+ * - trackSteps: steps of one track; trackAction kills the track (default),
+ *   aborts the event, or flags the track and lets it continue.
+ * - eventSteps: steps of all tracks of one event;
+ * - eventTime: CPU time of one event [s], measured on the thread every
+ *   1024 steps; eventAction aborts the event (default) or flags it.
+ *
+ * Every trigger is written as a "LOG warning guard" record with the event,
+ * volume, particle and step count, and counted per limit and volume. At
+ * the end of the run the counts of all threads are merged and the master
+ * prints them with the first events concerned and the slowest event of
+ * the run. Aborted events count in the run but add nothing to the
+ * histograms or the ntuple.
+ */
+
+#ifndef EventGuard_h
+#define EventGuard_h 1
+
+#include "globals.hh"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+class G4GenericMessenger;
+class G4Step;
+class LogSink;
+
+class EventGuard {
+public:
+    enum Limit { kTrackSteps, kEventSteps, kEventTime, kNofLimits };
+    enum Action { kKill, kAbort, kFlag };
+
+    explicit EventGuard(LogSink* log);
+    ~EventGuard();
+
+    G4bool IsActive() const { return fActive; }
+
+    void BeginOfRun();
+    // Merges this thread's counts; the master then reports the run
+    void EndOfRun();
+
+    void BeginOfEvent(G4int eventID);
+    void EndOfEvent();
+    void BeginTrack() {
+        fTrackSteps = 0;
+        fTrackTriggered = false;
+    }
+
+    void AddStep(const G4Step* step) {
+        fTrackSteps += 1;
+        fEventSteps += 1;
+        if (fMaxTrackSteps > 0 && fTrackSteps > fMaxTrackSteps && !fTrackTriggered) {
+            Trigger(kTrackSteps, step);
+        }
+        if (fMaxEventSteps > 0 && fEventSteps > fMaxEventSteps && !(fEventTriggered & (1 << kEventSteps))) {
+            Trigger(kEventSteps, step);
+        }
+        if (fMaxEventTime > 0. && (fEventSteps & 1023) == 0 && !(fEventTriggered & (1 << kEventTime)) &&
+            CpuSeconds() - fEventStart > fMaxEventTime) {
+            Trigger(kEventTime, step);
+        }
+    }
+
+    // CPU time of the calling thread [s]
+    static G4double CpuSeconds();
+
+    // /geant4api/guard/trackAction and eventAction
+    void SetTrackAction(const G4String& action);
+    void SetEventAction(const G4String& action);
+
+private:
+    // Triggers of one limit in one volume
+    struct Count {
+        G4long triggers = 0;
+        std::vector<G4int> events;
+    };
+
+    void Trigger(Limit limit, const G4Step* step);
+    void Report() const;
+
+    LogSink* fLog;
+    G4bool fActive;
+
+    G4int fMaxTrackSteps;
+    G4int fMaxEventSteps;
+    G4double fMaxEventTime;
+    Action fTrackAction;
+    Action fEventAction;
+
+    G4int fEventID;
+    G4long fTrackSteps;
+    G4long fEventSteps;
+    G4double fEventStart;
+    G4bool fTrackTriggered;
+    G4int fEventTriggered;
+    G4bool fEventAborted;
+
+    std::map<std::pair<G4int, G4String>, Count> fCounts;
+    G4long fNofKilledTracks;
+    G4double fKilledEnergy;
+    G4long fNofAbortedEvents;
+    // Slowest event of this thread: CPU time, steps, ID
+    G4double fSlowestTime;
+    G4long fSlowestSteps;
+    G4int fSlowestEvent;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Event Recorder
+ * ==============
+ * Makes every event reproducible on its own. Before the primaries are
+ * generated, two 32-bit seeds are drawn from the running engine and the
+ * engine is reseeded with them, so an event depends only on its seeds and
+ * the configuration. Seeds and primary vertex are written per event (24
+ * bytes) to <output>/events_run<R>[_t<thread>].rec.
+ *
+ * In replay mode (geant4api --replay <run>:<event>) the seeds of the chosen
+ * event are read back and applied to a single event instead.
+ */
+
+#ifndef EventRecorder_h
+#define EventRecorder_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <fstream>
+
+class G4Event;
+class G4GenericMessenger;
+
+class EventRecorder {
+public:
+    // Fixed-size record, one per event
+    struct Record {
+        std::int32_t eventID;
+        std::uint32_t seeds[2];
+        float vertex[3];            // mm
+    };
+
+    EventRecorder();
+    ~EventRecorder();
+
+    // Opens this thread's record file; the master and replays record nothing
+    void BeginOfRun(const G4String& outputDir, G4int runID);
+    void EndOfRun();
+
+    // Reseeds the engine for this event (recorded or replayed seeds)
+    void SeedEvent(G4int eventID);
+    // Writes the record once the primary vertex exists
+    void RecordEvent(const G4Event* event);
+
+    // Replay configuration, set once from main before the run manager starts
+    static void SetReplay(G4int runID, G4int eventID);
+    static G4bool IsReplay() { return fgReplay; }
+    static G4int GetReplayRun() { return fgReplayRun; }
+    static G4int GetReplayEvent() { return fgReplayEvent; }
+    // Finds the record of the replayed event among the thread files of its run
+    static G4bool LoadReplay(const G4String& outputDir);
+    static const Record& GetReplayRecord() { return fgReplayRecord; }
+
+private:
+    static G4String FileName(const G4String& outputDir, G4int runID, G4int thread);
+
+    G4bool fEnabled;
+    std::ofstream fFile;
+    Record fCurrent;
+
+    G4GenericMessenger* fMessenger;
+
+    static G4bool fgReplay;
+    static G4int fgReplayRun;
+    static G4int fgReplayEvent;
+    static Record fgReplayRecord;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Event Trigger
+ * =============
+ * End-of-event selection applied before the detailed outputs (ntuple rows,
+ * per-event printout). The caller passes the summed deposit of each
+ * detector; a detector counts as hit when its deposit exceeds the
+ * threshold. Detectors are named in the commands and mapped to indices of
+ * the deposits by the index function given at construction: sensitive
+ * volumes by hits collection here, chamber numbers in B2a (/B2a/trigger/).
+ *
+ *   /geant4api/trigger/minDetectors 2
+ *   /geant4api/trigger/edepWindow Crystal 0.5 2 MeV
+ *   /geant4api/trigger/edepWindow all 1 10 MeV
+ *   /geant4api/trigger/coincidence Scint1 Scint2
+ *
+ * An event is accepted when it passes every configured condition; without
+ * conditions every event is accepted.
+ */
+
+#ifndef EventTrigger_h
+#define EventTrigger_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+class EventTrigger {
+public:
+    // Index of a named detector in the deposits passed to Accept; negative
+    // when there is no such detector
+    using DetectorIndex = G4int (*)(const G4String& detector);
+
+    // Commands go to directory; edepWindow bounds without a unit are in defaultUnit
+    EventTrigger(const G4String& directory, const G4String& defaultUnit, DetectorIndex index);
+    ~EventTrigger();
+
+    G4bool IsActive() const;
+    // Summed deposit per detector index
+    G4bool Accept(const std::vector<G4double>& edep);
+
+    void Print() const;
+
+private:
+    static constexpr G4int kAll = -1;
+
+    // Deposit window [min, max) on one detector, or on all of them (kAll)
+    struct EdepWindow {
+        G4String detector;
+        G4double min;
+        G4double max;
+        G4int index;
+    };
+    // All listed detectors hit in the same event
+    struct Coincidence {
+        std::vector<G4String> detectors;
+        std::vector<G4int> indices;
+    };
+
+    void SetMinDetectors(G4int n) { fMinDetectors = n; }
+    void AddEdepWindow(const G4String& args);
+    void AddCoincidence(const G4String& args);
+    void Clear();
+
+    // Maps detector names to indices on this thread
+    void Resolve();
+    G4int Index(const G4String& detector) const;
+
+    G4String fDefaultUnit;
+    DetectorIndex fIndex;
+
+    G4int fMinDetectors;
+    G4double fHitThreshold;
+    std::vector<EdepWindow> fWindows;
+    std::vector<Coincidence> fCoincidences;
+    G4bool fResolved;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
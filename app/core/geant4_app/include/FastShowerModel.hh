@@ -0,0 +1,47 @@
+/**
+ * Fast Shower Model
+ * =================
+ * Parameterised EM shower for calorimeter-like envelopes. Electrons,
+ * positrons and photons above a threshold are killed and their energy is
+ * deposited as spots drawn from a Grindhammer-style longitudinal gamma
+ * profile and a two-component radial profile.
+ */
+
+#ifndef FastShowerModel_h
+#define FastShowerModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "globals.hh"
+
+class G4FastSimHitMaker;
+class G4Material;
+
+class FastShowerModel : public G4VFastSimulationModel {
+public:
+    FastShowerModel(const G4String& name, G4Region* envelope, G4double threshold);
+    virtual ~FastShowerModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle) override;
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack) override;
+    virtual void DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) override;
+
+    void SetThreshold(G4double threshold) { fThreshold = threshold; }
+    void SetSpotEnergy(G4double energy) { fSpotEnergy = energy; }
+
+private:
+    // Shower parameters of the envelope material
+    struct MaterialParameters {
+        G4double radLength;
+        G4double moliereRadius;
+        G4double criticalEnergy;
+    };
+    MaterialParameters GetParameters(const G4Material* material) const;
+
+    G4double fThreshold;
+    G4double fSpotEnergy;
+    G4int fMinSpots;
+
+    G4FastSimHitMaker* fHitMaker;
+};
+
+#endif
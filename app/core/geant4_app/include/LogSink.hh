@@ -0,0 +1,96 @@
+/**
+ * Log Sink
+ * ========
+ * Per-thread log for messages written from the event loop. Records have a
+ * severity and a tag, followed by key=value fields, one per line:
+ *
+ *   LOG info progress event=1200
+ *   LOG info event event=1234 edep_mev=0.53 suppressed=17
+ *
+ * Records below the level set with /geant4api/log/level cost one
+ * comparison. Each tag is limited to /geant4api/log/rate records per
+ * second and thread; the number dropped since the last record of the tag
+ * is added to the next one as "suppressed". Lines collect in a buffer of
+ * the thread and reach G4cout in one write when the buffer is full, half
+ * a second after the last write, for every warning or error, and at the
+ * end of the run. The REST API parses these records (geant4_executor.py).
+ * The B2a example builds this same class, with its commands in /B2a/log/.
+ */
+
+#ifndef LogSink_h
+#define LogSink_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+class G4GenericMessenger;
+
+class LogSink {
+public:
+    enum Level { kDebug, kInfo, kWarning, kError };
+
+    // Formats the fields of one record, committed at the end of the statement;
+    // does nothing when the record is filtered out
+    class Record {
+    public:
+        explicit Record(LogSink* sink) : fSink(sink) {}
+        Record(Record&& other) : fSink(other.fSink) { other.fSink = nullptr; }
+        ~Record() { if (fSink) fSink->Commit(); }
+        Record(const Record&) = delete;
+        Record& operator=(const Record&) = delete;
+
+        Record& Add(const char* key, G4int value) { if (fSink) fSink->AddField(key, G4long(value)); return *this; }
+        Record& Add(const char* key, G4long value) { if (fSink) fSink->AddField(key, value); return *this; }
+        Record& Add(const char* key, G4double value) { if (fSink) fSink->AddField(key, value); return *this; }
+        Record& Add(const char* key, const G4String& value) { if (fSink) fSink->AddField(key, value); return *this; }
+
+    private:
+        LogSink* fSink;
+    };
+
+    // Commands go to directory (level, rate)
+    explicit LogSink(const G4String& directory = "/geant4api/log/");
+    ~LogSink();
+
+    // Tags are string literals (one rate limit each)
+    Record Log(Level level, const char* tag) {
+        return Record(level >= fLevel && Begin(level, tag) ? this : nullptr);
+    }
+    void Flush();
+    std::size_t GetBufferedBytes() const { return fBuffer.capacity(); }
+
+    // <directory>level
+    void SetLevel(const G4String& level);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Rate limit of one tag: tokens refill at fRate per second, up to fRate
+    struct Bucket {
+        G4double tokens;
+        Clock::time_point last;
+        G4long suppressed;
+    };
+
+    G4bool Begin(Level level, const char* tag);
+    void AddField(const char* key, G4long value);
+    void AddField(const char* key, G4double value);
+    void AddField(const char* key, const G4String& value);
+    void Commit();
+
+    Level fLevel;
+    G4double fRate;
+    std::unordered_map<const char*, Bucket> fBuckets;
+
+    std::string fBuffer;
+    Level fRecordLevel;
+    G4long fRecordSuppressed;
+    Clock::time_point fLastFlush;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Memory Watchdog
+ * ===============
+ * Keeps the process within the resident memory budget set with
+ * /geant4api/memory/budget (MB; 0, the default, disables the watchdog).
+ * During a run a thread of the master samples the resident size every
+ * /geant4api/memory/interval ms, together with the sizes each event loop
+ * thread publishes: the hit collections of its last event, its buffered
+ * output (trajectory block, log, timeline spans) and its track stack.
+ *
+ * The event loop degrades in steps as memory grows:
+ *
+ * - softLimit (fraction of the budget): every thread flushes its output
+ *   buffers once, compact trajectories are no longer recorded, and event
+ *   summaries are no longer logged, until memory is back below 95 % of
+ *   the soft limit.
+ * - pauseLimit: workers other than the first wait before their next event
+ *   until memory is below the pause limit again, at most maxPause seconds
+ *   per event, so that fewer large events are in flight at once.
+ * - budget: the events in flight are aborted and the run ends like any
+ *   aborted run, with histograms, ntuple, event records and run manifest
+ *   written. The process then exits with status kExitStatus.
+ *
+ * Each change of step is written as a "LOG warning memory" record with
+ * the resident size and the component sizes (MB).
+ */
+
+#ifndef MemoryWatchdog_h
+#define MemoryWatchdog_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class G4GenericMessenger;
+class Timeline;
+
+class MemoryWatchdog {
+public:
+    enum Level { kNormal, kDegraded, kPaused, kExceeded };
+    enum Component { kHits, kOutput, kStacks, kNofComponents };
+
+    // Exit status after the budget was exceeded (EX_TEMPFAIL)
+    static const int kExitStatus = 75;
+
+    MemoryWatchdog();
+    ~MemoryWatchdog();
+
+    // The master starts and stops the sampling thread; every thread
+    // registers the sizes it publishes
+    void BeginOfRun();
+    void EndOfRun();
+
+    // Workers wait here while the watchdog pauses them
+    void BeginOfEvent(Timeline* timeline);
+    // True once after the watchdog asked the threads to flush their buffers
+    G4bool FlushRequested() {
+        G4int generation = fgFlushGeneration.load(std::memory_order_relaxed);
+        if (generation == fFlushSeen) return false;
+        fFlushSeen = generation;
+        return true;
+    }
+
+    // Size of a component of the calling thread [bytes]
+    static void Publish(Component component, std::size_t bytes) {
+        if (fgSlot) fgSlot->bytes[component].store(bytes, std::memory_order_relaxed);
+    }
+    static Level GetLevel() { return Level(fgLevel.load(std::memory_order_relaxed)); }
+    static G4bool IsDegraded() { return GetLevel() >= kDegraded; }
+    static G4bool IsExceeded() { return GetLevel() == kExceeded; }
+
+    // Master, after the outputs of the run are written: ends the process
+    // with kExitStatus if the budget was exceeded
+    static void ExitIfExceeded();
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> bytes[kNofComponents];
+    };
+
+    // Sampling thread of the master
+    void Watch();
+    // Writes straight to stdout: G4cout belongs to the Geant4 threads
+    void Report(Level level, G4double residentMB) const;
+
+    G4double fBudget;         // MB
+    G4double fSoftLimit;
+    G4double fPauseLimit;
+    G4int fInterval;          // ms
+    G4double fMaxPause;       // s
+    G4int fFlushSeen;
+
+    std::thread fThread;
+    std::mutex fStopMutex;
+    std::condition_variable fStopCondition;
+    G4bool fStop;
+
+    static std::atomic<G4int> fgLevel;
+    static std::atomic<G4int> fgFlushGeneration;
+    static std::atomic<G4long> fgNofPausedEvents;
+    static G4double fgPeakMB;
+    static Level fgHighestLevel;
+    static G4double fgBudgetMB;
+    // One slot per thread that ever ran an event loop; slots are not freed
+    static std::vector<Slot*> fgSlots;
+    static G4ThreadLocal Slot* fgSlot;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
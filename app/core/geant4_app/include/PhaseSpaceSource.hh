@@ -0,0 +1,95 @@
+/**
+ * Phase-Space Source
+ * ==================
+ * Primary generator reading IAEA phase-space files (<base>.IAEAheader and
+ * <base>.IAEAphsp). The record file is memory-mapped read-only, so files
+ * larger than RAM are paged in on demand and shared between threads
+ * through the page cache.
+ *
+ * Each worker reads its own contiguous record range (split by thread
+ * number, moved to the next history boundary), so no two threads emit the
+ * same particle. One event is one history of the file; each history is
+ * used /geant4api/source/phsp/recycle times, rotated by a random angle
+ * about the z axis when /geant4api/source/phsp/rotate is set. Record
+ * weights become primary weights and are applied to the scored energy.
+ *
+ * Record layout (little endian, as announced by the header):
+ *   int8 type (1 gamma, 2 e-, 3 e+, 4 neutron, 5 proton; its sign is the
+ *   sign of w), float E in MeV (negative marks the first particle of a new
+ *   history), then the stored ones of float x, y, z (cm), u, v, weight, followed by
+ *   the extra floats and longs. Quantities not stored take the value of
+ *   $RECORD_CONSTANT.
+ */
+
+#ifndef PhaseSpaceSource_h
+#define PhaseSpaceSource_h 1
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+class G4Event;
+class G4GenericMessenger;
+class G4ParticleDefinition;
+
+class PhaseSpaceSource {
+public:
+    PhaseSpaceSource();
+    ~PhaseSpaceSource();
+
+    void GeneratePrimaries(G4Event* event);
+
+private:
+    struct Particle {
+        G4int type;
+        G4bool newHistory;
+        G4double energy;
+        G4double position[3];
+        G4double direction[3];
+        G4double weight;
+    };
+
+    // Parses the header and maps the record file; fatal on error
+    void Open();
+    void Close();
+    void ReadHeader(const G4String& fileName);
+    void SelectRange();
+    // First history start at or after index, or fNofRecords
+    std::size_t NextHistory(std::size_t index) const;
+    G4bool IsNewHistory(std::size_t index) const;
+    Particle Decode(std::size_t index) const;
+
+    G4String fBaseName;
+    G4int fRecycle;
+    G4bool fRotate;
+
+    // Layout from the header
+    G4bool fStored[6];      // x, y, z, u, v, weight
+    G4bool fSignedW;        // w from u, v and the sign of the type
+    G4double fConstant[7];  // x, y, z, u, v, w, weight
+    std::size_t fRecordLength;
+
+    // Mapped record file
+    G4String fOpenName;
+    const unsigned char* fData;
+    std::size_t fSize;
+    std::size_t fNofRecords;
+
+    // Files without history markers: every record is its own history
+    G4bool fPerParticle;
+
+    // This thread's record range and current history [start, end)
+    std::size_t fFirst;
+    std::size_t fEnd;
+    std::size_t fHistoryStart;
+    std::size_t fHistoryEnd;
+    G4int fUse;
+    G4bool fWrapped;
+
+    const G4ParticleDefinition* fParticles[6];
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
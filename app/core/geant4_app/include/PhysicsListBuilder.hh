@@ -0,0 +1,49 @@
+/**
+ * Physics List Builder
+ * ====================
+ * Modular physics configuration: a reference hadronic list, a swappable EM
+ * constructor and optional builders enabled by name. Named presets pick a
+ * speed/accuracy trade-off; explicit settings override the preset.
+ */
+
+#ifndef PhysicsListBuilder_h
+#define PhysicsListBuilder_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4VModularPhysicsList;
+class G4VPhysicsConstructor;
+
+class PhysicsListBuilder {
+public:
+    PhysicsListBuilder();
+    ~PhysicsListBuilder();
+
+    // Preset: fast, balanced, accurate, medical, lowenergy, penelope, shielding
+    G4bool ApplyPreset(const G4String& name);
+
+    // Reference list name understood by G4PhysListFactory (FTFP_BERT, QGSP_BIC, ...)
+    void SetBaseList(const G4String& name) { fBaseList = name; }
+    // standard, option1..option4 (or opt0..opt4), livermore, penelope
+    void SetEmOption(const G4String& name) { fEmOption = name; }
+    // steplimiter, radioactive, optical, fastshower/woodcock (both map to the
+    // fastsim process); comma-separated list allowed
+    void AddBuilders(const G4String& names);
+
+    G4VModularPhysicsList* Build() const;
+
+    void Print() const;
+    static void PrintPresets();
+
+private:
+    G4VPhysicsConstructor* CreateEmPhysics() const;
+    G4VPhysicsConstructor* CreateBuilder(const G4String& name) const;
+
+    G4String fBaseList;
+    G4String fEmOption;
+    std::vector<G4String> fBuilders;
+};
+
+#endif
@@ -1,6 +1,7 @@
 /**
  * Primary Generator Action
- * Uses G4GeneralParticleSource (GPS) for flexibility
+ * Uses G4GeneralParticleSource (GPS) for flexibility, an IAEA phase-space
+ * file (/geant4api/source/type phsp) or the fast beam source (beam)
  */
 
 #ifndef PrimaryGeneratorAction_h
@@ -10,11 +11,15 @@
 #include "globals.hh"
 
 class G4GeneralParticleSource;
+class G4GenericMessenger;
 class G4Event;
+class EventRecorder;
+class PhaseSpaceSource;
+class BeamSource;
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 public:
-    PrimaryGeneratorAction();
+    PrimaryGeneratorAction(EventRecorder* recorder);
     virtual ~PrimaryGeneratorAction();
     
     virtual void GeneratePrimaries(G4Event* event) override;
@@ -23,7 +28,12 @@ public:
     
 private:
     G4GeneralParticleSource* fGPS;
+    PhaseSpaceSource* fPhaseSpace;
+    BeamSource* fBeam;
+    EventRecorder* fRecorder;
+    
+    G4String fSourceType;
+    G4GenericMessenger* fMessenger;
 };
 
 #endif
-
@@ -7,6 +7,16 @@
 #define RunAction_h 1
 
 #include "G4UserRunAction.hh"
+#include "G4Timer.hh"
+#include "EventTrigger.hh"
+#include "EventRecorder.hh"
+#include "TrajectoryRecorder.hh"
+#include "StepProfiler.hh"
+#include "Timeline.hh"
+#include "LogSink.hh"
+#include "MemoryWatchdog.hh"
+#include "EventGuard.hh"
+#include "DetectorStats.hh"
 #include "globals.hh"
 
 class G4Run;
@@ -21,11 +31,51 @@ public:
     
     // Accumulate energy deposit
     void AddEdep(G4double edep);
+    // Hits of all sensitive detectors, reported as hits/s
+    void AddHits(G4int nofHits) { fNofHits += nofHits; }
+    
+    // End-of-event selection; every event is counted, accepted ones as well
+    EventTrigger& GetTrigger() { return fTrigger; }
+    void CountAccepted() { fNofAccepted += 1; }
+    
+    // Per-event seeds and vertices of this thread
+    EventRecorder* GetRecorder() { return &fRecorder; }
+    // Track polylines of this thread (compact output, or replay)
+    TrajectoryRecorder* GetTrajectories() { return &fTrajectories; }
+    // Step time per (volume, particle, process) of this thread
+    StepProfiler* GetProfiler() { return &fProfiler; }
+    // Event and end-of-run spans of this thread
+    Timeline* GetTimeline() { return &fTimeline; }
+    // Buffered, rate-limited log of this thread's event loop
+    LogSink* GetLog() { return &fLog; }
+    // Memory budget: the master's sampling thread, every thread's pauses
+    MemoryWatchdog* GetMemory() { return &fMemory; }
+    // Step and CPU time limits of this thread's tracks and events
+    EventGuard* GetGuard() { return &fGuard; }
+    // Energy per event of each sensitive detector, in constant memory
+    DetectorStats* GetDetectorStats() { return &fDetectorStats; }
+    const G4String& GetOutputDir() const { return fOutputDir; }
     
 private:
     G4String fOutputDir;
     G4double fEdep;
     G4double fEdep2;
+    G4int fNofAccepted;
+    G4int fNofHits;
+    
+    EventTrigger fTrigger;
+    EventRecorder fRecorder;
+    TrajectoryRecorder fTrajectories;
+    StepProfiler fProfiler;
+    Timeline fTimeline;
+    LogSink fLog;
+    MemoryWatchdog fMemory;
+    // Writes its triggers to fLog, declared before it
+    EventGuard fGuard;
+    DetectorStats fDetectorStats;
+    
+    // Wall-clock time of the event loop, reported as events/s
+    G4Timer fTimer;
 };
 
 #endif
@@ -8,6 +8,7 @@
 #define SensitiveDetector_h 1
 
 #include "G4VSensitiveDetector.hh"
+#include "G4VFastSimSensitiveDetector.hh"
 #include "G4THitsCollection.hh"
 #include "G4ThreeVector.hh"
 
@@ -39,6 +40,7 @@ public:
     void SetGlobalTime(G4double t) { fGlobalTime = t; }
     void SetLocalTime(G4double t) { fLocalTime = t; }
     void SetProcessName(G4String name) { fProcessName = name; }
+    void SetWeight(G4double w) { fWeight = w; }
     
     // Getters
     G4int GetEventID() const { return fEventID; }
@@ -53,6 +55,7 @@ public:
     G4double GetGlobalTime() const { return fGlobalTime; }
     G4double GetLocalTime() const { return fLocalTime; }
     G4String GetProcessName() const { return fProcessName; }
+    G4double GetWeight() const { return fWeight; }
     
 private:
     G4int fEventID;
@@ -67,6 +70,7 @@ private:
     G4double fGlobalTime;
     G4double fLocalTime;
     G4String fProcessName;
+    G4double fWeight;
 };
 
 typedef G4THitsCollection<DetectorHit> DetectorHitsCollection;
@@ -84,18 +88,23 @@ inline void DetectorHit::operator delete(void* hit) {
 }
 
 // Sensitive detector class
-class SensitiveDetector : public G4VSensitiveDetector {
+// Also accepts energy spots from parameterised showers (FastShowerModel)
+class SensitiveDetector : public G4VSensitiveDetector,
+                          public G4VFastSimSensitiveDetector {
 public:
     SensitiveDetector(const G4String& name, const G4String& hcName);
     virtual ~SensitiveDetector();
     
     virtual void Initialize(G4HCofThisEvent* hce) override;
     virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
+    virtual G4bool ProcessHits(const G4FastHit* fastHit, const G4FastTrack* fastTrack,
+                               G4TouchableHistory* history) override;
     virtual void EndOfEvent(G4HCofThisEvent* hce) override;
     
 private:
     DetectorHitsCollection* fHitsCollection;
     G4int fHCID;
+    G4int fEventID;
 };
 
 #endif
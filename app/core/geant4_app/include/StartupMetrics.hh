@@ -0,0 +1,86 @@
+/**
+ * Startup Metrics
+ * ===============
+ * Breaks the time before the first event into phases, with the wall time
+ * and resident memory change of each:
+ *
+ * - run manager, detector construction, physics list, user actions (main)
+ * - macro commands: UI commands before /run/initialize and between runs
+ * - GDML parsing, geometry and materials (DetectorConstruction::Construct)
+ * - sensitive detectors and fields (sequential mode; workers set up their
+ *   own during worker initialisation)
+ * - physics construction: the rest of G4RunManager::Initialize
+ * - physics tables and geometry closing: run initialisation of the kernel,
+ *   which builds the tables and voxelises the geometry in one call; part of
+ *   /run/initialize in MT and tasking mode, of the first run otherwise
+ * - worker initialisation (MT and tasking): the rest of /run/initialize,
+ *   whose empty run creates the workers and builds their geometry, physics
+ *   and user actions
+ * - run setup: up to the master's BeginOfRunAction of the first run
+ * - worker run start: until the last worker has begun the first run
+ *
+ * The phases are printed as one "METRICS {...}" JSON line after the first
+ * run, and written with the runs so far to <output>/run_manifest.json at
+ * the end of every run.
+ */
+
+#ifndef StartupMetrics_h
+#define StartupMetrics_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <vector>
+
+class StartupMetrics {
+public:
+    // Called first in main; observes the application state from then on
+    static void Start(int argc, char** argv, const G4String& outputDir);
+    // Ends the current phase of the master; ignored once the first run began
+    static void Mark(const G4String& phase);
+
+    // Called from BeginOfRunAction and EndOfRunAction of every thread
+    static void BeginOfRun();
+    static void EndOfRun(G4int runID, G4int nofEvents, G4double loopTime);
+
+    // Resident and peak resident memory of the process [MB], 0 if unknown
+    static G4double ResidentMB();
+    static G4double PeakResidentMB();
+
+private:
+    struct Phase {
+        G4String name;
+        G4double seconds;
+        G4double residentMB;
+    };
+    struct RunRecord {
+        G4int runID;
+        G4int nofEvents;
+        G4double loopTime;
+    };
+    using Clock = std::chrono::steady_clock;
+
+    static void AddPhase(const G4String& name, G4double seconds, G4double residentMB);
+    static G4String StartupJson();
+    static void WriteManifest();
+
+    static std::vector<G4String> fgCommandLine;
+    static G4String fgOutputDir;
+    static G4String fgStartDate;
+    static Clock::time_point fgStart;
+    static Clock::time_point fgLast;
+    static G4double fgLastResidentMB;
+    static G4bool fgStarted;
+    static G4bool fgDone;
+    static std::vector<Phase> fgPhases;
+    // The startup record, fixed at the end of the first run
+    static G4String fgStartupJson;
+    // Master's first BeginOfRunAction and the last worker's
+    static Clock::time_point fgRunBegin;
+    static Clock::time_point fgLastWorker;
+    static G4double fgLastWorkerResidentMB;
+    static G4int fgNofWorkers;
+    static std::vector<RunRecord> fgRuns;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Step Profiler
+ * =============
+ * Attributes wall time and step counts to (logical volume, particle,
+ * process) tuples when enabled with /geant4api/profile/enable. The time
+ * of a step runs from the end of the previous step of the track (or the
+ * start of the track) to the stepping action, so it covers transport,
+ * physics and sensitive detectors, but not the user actions themselves.
+ *
+ * Steps are timed with the CPU cycle counter (TSC on x86, the virtual
+ * counter on ARM64, steady_clock elsewhere), converted to seconds per
+ * thread against steady_clock over the run. Each thread fills its own
+ * table keyed by pointers; at the end of the run the tables are merged by
+ * name, and the master prints a ranking and writes
+ * <output>/profile_run<R>.json.
+ */
+
+#ifndef StepProfiler_h
+#define StepProfiler_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Step;
+class G4VProcess;
+
+class StepProfiler {
+public:
+    StepProfiler();
+    ~StepProfiler();
+
+    G4bool IsActive() const { return fEnabled; }
+
+    void BeginOfRun();
+    // Merges this thread's table; the master then reports the run
+    void EndOfRun(const G4String& outputDir, G4int runID);
+
+    void BeginTrack() { fLast = Ticks(); }
+    void AddStep(const G4Step* step);
+
+    static std::uint64_t Ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+private:
+    struct Key {
+        const G4LogicalVolume* volume;
+        const G4ParticleDefinition* particle;
+        const G4VProcess* process;
+        G4bool operator==(const Key& other) const {
+            return volume == other.volume && particle == other.particle && process == other.process;
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            std::size_t h = std::hash<const void*>()(key.volume);
+            h = h * 31 + std::hash<const void*>()(key.particle);
+            return h * 31 + std::hash<const void*>()(key.process);
+        }
+    };
+    struct Entry {
+        G4long steps;
+        std::uint64_t ticks;
+    };
+
+    void Report(const G4String& outputDir, G4int runID) const;
+
+    G4bool fEnabled;
+    G4int fTop;
+
+    // Entries stay in place when the map grows, so the last one is cached
+    std::unordered_map<Key, Entry, KeyHash> fTable;
+    Key fLastKey;
+    Entry* fLastEntry;
+    std::uint64_t fLast;
+
+    // Calibration of the counter over the run
+    std::uint64_t fStartTicks;
+    std::chrono::steady_clock::time_point fStartTime;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -9,16 +9,25 @@
 #include "globals.hh"
 
 class EventAction;
+class TrajectoryRecorder;
+class StepProfiler;
+class EventGuard;
 
 class SteppingAction : public G4UserSteppingAction {
 public:
-    SteppingAction(EventAction* eventAction);
+    // Steps of recorded tracks are passed to the trajectory recorder,
+    // every step to the profiler and the guard when they are enabled
+    SteppingAction(EventAction* eventAction, TrajectoryRecorder* trajectories = nullptr,
+                   StepProfiler* profiler = nullptr, EventGuard* guard = nullptr);
     virtual ~SteppingAction();
     
     virtual void UserSteppingAction(const G4Step* step) override;
     
 private:
     EventAction* fEventAction;
+    TrajectoryRecorder* fTrajectories;
+    StepProfiler* fProfiler;
+    EventGuard* fGuard;
 };
 
 #endif
@@ -0,0 +1,104 @@
+/**
+ * Timeline
+ * ========
+ * Optional trace of what every thread does over a run, enabled with
+ * /geant4api/timeline/enable: the run itself, each event, the end-of-event
+ * output, and the master's merge and save at the end of the run. Load
+ * imbalance and the tail of MT runs show up as threads idling after their
+ * last event while another still tracks a long shower.
+ *
+ * Each thread appends spans to its own buffer, which no other thread
+ * touches until the thread hands it over at the end of its run; recording a
+ * span takes two clock reads and no lock. The master writes all spans as
+ * Chrome trace JSON to <output>/timeline_run<R>.json, which chrome://tracing
+ * and ui.perfetto.dev open directly.
+ */
+
+#ifndef Timeline_h
+#define Timeline_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class G4GenericMessenger;
+
+class Timeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Timeline();
+    ~Timeline();
+
+    G4bool IsActive() const { return fEnabled; }
+    // Memory held by this thread's spans [bytes]
+    std::size_t GetBufferedBytes() const { return fSpans.capacity() * sizeof(Span); }
+
+    void BeginOfRun();
+    // Hands this thread's spans over; the master then writes the trace
+    void EndOfRun(const G4String& outputDir, G4int runID);
+
+    // Spans with a static name (a string literal); id is an event or run
+    // number shown in the trace, -1 for none
+    void Record(const char* name, Clock::time_point start, G4int id = -1) {
+        if (!fEnabled) return;
+        if (fSpans.size() >= std::size_t(fMaxSpans)) {
+            fNofDropped += 1;
+            return;
+        }
+        Clock::time_point end = Clock::now();
+        fSpans.push_back({name, Nanoseconds(start), Nanoseconds(end) - Nanoseconds(start), id});
+    }
+
+    // Records a span from construction to the end of the scope
+    class Scope {
+    public:
+        Scope(Timeline* timeline, const char* name, G4int id = -1)
+            : fTimeline(timeline && timeline->IsActive() ? timeline : nullptr),
+              fName(name), fId(id), fStart()
+        {
+            if (fTimeline) fStart = Clock::now();
+        }
+        ~Scope() { if (fTimeline) fTimeline->Record(fName, fStart, fId); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Timeline* fTimeline;
+        const char* fName;
+        G4int fId;
+        Clock::time_point fStart;
+    };
+
+private:
+    struct Span {
+        const char* name;
+        std::int64_t start;         // ns since the start of the run
+        std::int64_t duration;      // ns
+        G4int id;
+    };
+
+    static std::int64_t Nanoseconds(Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - fgEpoch).count();
+    }
+    void Write(const G4String& outputDir, G4int runID) const;
+
+    G4bool fEnabled;
+    G4int fMaxSpans;
+    std::vector<Span> fSpans;
+    G4long fNofDropped;
+    Clock::time_point fRunStart;
+
+    // Set by the master, which begins a run before its workers
+    static Clock::time_point fgEpoch;
+    // Spans handed over per thread (G4Threading ID, -1 for the master)
+    static std::vector<std::pair<G4int, std::vector<Span>>> fgCollected;
+    static G4long fgNofDropped;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * Tracking Action
+ * Opens and closes the trajectories of the recorder, when it is active,
+ * and starts the step clock of the profiler and the step count of the
+ * guard. Publishes the size of the
+ * track stack to the memory watchdog and aborts the event once the
+ * memory budget is exceeded.
+ */
+
+#ifndef TrackingAction_h
+#define TrackingAction_h 1
+
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+class TrajectoryRecorder;
+class StepProfiler;
+class EventGuard;
+
+class TrackingAction : public G4UserTrackingAction {
+public:
+    TrackingAction(TrajectoryRecorder* recorder, StepProfiler* profiler = nullptr,
+                   EventGuard* guard = nullptr);
+    virtual ~TrackingAction();
+
+    virtual void PreUserTrackingAction(const G4Track* track) override;
+    virtual void PostUserTrackingAction(const G4Track* track) override;
+
+private:
+    TrajectoryRecorder* fRecorder;
+    StepProfiler* fProfiler;
+    EventGuard* fGuard;
+    G4int fNofTracks;
+};
+
+#endif
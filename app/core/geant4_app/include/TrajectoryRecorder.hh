@@ -0,0 +1,134 @@
+/**
+ * Trajectory Recorder
+ * ===================
+ * Records track polylines from the tracking and stepping actions, in one
+ * of two modes:
+ *
+ * - full (replayed events): every step point of every track is kept and
+ *   written as JSON in the TrajectoryData shape of the REST API
+ *   (app/models/results.py).
+ * - compact (/geant4api/trajectories/enable): tracks are filtered by
+ *   initial energy and generation, simplified with Douglas-Peucker to
+ *   within a distance tolerance, and the kept points (position, time,
+ *   kinetic energy) are quantised and delta-encoded as varints.
+ *   Each event becomes one length-prefixed block of
+ *   <output>/trajectories_run<R>[_t<thread>].trj; bench/read_trajectories.py
+ *   decodes it. The positional error is bounded by the tolerance plus
+ *   half a quantum per coordinate.
+ */
+
+#ifndef TrajectoryRecorder_h
+#define TrajectoryRecorder_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class G4GenericMessenger;
+class G4Step;
+class G4StepPoint;
+class G4Track;
+
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    // Replay: keep every step of every track, no filters
+    void SetFullRecording() { fFull = true; }
+    G4bool IsActive() const { return fFull || fCompact; }
+    // True while the current track is being recorded
+    G4bool IsRecording() const { return fRecording; }
+
+    // Compact mode opens and closes this thread's output file
+    void BeginOfRun(const G4String& outputDir, G4int runID);
+    void EndOfRun();
+
+    void BeginTrack(const G4Track* track);
+    void AddStep(const G4Step* step);
+    void EndTrack(const G4Track* track);
+
+    // Compact mode: writes the event block, or drops it when not accepted
+    void EndOfEvent(G4int eventID, G4bool accepted);
+    void Clear();
+
+    // Full mode: one JSON document per event, units mm, ns and MeV
+    void WriteJson(const G4String& fileName, G4int runID, G4int eventID) const;
+
+    std::size_t GetNofTrajectories() const { return fTrajectories.size(); }
+    // Memory held for the current event and not yet written [bytes]
+    std::size_t GetBufferedBytes() const;
+    // Writes what the file stream still buffers
+    void Flush() { if (fFile.is_open()) fFile.flush(); }
+
+private:
+    struct Point {
+        G4ThreeVector position;
+        G4double time;
+        G4double kineticEnergy;
+        G4ThreeVector direction;
+    };
+    struct Trajectory {
+        G4int trackID;
+        G4int parentID;
+        G4int generation;
+        G4String particleName;
+        G4int pdg;
+        G4double initialEnergy;
+        G4String creatorProcess;
+        G4String endProcess;
+        std::vector<Point> points;
+    };
+
+    Trajectory& Current() { return fFull ? fTrajectories[fCurrent] : fTrack; }
+    void AddPoint(Trajectory& trajectory, const G4StepPoint* point);
+
+    // Marks the points of a polyline kept within fTolerance in fKeep
+    void Simplify(const std::vector<Point>& points);
+    void Encode(const Trajectory& trajectory);
+    void PutString(const G4String& value);
+
+    G4bool fFull;
+    G4bool fCompact;
+    G4bool fRecording;
+
+    // Compact mode settings
+    G4double fMinEnergy;
+    G4int fMaxGeneration;
+    G4double fTolerance;
+    G4double fQuantum;
+
+    // Full mode: all tracks of the event; compact mode: the current track
+    std::vector<Trajectory> fTrajectories;
+    std::size_t fCurrent;
+    Trajectory fTrack;
+    // Generation per track ID of the event (primaries are 0)
+    std::vector<G4int> fGenerations;
+
+    // Compact encoding state, reused between tracks and events
+    std::vector<char> fKeep;
+    std::vector<std::pair<std::size_t, std::size_t>> fStack;
+    std::string fBlock;
+    G4int fNofBlockTracks;
+    G4long fNofBlockInputPoints;
+    G4long fNofBlockKeptPoints;
+    // Names are written once per file and referenced by index afterwards;
+    // names first used in a dropped event are forgotten again
+    std::map<G4String, std::size_t> fStrings;
+    std::vector<G4String> fPendingStrings;
+
+    std::ofstream fFile;
+    G4long fNofTracks;
+    G4long fNofInputPoints;
+    G4long fNofKeptPoints;
+    G4long fNofBytes;
+
+    G4GenericMessenger* fMessenger;
+};
+
+#endif
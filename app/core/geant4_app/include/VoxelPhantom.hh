@@ -0,0 +1,85 @@
+/**
+ * Voxel Phantom
+ * =============
+ * Builds a patient phantom from a raw CT volume (int16 HU array, x fastest)
+ * described by a text header:
+ *
+ *   dimensions 128 128 100
+ *   voxel_size 2.0 2.0 2.5      (mm)
+ *   data       patient.raw      (relative to the header)
+ *
+ * HU values are mapped to a material and a density through a ramp; voxels
+ * are stored as one material index each and navigated with
+ * G4PhantomParameterisation and regular navigation, which skips boundaries
+ * between voxels of the same material. The placement mode builds one
+ * G4PVPlacement per voxel and only exists as a benchmark reference.
+ */
+
+#ifndef VoxelPhantom_h
+#define VoxelPhantom_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+class G4LogicalVolume;
+class G4Material;
+
+class VoxelPhantom {
+public:
+    VoxelPhantom(const G4String& headerFile);
+    ~VoxelPhantom();
+
+    // Width of the density bins within one ramp material
+    void SetDensityStep(G4double step) { fDensityStep = step; }
+
+    // Reads the CT and maps every voxel to a material index
+    void Load();
+
+    // Places the phantom centred in mother and returns the voxel logical
+    // volumes (one for regular navigation, one per material for placements)
+    std::vector<G4LogicalVolume*> Build(G4LogicalVolume* mother, G4bool regularNavigation);
+
+    G4double GetHalfX() const { return fNVoxels[0] * fVoxelHalf[0]; }
+    G4double GetHalfY() const { return fNVoxels[1] * fVoxelHalf[1]; }
+    G4double GetHalfZ() const { return fNVoxels[2] * fVoxelHalf[2]; }
+    std::size_t GetNoVoxels() const { return fMaterialIndices.size(); }
+    const std::vector<G4Material*>& GetMaterials() const { return fMaterials; }
+    G4LogicalVolume* GetContainer() const { return fContainerLogical; }
+
+    // Index in GetMaterials() of the voxel containing a point given in
+    // phantom coordinates
+    inline std::size_t GetMaterialIndex(const G4ThreeVector& local) const;
+
+private:
+    void ReadHeader();
+    // Material slot of a HU value: (ramp entry, density bin) key index
+    std::size_t KeyIndex(G4int hu, std::vector<std::pair<G4int, G4int>>& keys);
+
+    G4String fHeaderFile;
+    G4String fDataFile;
+    G4int fNVoxels[3];
+    G4double fVoxelHalf[3];
+    G4double fDensityStep;
+
+    // One entry per voxel; G4PhantomParameterisation keeps a pointer to it
+    std::vector<std::size_t> fMaterialIndices;
+    std::vector<G4Material*> fMaterials;
+
+    G4LogicalVolume* fContainerLogical;
+};
+
+inline std::size_t VoxelPhantom::GetMaterialIndex(const G4ThreeVector& local) const {
+    G4int ix = G4int((local.x() + GetHalfX()) / (2. * fVoxelHalf[0]));
+    G4int iy = G4int((local.y() + GetHalfY()) / (2. * fVoxelHalf[1]));
+    G4int iz = G4int((local.z() + GetHalfZ()) / (2. * fVoxelHalf[2]));
+    ix = std::min(std::max(ix, 0), fNVoxels[0] - 1);
+    iy = std::min(std::max(iy, 0), fNVoxels[1] - 1);
+    iz = std::min(std::max(iz, 0), fNVoxels[2] - 1);
+    return fMaterialIndices[(std::size_t(iz) * fNVoxels[1] + iy) * fNVoxels[0] + ix];
+}
+
+#endif
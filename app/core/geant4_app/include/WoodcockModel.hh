@@ -0,0 +1,87 @@
+/**
+ * Woodcock Model
+ * ==============
+ * Delta tracking of photons through a voxel phantom envelope. Flight
+ * distances are sampled with the largest attenuation coefficient of the
+ * phantom materials and candidate points are accepted as real with
+ * probability mu(point)/mu_max, without stopping at voxel boundaries.
+ *
+ * An accepted point is where the photon really interacts: the model moves it
+ * there, and on the next step performs the interaction with the gamma
+ * process chosen by the cross sections of the local material (the photon is
+ * then in the right voxel for deposits and secondaries). A photon with no
+ * accepted point is handed back to standard transport just inside the
+ * envelope surface. Needs the separate gamma processes, not the general one.
+ */
+
+#ifndef WoodcockModel_h
+#define WoodcockModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+#include "Randomize.hh"
+
+#include <vector>
+
+class VoxelPhantom;
+class G4VEmProcess;
+
+class WoodcockModel : public G4VFastSimulationModel {
+public:
+    WoodcockModel(const G4String& name, G4Region* envelope, const VoxelPhantom* phantom);
+    virtual ~WoodcockModel();
+
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle) override;
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack) override;
+    virtual void DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) override;
+
+    // Distance to the first real interaction on a straight flight of the
+    // given length, or length when the photon gets through; mu(s) is the
+    // attenuation coefficient at distance s and never exceeds muMax
+    template <typename Mu>
+    static G4double SampleDistance(G4double length, G4double muMax, const Mu& mu);
+
+private:
+    // Attenuation tables per phantom material, built on first use because
+    // physics tables only exist after run initialisation
+    void BuildTables();
+    G4double Attenuation(const std::vector<G4double>& table, G4double logEnergy) const;
+    G4bool AtLastPoint(const G4Track* track) const;
+    // Real interaction at the point the previous step moved the photon to
+    void Interact(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+    const VoxelPhantom* fPhantom;
+
+    G4double fMinEnergy;
+    G4double fMaxEnergy;
+    G4int fNBins;
+    G4double fLogMin;
+    G4double fLogStep;
+
+    // Indexed like VoxelPhantom::GetMaterials()
+    std::vector<std::vector<G4double>> fMu;
+    std::vector<G4double> fMuMax;
+    // Discrete gamma processes of this thread and their summed cross sections
+    std::vector<G4VEmProcess*> fProcesses;
+    std::vector<G4double> fCrossSections;
+
+    // Where the model last moved the photon to: an interaction point, or
+    // the handover to standard transport at the envelope exit
+    G4int fLastTrackID;
+    G4ThreeVector fLastPosition;
+    G4bool fInteractionPending;
+};
+
+template <typename Mu>
+G4double WoodcockModel::SampleDistance(G4double length, G4double muMax, const Mu& mu) {
+    if (muMax <= 0.) return length;
+    G4double s = 0.;
+    while (true) {
+        s += CLHEP::RandExponential::shoot(1. / muMax);
+        if (s >= length) return length;
+        if (G4UniformRand() * muMax < mu(s)) return s;
+    }
+}
+
+#endif
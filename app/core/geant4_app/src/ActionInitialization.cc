@@ -7,6 +7,9 @@
 #include "RunAction.hh"
 #include "EventAction.hh"
 #include "SteppingAction.hh"
+#include "TrackingAction.hh"
+#include "EventRecorder.hh"
+#include "TrajectoryRecorder.hh"
 
 ActionInitialization::ActionInitialization(const G4String& outputDir)
     : G4VUserActionInitialization(),
@@ -20,14 +23,21 @@ void ActionInitialization::BuildForMaster() const {
 }
 
 void ActionInitialization::Build() const {
-    SetUserAction(new PrimaryGeneratorAction);
-    
     RunAction* runAction = new RunAction(fOutputDir);
     SetUserAction(runAction);
     
+    SetUserAction(new PrimaryGeneratorAction(runAction->GetRecorder()));
+    
     EventAction* eventAction = new EventAction(runAction);
     SetUserAction(eventAction);
     
-    SetUserAction(new SteppingAction(eventAction));
+    // A replayed event keeps every step; otherwise the compact recorder
+    // only records when enabled from the macro
+    TrajectoryRecorder* trajectories = runAction->GetTrajectories();
+    if (EventRecorder::IsReplay()) trajectories->SetFullRecording();
+    StepProfiler* profiler = runAction->GetProfiler();
+    EventGuard* guard = runAction->GetGuard();
+    SetUserAction(new TrackingAction(trajectories, profiler, guard));
+    SetUserAction(new SteppingAction(eventAction, trajectories, profiler, guard));
 }
 
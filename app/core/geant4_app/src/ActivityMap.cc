@@ -0,0 +1,142 @@
+/**
+ * Activity Map Implementation
+ */
+
+#include "ActivityMap.hh"
+
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace {
+
+G4Mutex mapsMutex = G4MUTEX_INITIALIZER;
+
+}
+
+std::shared_ptr<const ActivityMap> ActivityMap::Load(const G4String& headerFile) {
+    // Workers loading the same header get the same map
+    static std::map<G4String, std::weak_ptr<const ActivityMap>> maps;
+    G4AutoLock lock(&mapsMutex);
+
+    std::shared_ptr<const ActivityMap> map = maps[headerFile].lock();
+    if (!map) {
+        map.reset(new ActivityMap(headerFile));
+        maps[headerFile] = map;
+    }
+    return map;
+}
+
+ActivityMap::ActivityMap(const G4String& headerFile)
+    : fHeaderFile(headerFile),
+      fDataFile(""),
+      fNVoxels{0, 0, 0},
+      fVoxelSize{0., 0., 0.},
+      fCorner(),
+      fVoxels(),
+      fTable()
+{
+    ReadHeader();
+    ReadData();
+}
+
+void ActivityMap::ReadHeader() {
+    std::ifstream header(fHeaderFile);
+    if (!header) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open activity header " << fHeaderFile;
+        G4Exception("ActivityMap::ReadHeader()", "ActivityHeader", FatalException, msg);
+        return;
+    }
+
+    std::string line;
+    while (std::getline(header, line)) {
+        std::istringstream is(line);
+        std::string key;
+        if (!(is >> key) || key[0] == '#') continue;
+
+        if (key == "dimensions") {
+            is >> fNVoxels[0] >> fNVoxels[1] >> fNVoxels[2];
+        } else if (key == "voxel_size") {
+            for (G4int i = 0; i < 3; i++) {
+                G4double size;
+                is >> size;
+                fVoxelSize[i] = size * mm;
+            }
+        } else if (key == "data") {
+            is >> fDataFile;
+        }
+    }
+
+    if (fNVoxels[0] <= 0 || fNVoxels[1] <= 0 || fNVoxels[2] <= 0 ||
+        fVoxelSize[0] <= 0. || fVoxelSize[1] <= 0. || fVoxelSize[2] <= 0. || fDataFile.empty()) {
+        G4ExceptionDescription msg;
+        msg << "Activity header " << fHeaderFile << " needs dimensions, voxel_size and data";
+        G4Exception("ActivityMap::ReadHeader()", "ActivityHeader", FatalException, msg);
+        return;
+    }
+    if (G4double(fNVoxels[0]) * fNVoxels[1] * fNVoxels[2] >
+        G4double(std::numeric_limits<std::uint32_t>::max())) {
+        G4ExceptionDescription msg;
+        msg << "Activity grid " << fHeaderFile << " has more than 2^32 voxels";
+        G4Exception("ActivityMap::ReadHeader()", "ActivityHeader", FatalException, msg);
+        return;
+    }
+
+    // Data path is relative to the header
+    std::size_t slash = fHeaderFile.rfind('/');
+    if (fDataFile[0] != '/' && slash != std::string::npos) {
+        fDataFile = fHeaderFile.substr(0, slash + 1) + fDataFile;
+    }
+
+    fCorner = -0.5 * G4ThreeVector(fNVoxels[0] * fVoxelSize[0],
+                                   fNVoxels[1] * fVoxelSize[1],
+                                   fNVoxels[2] * fVoxelSize[2]);
+}
+
+void ActivityMap::ReadData() {
+    std::ifstream data(fDataFile, std::ios::binary);
+    if (!data) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open activity data " << fDataFile;
+        G4Exception("ActivityMap::ReadData()", "ActivityData", FatalException, msg);
+        return;
+    }
+
+    // Stream one slice at a time; only active voxels are kept
+    const std::size_t sliceSize = std::size_t(fNVoxels[0]) * fNVoxels[1];
+    std::vector<float> slice(sliceSize);
+    std::vector<G4double> activities;
+    for (G4int iz = 0; iz < fNVoxels[2]; iz++) {
+        data.read(reinterpret_cast<char*>(slice.data()), sliceSize * sizeof(float));
+        if (!data) {
+            G4ExceptionDescription msg;
+            msg << "Activity data " << fDataFile << " ends at slice " << iz;
+            G4Exception("ActivityMap::ReadData()", "ActivityData", FatalException, msg);
+            return;
+        }
+        for (std::size_t i = 0; i < sliceSize; i++) {
+            if (slice[i] > 0.f) {
+                fVoxels.push_back(std::uint32_t(iz * sliceSize + i));
+                activities.push_back(slice[i]);
+            }
+        }
+    }
+    fVoxels.shrink_to_fit();
+
+    if (!fTable.Build(activities)) {
+        G4ExceptionDescription msg;
+        msg << "Activity data " << fDataFile << " has no voxel with positive activity";
+        G4Exception("ActivityMap::ReadData()", "ActivityData", FatalException, msg);
+        return;
+    }
+
+    std::size_t nVoxels = sliceSize * fNVoxels[2];
+    G4cout << "Activity map " << fHeaderFile << ": " << fVoxels.size() << " of "
+           << nVoxels << " voxels active ("
+           << 100. * fVoxels.size() / nVoxels << " %)" << G4endl;
+}
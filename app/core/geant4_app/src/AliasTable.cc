@@ -0,0 +1,45 @@
+/**
+ * Alias Table Implementation
+ */
+
+#include "AliasTable.hh"
+
+AliasTable::AliasTable()
+    : fEntries(),
+      fTotal(0.)
+{}
+
+G4bool AliasTable::Build(const std::vector<G4double>& weights) {
+    fEntries.clear();
+    fTotal = 0.;
+    for (G4double weight : weights) fTotal += (weight > 0.) ? weight : 0.;
+    if (fTotal <= 0.) return false;
+
+    // Vose: scale to mean 1, then pair each small entry with a large one
+    std::size_t n = weights.size();
+    std::vector<G4double> scaled(n);
+    std::vector<std::uint32_t> small, large;
+    for (std::size_t i = 0; i < n; ++i) {
+        scaled[i] = (weights[i] > 0. ? weights[i] : 0.) * G4double(n) / fTotal;
+        (scaled[i] < 1. ? small : large).push_back(std::uint32_t(i));
+    }
+
+    fEntries.assign(n, Entry{1., 0});
+    for (std::size_t i = 0; i < n; ++i) fEntries[i].alias = std::uint32_t(i);
+
+    while (!small.empty() && !large.empty()) {
+        std::uint32_t s = small.back();
+        small.pop_back();
+        std::uint32_t l = large.back();
+        large.pop_back();
+
+        fEntries[s].probability = scaled[s];
+        fEntries[s].alias = l;
+        scaled[l] -= 1. - scaled[s];
+        (scaled[l] < 1. ? small : large).push_back(l);
+    }
+    // Leftovers differ from 1 only by rounding
+    for (std::uint32_t i : small) fEntries[i].probability = 1.;
+    for (std::uint32_t i : large) fEntries[i].probability = 1.;
+    return true;
+}
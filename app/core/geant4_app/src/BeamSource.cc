@@ -0,0 +1,395 @@
+/**
+ * Beam Source Implementation
+ */
+
+#include "BeamSource.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+BeamSource::BeamSource()
+    : fParticleName("gamma"),
+      fEnergyType(kMono),
+      fEnergy(1.*MeV),
+      fSigma(0.),
+      fMinEnergy(0.1*MeV),
+      fMaxEnergy(10.*MeV),
+      fSpectrum(),
+      fSpectrumEnergies(),
+      fSpectrumDensities(),
+      fSpectrumLinear(false),
+      fPositionType(kPoint),
+      fCentre(0., 0., 0.),
+      fRadius(0.),
+      fHalfX(0.),
+      fHalfY(0.),
+      fActivity(),
+      fDirectionType(kDirected),
+      fDirection(0., 0., 1.),
+      fConeAngle(0.),
+      fResolved(false),
+      fParameters(),
+      fGenerator(nullptr),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/source/beam/",
+                                        "Fast single-particle beam source");
+
+    fMessenger->DeclareMethod("particle", &BeamSource::SetParticle)
+        .SetGuidance("Particle name, as for /gps/particle.")
+        .SetParameterName("particle", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("energyType", &BeamSource::SetEnergyType)
+        .SetGuidance("mono (energy), gauss (energy, sigma), flat (minEnergy, maxEnergy)")
+        .SetGuidance("or spectrum (the last file loaded with spectrum).")
+        .SetParameterName("type", false)
+        .SetCandidates("mono gauss flat spectrum")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("energy", "MeV", &BeamSource::SetEnergy)
+        .SetGuidance("Mono energy, or mean of the Gaussian.")
+        .SetParameterName("energy", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("sigma", "MeV", &BeamSource::SetSigma)
+        .SetGuidance("Standard deviation of the Gaussian energy.")
+        .SetParameterName("sigma", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("minEnergy", "MeV", &BeamSource::SetMinEnergy)
+        .SetGuidance("Lower edge of the flat energy spectrum.")
+        .SetParameterName("energy", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("maxEnergy", "MeV", &BeamSource::SetMaxEnergy)
+        .SetGuidance("Upper edge of the flat energy spectrum.")
+        .SetParameterName("energy", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("spectrum", &BeamSource::SetSpectrum)
+        .SetGuidance("Load a tabulated spectrum and select it: <file> [hist|lin].")
+        .SetGuidance("Lines of energy (MeV) and weight; # starts a comment.")
+        .SetGuidance("hist: first line is the lower edge, then upper edge and weight of each bin.")
+        .SetGuidance("lin: points of the density, interpolated linearly within each interval.")
+        .SetParameterName("file", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("positionType", &BeamSource::SetPositionType)
+        .SetGuidance("point, disc (radius) or rect (halfX, halfY), in the xy plane,")
+        .SetGuidance("or voxel (the last map loaded with activity).")
+        .SetParameterName("type", false)
+        .SetCandidates("point disc rect voxel")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("centre", "mm", &BeamSource::SetCentre)
+        .SetGuidance("Source centre.")
+        .SetParameterName("centre", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("radius", "mm", &BeamSource::SetRadius)
+        .SetGuidance("Radius of the disc.")
+        .SetParameterName("radius", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("halfX", "mm", &BeamSource::SetHalfX)
+        .SetGuidance("Half length of the rectangle along x.")
+        .SetParameterName("halfX", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("halfY", "mm", &BeamSource::SetHalfY)
+        .SetGuidance("Half length of the rectangle along y.")
+        .SetParameterName("halfY", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("activity", &BeamSource::SetActivity)
+        .SetGuidance("Load a voxelised activity map and select it for positions.")
+        .SetGuidance("Header: dimensions, voxel_size (mm), data (float32, x fastest).")
+        .SetGuidance("The grid is centred on the source centre.")
+        .SetParameterName("header", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("directionType", &BeamSource::SetDirectionType)
+        .SetGuidance("directed (direction), cone (direction, coneAngle) or iso.")
+        .SetParameterName("type", false)
+        .SetCandidates("directed cone iso")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("direction", &BeamSource::SetDirection)
+        .SetGuidance("Beam direction, or axis of the cone.")
+        .SetParameterName("direction", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethodWithUnit("coneAngle", "deg", &BeamSource::SetConeAngle)
+        .SetGuidance("Half opening angle of the cone.")
+        .SetParameterName("angle", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+BeamSource::~BeamSource() {
+    delete fMessenger;
+}
+
+void BeamSource::SetParticle(const G4String& name) { fParticleName = name; fResolved = false; }
+void BeamSource::SetEnergy(G4double energy) { fEnergy = energy; fResolved = false; }
+void BeamSource::SetSigma(G4double sigma) { fSigma = sigma; fResolved = false; }
+void BeamSource::SetMinEnergy(G4double energy) { fMinEnergy = energy; fResolved = false; }
+void BeamSource::SetMaxEnergy(G4double energy) { fMaxEnergy = energy; fResolved = false; }
+void BeamSource::SetCentre(G4ThreeVector centre) { fCentre = centre; fResolved = false; }
+void BeamSource::SetRadius(G4double radius) { fRadius = radius; fResolved = false; }
+void BeamSource::SetHalfX(G4double halfX) { fHalfX = halfX; fResolved = false; }
+void BeamSource::SetHalfY(G4double halfY) { fHalfY = halfY; fResolved = false; }
+void BeamSource::SetDirection(G4ThreeVector direction) { fDirection = direction; fResolved = false; }
+void BeamSource::SetConeAngle(G4double angle) { fConeAngle = angle; fResolved = false; }
+
+void BeamSource::SetEnergyType(const G4String& type) {
+    fEnergyType = (type == "gauss") ? kGauss : (type == "flat") ? kFlat
+                : (type == "spectrum") ? kSpectrum : kMono;
+    fResolved = false;
+}
+
+void BeamSource::SetSpectrum(const G4String& value) {
+    std::istringstream in(value);
+    G4String fileName, mode = "hist";
+    in >> fileName >> mode;
+    if (mode != "hist" && mode != "lin") {
+        G4ExceptionDescription msg;
+        msg << "Unknown spectrum mode " << mode << "; expected hist or lin";
+        G4Exception("BeamSource::SetSpectrum()", "BeamSpectrum", FatalErrorInArgument, msg);
+        return;
+    }
+    LoadSpectrum(fileName, mode == "lin");
+    fEnergyType = kSpectrum;
+    fResolved = false;
+}
+
+void BeamSource::LoadSpectrum(const G4String& fileName, G4bool linear) {
+    std::ifstream file(fileName);
+    if (!file) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read spectrum file " << fileName;
+        G4Exception("BeamSource::LoadSpectrum()", "BeamSpectrum", FatalErrorInArgument, msg);
+        return;
+    }
+
+    std::vector<G4double> energies, weights;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        G4double energy, weight;
+        if (!(in >> energy)) continue;
+        if (!(in >> weight) || weight < 0. ||
+            (!energies.empty() && energy*MeV <= energies.back())) {
+            G4ExceptionDescription msg;
+            msg << fileName << ": bad line \"" << line << "\"; energies must increase"
+                << " and weights be non-negative";
+            G4Exception("BeamSource::LoadSpectrum()", "BeamSpectrum", FatalErrorInArgument, msg);
+            return;
+        }
+        energies.push_back(energy*MeV);
+        weights.push_back(weight);
+    }
+    if (energies.size() < 2) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": a spectrum needs at least two energies";
+        G4Exception("BeamSource::LoadSpectrum()", "BeamSpectrum", FatalErrorInArgument, msg);
+        return;
+    }
+
+    // Probability of each interval between consecutive energies
+    std::vector<G4double> intervals(energies.size() - 1);
+    for (std::size_t i = 0; i + 1 < energies.size(); ++i) {
+        intervals[i] = linear ? 0.5*(weights[i] + weights[i + 1])*(energies[i + 1] - energies[i])
+                              : weights[i + 1];
+    }
+    if (!fSpectrum.Build(intervals)) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": all weights are zero";
+        G4Exception("BeamSource::LoadSpectrum()", "BeamSpectrum", FatalErrorInArgument, msg);
+        return;
+    }
+    fSpectrumEnergies = energies;
+    fSpectrumDensities = weights;
+    fSpectrumLinear = linear;
+
+    G4cout << "Beam spectrum " << fileName << ": " << intervals.size()
+           << (linear ? " linear intervals" : " bins") << ", "
+           << energies.front()/MeV << " - " << energies.back()/MeV << " MeV" << G4endl;
+}
+
+void BeamSource::SetPositionType(const G4String& type) {
+    fPositionType = (type == "disc") ? kDisc : (type == "rect") ? kRectangle
+                  : (type == "voxel") ? kVoxel : kPoint;
+    fResolved = false;
+}
+
+void BeamSource::SetActivity(const G4String& headerFile) {
+    fActivity = ActivityMap::Load(headerFile);
+    fPositionType = kVoxel;
+    fResolved = false;
+}
+
+void BeamSource::SetDirectionType(const G4String& type) {
+    fDirectionType = (type == "cone") ? kCone : (type == "iso") ? kIsotropic : kDirected;
+    fResolved = false;
+}
+
+template <G4int E, G4int P, G4int D>
+void BeamSource::Generate(const Parameters& p, G4Event* event) {
+    G4double energy = p.energy;
+    if (E == kGauss) {
+        do {
+            energy = G4RandGauss::shoot(p.energy, p.sigma);
+        } while (energy <= 0.);
+    } else if (E == kFlat) {
+        energy = p.minEnergy + p.energyWidth*G4UniformRand();
+    } else if (E == kSpectrum || E == kSpectrumLinear) {
+        std::size_t i = p.spectrum->Sample(G4UniformRand(), G4UniformRand());
+        G4double lower = p.spectrumEnergies[i];
+        G4double u = G4UniformRand();
+        if (E == kSpectrumLinear) {
+            // Inverse CDF of the trapezoid between densities a and b
+            G4double a = p.spectrumDensities[i], b = p.spectrumDensities[i + 1];
+            u = u*(a + b) / (a + std::sqrt(a*a + u*(b*b - a*a)));
+        }
+        energy = lower + u*(p.spectrumEnergies[i + 1] - lower);
+    }
+
+    G4ThreeVector position = p.centre;
+    if (P == kDisc) {
+        G4double r = p.radius*std::sqrt(G4UniformRand());
+        G4double phi = twopi*G4UniformRand();
+        position += G4ThreeVector(r*std::cos(phi), r*std::sin(phi), 0.);
+    } else if (P == kRectangle) {
+        position += G4ThreeVector(p.halfX*(2.*G4UniformRand() - 1.),
+                                  p.halfY*(2.*G4UniformRand() - 1.), 0.);
+    } else if (P == kVoxel) {
+        G4double u1 = G4UniformRand(), u2 = G4UniformRand();
+        G4double u3 = G4UniformRand(), u4 = G4UniformRand(), u5 = G4UniformRand();
+        position += p.activity->Sample(u1, u2, u3, u4, u5);
+    }
+
+    G4ThreeVector direction = p.axis;
+    if (D != kDirected) {
+        G4double cosTheta = (D == kCone) ? 1. - p.oneMinusCosCone*G4UniformRand()
+                                         : 2.*G4UniformRand() - 1.;
+        G4double sinTheta = std::sqrt(std::max(0., 1. - cosTheta*cosTheta));
+        G4double phi = twopi*G4UniformRand();
+        direction = (D == kCone)
+            ? cosTheta*p.axis + sinTheta*(std::cos(phi)*p.axisU + std::sin(phi)*p.axisV)
+            : G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+    }
+
+    G4PrimaryParticle* primary = new G4PrimaryParticle(p.particle);
+    primary->SetKineticEnergy(energy);
+    primary->SetMomentumDirection(direction);
+
+    G4PrimaryVertex* vertex = new G4PrimaryVertex(position, 0.);
+    vertex->SetPrimary(primary);
+    event->AddPrimaryVertex(vertex);
+}
+
+template <G4int E, G4int P>
+BeamSource::Generator BeamSource::SelectDirection(G4int direction) {
+    switch (direction) {
+        case kCone: return &Generate<E, P, kCone>;
+        case kIsotropic: return &Generate<E, P, kIsotropic>;
+        default: return &Generate<E, P, kDirected>;
+    }
+}
+
+template <G4int E>
+BeamSource::Generator BeamSource::SelectPosition(G4int position, G4int direction) {
+    switch (position) {
+        case kDisc: return SelectDirection<E, kDisc>(direction);
+        case kRectangle: return SelectDirection<E, kRectangle>(direction);
+        case kVoxel: return SelectDirection<E, kVoxel>(direction);
+        default: return SelectDirection<E, kPoint>(direction);
+    }
+}
+
+void BeamSource::Resolve() {
+    Parameters& p = fParameters;
+
+    p.particle = G4ParticleTable::GetParticleTable()->FindParticle(fParticleName);
+    if (!p.particle) {
+        G4ExceptionDescription msg;
+        msg << "Unknown particle " << fParticleName << " for /geant4api/source/beam/particle";
+        G4Exception("BeamSource::Resolve()", "BeamParticle", FatalErrorInArgument, msg);
+        return;
+    }
+    if (fDirection.mag2() == 0.) {
+        G4Exception("BeamSource::Resolve()", "BeamDirection", FatalErrorInArgument,
+                    "The beam direction is the null vector");
+        return;
+    }
+    if (fEnergyType == kSpectrum && fSpectrum.IsEmpty()) {
+        G4Exception("BeamSource::Resolve()", "BeamSpectrum", FatalErrorInArgument,
+                    "No spectrum loaded; use /geant4api/source/beam/spectrum");
+        return;
+    }
+    if (fPositionType == kVoxel && !fActivity) {
+        G4Exception("BeamSource::Resolve()", "BeamActivity", FatalErrorInArgument,
+                    "No activity map loaded; use /geant4api/source/beam/activity");
+        return;
+    }
+    if (fEnergyType == kFlat && fMaxEnergy < fMinEnergy) {
+        G4ExceptionDescription msg;
+        msg << "Flat energy range is empty: max " << fMaxEnergy/MeV
+            << " MeV < min " << fMinEnergy/MeV << " MeV";
+        G4Exception("BeamSource::Resolve()", "BeamEnergy", FatalErrorInArgument, msg);
+        return;
+    }
+
+    p.energy = fEnergy;
+    p.sigma = fSigma;
+    p.minEnergy = fMinEnergy;
+    p.energyWidth = fMaxEnergy - fMinEnergy;
+    p.spectrum = &fSpectrum;
+    p.spectrumEnergies = fSpectrumEnergies.data();
+    p.spectrumDensities = fSpectrumDensities.data();
+    p.centre = fCentre;
+    p.radius = fRadius;
+    p.halfX = fHalfX;
+    p.halfY = fHalfY;
+    p.activity = fActivity.get();
+    p.axis = fDirection.unit();
+    p.axisU = p.axis.orthogonal().unit();
+    p.axisV = p.axis.cross(p.axisU);
+    p.oneMinusCosCone = 1. - std::cos(fConeAngle);
+
+    // Degenerate distributions fall back to the cheaper sampler
+    G4int energy = fEnergyType;
+    if (energy == kGauss && fSigma <= 0.) energy = kMono;
+    if (energy == kSpectrum && fSpectrumLinear) energy = kSpectrumLinear;
+    G4int direction = fDirectionType;
+    if (direction == kCone && fConeAngle <= 0.) direction = kDirected;
+
+    switch (energy) {
+        case kGauss: fGenerator = SelectPosition<kGauss>(fPositionType, direction); break;
+        case kFlat: fGenerator = SelectPosition<kFlat>(fPositionType, direction); break;
+        case kSpectrum: fGenerator = SelectPosition<kSpectrum>(fPositionType, direction); break;
+        case kSpectrumLinear:
+            fGenerator = SelectPosition<kSpectrumLinear>(fPositionType, direction);
+            break;
+        default: fGenerator = SelectPosition<kMono>(fPositionType, direction); break;
+    }
+    fResolved = true;
+}
+
+void BeamSource::GeneratePrimaries(G4Event* event) {
+    if (!fResolved) Resolve();
+    fGenerator(fParameters, event);
+}
@@ -4,6 +4,10 @@
 
 #include "DetectorConstruction.hh"
 #include "SensitiveDetector.hh"
+#include "FastShowerModel.hh"
+#include "VoxelPhantom.hh"
+#include "WoodcockModel.hh"
+#include "StartupMetrics.hh"
 
 #include "G4GDMLParser.hh"
 #include "G4NistManager.hh"
@@ -15,13 +19,50 @@
 #include "G4SDManager.hh"
 #include "G4VisAttributes.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
+#include "G4UIcommand.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4UserLimits.hh"
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+
+namespace {
+
+// Auxiliary types understood as region settings. They may be given next to a
+// Region tag on the same volume or nested inside it:
+//   <auxiliary auxtype="Region" auxvalue="TrackerRegion"/>
+//   <auxiliary auxtype="ProductionCut" auxvalue="10" auxunit="um"/>
+//   <auxiliary auxtype="MaxStep" auxvalue="0.1" auxunit="mm"/>
+const std::map<G4String, G4String> kRegionCutParticles = {
+    {"ProductionCut", ""},
+    {"GammaCut", "gamma"},
+    {"ElectronCut", "e-"},
+    {"PositronCut", "e+"},
+    {"ProtonCut", "proton"}
+};
+
+const std::vector<G4String> kRegionLimits = {
+    "MaxStep", "MaxTrackLength", "MaxTime", "MinEkine", "MinRange"
+};
+
+G4bool IsRegionSetting(const G4String& type) {
+    return kRegionCutParticles.count(type) > 0 ||
+           std::find(kRegionLimits.begin(), kRegionLimits.end(), type) != kRegionLimits.end();
+}
+
+G4double AuxValue(const G4GDMLAuxStructType& aux, const G4String& defaultUnit) {
+    G4String unit = aux.unit.empty() ? defaultUnit : aux.unit;
+    return G4UIcommand::ConvertToDouble(aux.value) * G4UnitDefinition::GetValueOf(unit);
+}
+
+}
 
 DetectorConstruction::DetectorConstruction()
-    : G4VUserDetectorConstruction(),
-      fGdmlFile(""),
-      fParser(nullptr),
-      fWorldLogical(nullptr),
-      fWorldPhysical(nullptr)
+    : DetectorConstruction("")
 {}
 
 DetectorConstruction::DetectorConstruction(const G4String& gdmlFile)
@@ -29,19 +70,69 @@ DetectorConstruction::DetectorConstruction(const G4String& gdmlFile)
       fGdmlFile(gdmlFile),
       fParser(nullptr),
       fWorldLogical(nullptr),
-      fWorldPhysical(nullptr)
-{}
+      fWorldPhysical(nullptr),
+      fMessenger(nullptr),
+      fCTHeader(""),
+      fRegularNavigation(true),
+      fDensityStep(0.1*g/cm3),
+      fWoodcock(false),
+      fVoxelPhantom(nullptr),
+      fWoodcockEnvelope(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/phantom/", "Voxel phantom control");
+    
+    fMessenger->DeclareMethod("ct", &DetectorConstruction::SetCTHeader)
+        .SetGuidance("Build a voxel phantom from a CT header (dimensions, voxel_size, data).")
+        .SetParameterName("header", false)
+        .SetStates(G4State_PreInit);
+    
+    fMessenger->DeclareMethod("navigation", &DetectorConstruction::SetPhantomNavigation)
+        .SetGuidance("regular: G4PhantomParameterisation with regular navigation.")
+        .SetGuidance("placement: one placement per voxel (benchmark reference).")
+        .SetParameterName("mode", false)
+        .SetCandidates("regular placement")
+        .SetStates(G4State_PreInit);
+    
+    fMessenger->DeclareMethodWithUnit("densityStep", "g/cm3", &DetectorConstruction::SetDensityStep)
+        .SetGuidance("Density bin width within one HU ramp material.")
+        .SetParameterName("step", false)
+        .SetStates(G4State_PreInit);
+    
+    fMessenger->DeclareMethod("woodcock", &DetectorConstruction::SetWoodcock)
+        .SetGuidance("Woodcock (delta) tracking of photons inside the phantom.")
+        .SetGuidance("Requires the fastsim physics builder (geant4api --with woodcock).")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit);
+}
 
 DetectorConstruction::~DetectorConstruction() {
+    delete fMessenger;
+    delete fVoxelPhantom;
     if (fParser) delete fParser;
 }
 
+void DetectorConstruction::SetPhantomNavigation(const G4String& mode) {
+    fRegularNavigation = (mode != "placement");
+}
+
+void DetectorConstruction::AddSensitiveVolume(const G4String& name, G4LogicalVolume* lv) {
+    if (std::find(fSensitiveVolumes.begin(), fSensitiveVolumes.end(), name) == fSensitiveVolumes.end()) {
+        fSensitiveVolumes.push_back(name);
+    }
+    auto& volumes = fLogicalVolumes[name];
+    if (std::find(volumes.begin(), volumes.end(), lv) == volumes.end()) {
+        volumes.push_back(lv);
+    }
+}
+
 G4VPhysicalVolume* DetectorConstruction::Construct() {
     if (!fGdmlFile.empty()) {
         LoadGDML();
     } else {
         ConstructDefaultGeometry();
     }
+    StartupMetrics::Mark("geometry and materials");
     
     return fWorldPhysical;
 }
@@ -49,6 +140,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct() {
 void DetectorConstruction::LoadGDML() {
     fParser = new G4GDMLParser();
     fParser->Read(fGdmlFile, false);  // false = don't validate schema
+    StartupMetrics::Mark("GDML parsing");
     
     fWorldPhysical = fParser->GetWorldVolume();
     fWorldLogical = fWorldPhysical->GetLogicalVolume();
@@ -56,10 +148,108 @@ void DetectorConstruction::LoadGDML() {
     // Find sensitive volumes from GDML auxiliary info
     FindSensitiveVolumes(fWorldLogical);
     
+    // Attach regions with local cuts and limits from GDML auxiliary info
+    ConstructRegions();
+    ConstructFastShowerEnvelopes();
+    
     G4cout << "Loaded GDML geometry from: " << fGdmlFile << G4endl;
     G4cout << "Found " << fSensitiveVolumes.size() << " sensitive volumes" << G4endl;
 }
 
+void DetectorConstruction::ConstructRegions() {
+    const G4GDMLAuxMapType* auxMap = fParser->GetAuxMap();
+    if (!auxMap) return;
+    
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    
+    for (const auto& entry : *auxMap) {
+        G4LogicalVolume* lv = entry.first;
+        
+        // Collect region name and settings (siblings or nested under Region)
+        G4String regionName;
+        std::vector<const G4GDMLAuxStructType*> settings;
+        for (const auto& aux : entry.second) {
+            if (aux.type == "Region") {
+                regionName = aux.value;
+                if (aux.auxList) {
+                    for (const auto& sub : *aux.auxList) settings.push_back(&sub);
+                }
+            } else if (IsRegionSetting(aux.type)) {
+                settings.push_back(&aux);
+            }
+        }
+        
+        if (regionName.empty()) {
+            if (settings.empty()) continue;
+            regionName = lv->GetName() + "_Region";
+        }
+        
+        if (lv == fWorldLogical) {
+            G4Exception("DetectorConstruction::ConstructRegions()", "RegionOnWorld",
+                        JustWarning,
+                        "Region tags on the world volume are ignored, use /run/setCut instead");
+            continue;
+        }
+        
+        G4Region* region = regionStore->FindOrCreateRegion(regionName);
+        region->AddRootLogicalVolume(lv);
+        
+        for (const auto* aux : settings) {
+            if (!ApplyRegionAuxiliary(region, *aux)) {
+                G4cout << "  Ignored region setting " << aux->type
+                       << " on " << lv->GetName() << G4endl;
+            }
+        }
+        
+        G4cout << "  Region " << regionName << ": root volume " << lv->GetName();
+        if (region->GetProductionCuts()) {
+            G4cout << ", cut(e-) = "
+                   << G4BestUnit(region->GetProductionCuts()->GetProductionCut("e-"), "Length");
+        }
+        if (region->GetUserLimits()) {
+            G4cout << ", with user limits";
+        }
+        G4cout << G4endl;
+    }
+}
+
+G4bool DetectorConstruction::ApplyRegionAuxiliary(G4Region* region, const G4GDMLAuxStructType& aux) {
+    auto cut = kRegionCutParticles.find(aux.type);
+    if (cut != kRegionCutParticles.end()) {
+        G4ProductionCuts* cuts = region->GetProductionCuts();
+        if (!cuts) {
+            // Start from the current default cuts so that particles without an
+            // explicit tag keep the global value
+            cuts = new G4ProductionCuts(
+                *G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts());
+            region->SetProductionCuts(cuts);
+        }
+        G4double value = AuxValue(aux, "mm");
+        if (cut->second.empty()) cuts->SetProductionCut(value);
+        else cuts->SetProductionCut(value, cut->second);
+        return true;
+    }
+    
+    if (std::find(kRegionLimits.begin(), kRegionLimits.end(), aux.type) == kRegionLimits.end()) {
+        return false;
+    }
+    
+    // Limits require G4StepLimiterPhysics (registered in main)
+    G4UserLimits* limits = region->GetUserLimits();
+    if (!limits) {
+        limits = new G4UserLimits();
+        region->SetUserLimits(limits);
+    }
+    
+    if (aux.type == "MaxStep") limits->SetMaxAllowedStep(AuxValue(aux, "mm"));
+    else if (aux.type == "MaxTrackLength") limits->SetUserMaxTrackLength(AuxValue(aux, "mm"));
+    else if (aux.type == "MaxTime") limits->SetUserMaxTime(AuxValue(aux, "ns"));
+    else if (aux.type == "MinEkine") limits->SetUserMinEkine(AuxValue(aux, "MeV"));
+    else if (aux.type == "MinRange") limits->SetUserMinRange(AuxValue(aux, "mm"));
+    
+    return true;
+}
+
 void DetectorConstruction::FindSensitiveVolumes(G4LogicalVolume* lv) {
     // Check for SensDet auxiliary tag
     if (fParser) {
@@ -67,8 +257,7 @@ void DetectorConstruction::FindSensitiveVolumes(G4LogicalVolume* lv) {
         if (auxList) {
             for (auto& aux : *auxList) {
                 if (aux.type == "SensDet") {
-                    fSensitiveVolumes.push_back(lv->GetName());
-                    fLogicalVolumes[lv->GetName()] = lv;
+                    AddSensitiveVolume(lv->GetName(), lv);
                     G4cout << "  Sensitive detector: " << lv->GetName() << G4endl;
                 }
             }
@@ -82,6 +271,29 @@ void DetectorConstruction::FindSensitiveVolumes(G4LogicalVolume* lv) {
     }
 }
 
+void DetectorConstruction::ConstructFastShowerEnvelopes() {
+    // <auxiliary auxtype="FastShower" auxvalue="1" auxunit="GeV"/> marks a
+    // logical volume as a shower envelope, the value being the trigger threshold
+    for (const auto& entry : *fParser->GetAuxMap()) {
+        G4LogicalVolume* lv = entry.first;
+        for (const auto& aux : entry.second) {
+            if (aux.type != "FastShower") continue;
+            
+            // Reuse the region of a volume that is already a region root
+            G4Region* envelope = lv->IsRootRegion() ? lv->GetRegion() : nullptr;
+            if (!envelope) {
+                envelope = G4RegionStore::GetInstance()->FindOrCreateRegion(lv->GetName() + "_FastShower");
+                envelope->AddRootLogicalVolume(lv);
+            }
+            
+            G4double threshold = AuxValue(aux, "MeV");
+            fFastShowerEnvelopes.emplace_back(envelope, threshold);
+            G4cout << "  Fast shower envelope: " << lv->GetName()
+                   << " (threshold " << G4BestUnit(threshold, "Energy") << ")" << G4endl;
+        }
+    }
+}
+
 void DetectorConstruction::ConstructDefaultGeometry() {
     // Default: Water phantom with detector
     G4NistManager* nist = G4NistManager::Instance();
@@ -97,6 +309,12 @@ void DetectorConstruction::ConstructDefaultGeometry() {
     fWorldPhysical = new G4PVPlacement(nullptr, G4ThreeVector(), 
                                         fWorldLogical, "World", nullptr, false, 0);
     
+    if (!fCTHeader.empty()) {
+        ConstructVoxelPhantom();
+        fWorldLogical->SetVisAttributes(G4VisAttributes::GetInvisible());
+        return;
+    }
+    
     // Water phantom
     G4double phantomSize = 150.0*mm;
     G4Box* phantomSolid = new G4Box("Phantom", phantomSize, phantomSize, phantomSize);
@@ -106,8 +324,7 @@ void DetectorConstruction::ConstructDefaultGeometry() {
                       phantomLogical, "Phantom", fWorldLogical, false, 0);
     
     // Mark as sensitive
-    fSensitiveVolumes.push_back("Phantom");
-    fLogicalVolumes["Phantom"] = phantomLogical;
+    AddSensitiveVolume("Phantom", phantomLogical);
     
     // Visualization
     fWorldLogical->SetVisAttributes(G4VisAttributes::GetInvisible());
@@ -116,6 +333,33 @@ void DetectorConstruction::ConstructDefaultGeometry() {
     G4cout << "Constructed default water phantom geometry" << G4endl;
 }
 
+void DetectorConstruction::ConstructVoxelPhantom() {
+    fVoxelPhantom = new VoxelPhantom(fCTHeader);
+    fVoxelPhantom->SetDensityStep(fDensityStep);
+    fVoxelPhantom->Load();
+    
+    G4Box* worldBox = static_cast<G4Box*>(fWorldLogical->GetSolid());
+    if (fVoxelPhantom->GetHalfX() > worldBox->GetXHalfLength() ||
+        fVoxelPhantom->GetHalfY() > worldBox->GetYHalfLength() ||
+        fVoxelPhantom->GetHalfZ() > worldBox->GetZHalfLength()) {
+        G4Exception("DetectorConstruction::ConstructVoxelPhantom()", "PhantomTooLarge",
+                    FatalException, "CT volume does not fit in the world");
+    }
+    
+    // All voxel volumes share the "Phantom" sensitive detector
+    for (G4LogicalVolume* lv : fVoxelPhantom->Build(fWorldLogical, fRegularNavigation)) {
+        AddSensitiveVolume("Phantom", lv);
+    }
+    
+    if (fWoodcock) {
+        fWoodcockEnvelope = G4RegionStore::GetInstance()->FindOrCreateRegion("PhantomWoodcock");
+        fWoodcockEnvelope->AddRootLogicalVolume(fVoxelPhantom->GetContainer());
+        G4cout << "Woodcock tracking of photons in the phantom" << G4endl;
+    }
+    
+    G4cout << "Constructed voxel phantom from " << fCTHeader << G4endl;
+}
+
 void DetectorConstruction::ConstructSDandField() {
     G4SDManager* sdManager = G4SDManager::GetSDMpointer();
     
@@ -124,10 +368,20 @@ void DetectorConstruction::ConstructSDandField() {
         SensitiveDetector* sd = new SensitiveDetector(sdName, name + "_HC");
         sdManager->AddNewDetector(sd);
         
-        if (fLogicalVolumes.count(name)) {
-            SetSensitiveDetector(fLogicalVolumes[name], sd);
-            G4cout << "Attached SD to: " << name << G4endl;
+        for (G4LogicalVolume* lv : fLogicalVolumes[name]) {
+            SetSensitiveDetector(lv, sd);
         }
+        G4cout << "Attached SD to: " << name << G4endl;
+    }
+    
+    // Shower models are thread-local; they only act when the fast simulation
+    // physics is registered (geant4api --fast-shower)
+    for (const auto& envelope : fFastShowerEnvelopes) {
+        new FastShowerModel(envelope.first->GetName() + "_Model", envelope.first, envelope.second);
+    }
+    if (fWoodcockEnvelope) {
+        new WoodcockModel("PhantomWoodcock_Model", fWoodcockEnvelope, fVoxelPhantom);
     }
+    StartupMetrics::Mark("sensitive detectors and fields");
 }
 
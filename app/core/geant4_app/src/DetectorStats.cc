@@ -0,0 +1,217 @@
+/**
+ * Detector Statistics Implementation
+ */
+
+#include "DetectorStats.hh"
+#include "SensitiveDetector.hh"
+
+#include "G4HCofThisEvent.hh"
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace {
+
+G4Mutex statsMutex = G4MUTEX_INITIALIZER;
+
+struct Merged {
+    G4long hits = 0;
+    DetectorStats::Moments edep;
+    TDigest digest;
+};
+
+// Per detector name, merged over the threads of a run
+std::map<G4String, Merged> mergedDetectors;
+G4long mergedEvents = 0;
+
+const G4double kQuantiles[] = {0.05, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99};
+const char* const kQuantileNames[] = {"p05", "p25", "p50", "p75", "p90", "p95", "p99"};
+
+G4String JsonString(const G4String& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+G4double Rms(const DetectorStats::Moments& moments) {
+    return moments.count > 1 ? std::sqrt(moments.m2 / (moments.count - 1)) : 0.;
+}
+
+// Summary of one detector; with the centroids for the file
+void WriteDetector(std::ostream& out, const G4String& name, Merged& merged, G4bool centroids) {
+    out << "{\"name\": " << JsonString(name)
+        << ", \"hits\": " << merged.hits
+        << ", \"count\": " << merged.edep.count
+        << ", \"mean\": " << merged.edep.mean
+        << ", \"m2\": " << merged.edep.m2
+        << ", \"min\": " << merged.edep.min
+        << ", \"max\": " << merged.edep.max
+        << ", \"quantiles\": {";
+    for (std::size_t i = 0; i < sizeof(kQuantiles) / sizeof(kQuantiles[0]); i++) {
+        out << (i ? ", " : "") << "\"" << kQuantileNames[i] << "\": " << merged.digest.Quantile(kQuantiles[i]);
+    }
+    out << "}";
+    if (centroids) {
+        out << ", \"centroids\": [";
+        G4bool first = true;
+        for (const TDigest::Centroid& centroid : merged.digest.GetCentroids()) {
+            out << (first ? "" : ", ") << "[" << centroid.mean << ", " << centroid.weight << "]";
+            first = false;
+        }
+        out << "]";
+    }
+    out << "}";
+}
+
+}
+
+DetectorStats::DetectorStats()
+    : fCompression(200.),
+      fNofEvents(0),
+      fDetectors(),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/stats/", "Per-detector run statistics");
+
+    fMessenger->DeclareProperty("compression", fCompression)
+        .SetGuidance("Compression of the quantile sketches: about 0.6 centroids per unit,")
+        .SetGuidance("higher values give more accurate tails.")
+        .SetParameterName("compression", false)
+        .SetRange("compression>=20")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+DetectorStats::~DetectorStats() {
+    delete fMessenger;
+}
+
+void DetectorStats::BeginOfRun() {
+    fNofEvents = 0;
+    fDetectors.clear();
+
+    // The master starts the run before the workers
+    if (G4Threading::IsMasterThread()) {
+        G4AutoLock lock(&statsMutex);
+        mergedDetectors.clear();
+        mergedEvents = 0;
+    }
+}
+
+void DetectorStats::AddEvent(G4HCofThisEvent* hce) {
+    fNofEvents += 1;
+    if (!hce) return;
+
+    for (G4int i = 0; i < hce->GetNumberOfCollections(); i++) {
+        auto hc = static_cast<DetectorHitsCollection*>(hce->GetHC(i));
+        if (!hc || hc->entries() == 0) continue;
+
+        if (i >= G4int(fDetectors.size())) {
+            fDetectors.resize(i + 1, Detector{G4String(), 0, Moments(), TDigest(fCompression)});
+        }
+        Detector& detector = fDetectors[i];
+        if (detector.name.empty()) detector.name = hc->GetSDname();
+
+        G4double edep = 0.;
+        for (std::size_t j = 0; j < hc->entries(); j++) {
+            const DetectorHit* hit = (*hc)[j];
+            edep += hit->GetEnergyDeposit() * hit->GetWeight();
+        }
+        detector.hits += hc->entries();
+        detector.edep.Add(edep / MeV);
+        detector.digest.Add(edep / MeV);
+    }
+}
+
+void DetectorStats::EndOfRun(const G4String& outputDir, G4int runID) {
+    {
+        G4AutoLock lock(&statsMutex);
+        for (const Detector& detector : fDetectors) {
+            if (detector.edep.count == 0) continue;
+            auto inserted = mergedDetectors.emplace(detector.name, Merged());
+            Merged& merged = inserted.first->second;
+            if (inserted.second) merged.digest = TDigest(fCompression);
+            merged.hits += detector.hits;
+            merged.edep.Merge(detector.edep);
+            merged.digest.Merge(detector.digest);
+        }
+        mergedEvents += fNofEvents;
+    }
+    fDetectors.clear();
+
+    // Workers have all finished their run when the master ends it
+    if (G4Threading::IsMasterThread()) Report(outputDir, runID);
+}
+
+void DetectorStats::Report(const G4String& outputDir, G4int runID) const {
+    G4AutoLock lock(&statsMutex);
+    if (mergedDetectors.empty()) return;
+
+    G4cout << G4endl
+           << "--------------------Detector statistics-----------------------" << G4endl
+           << " Energy per event with hits [MeV], " << mergedEvents << " events" << G4endl;
+    {
+        // Formatted apart so that G4cout keeps its format
+        std::ostringstream table;
+        table << "  " << std::left << std::setw(20) << "detector" << std::right
+              << std::setw(10) << "events" << std::setw(12) << "hits"
+              << std::setw(11) << "mean" << std::setw(11) << "rms"
+              << std::setw(11) << "p50" << std::setw(11) << "p99" << std::setw(11) << "max";
+        for (auto& entry : mergedDetectors) {
+            Merged& merged = entry.second;
+            table << "\n  " << std::left << std::setw(20) << entry.first << std::right
+                  << std::setw(10) << merged.edep.count << std::setw(12) << merged.hits
+                  << std::setprecision(4)
+                  << std::setw(11) << merged.edep.mean << std::setw(11) << Rms(merged.edep)
+                  << std::setw(11) << merged.digest.Quantile(0.5) << std::setw(11) << merged.digest.Quantile(0.99)
+                  << std::setw(11) << merged.edep.max;
+        }
+        G4cout << table.str() << G4endl;
+    }
+    G4cout << "------------------------------------------------------------" << G4endl;
+
+    // Summaries for the REST API, one line
+    std::ostringstream record;
+    record << std::setprecision(9)
+           << "{\"record\": \"detectors\", \"run\": " << runID << ", \"events\": " << mergedEvents
+           << ", \"unit\": \"MeV\", \"detectors\": [";
+    G4bool first = true;
+    for (auto& entry : mergedDetectors) {
+        record << (first ? "" : ", ");
+        WriteDetector(record, entry.first, entry.second, false);
+        first = false;
+    }
+    record << "]}";
+    G4cout << "METRICS " << record.str() << G4endl;
+
+    std::ostringstream fileName;
+    fileName << outputDir << "/detector_stats_run" << runID << ".json";
+    std::ofstream out(fileName.str());
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName.str();
+        G4Exception("DetectorStats::Report()", "StatsFile", JustWarning, msg);
+        return;
+    }
+    out << std::setprecision(9)
+        << "{\n  \"run\": " << runID
+        << ",\n  \"events\": " << mergedEvents
+        << ",\n  \"unit\": \"MeV\""
+        << ",\n  \"detectors\": [";
+    first = true;
+    for (auto& entry : mergedDetectors) {
+        out << (first ? "\n    " : ",\n    ");
+        WriteDetector(out, entry.first, entry.second, true);
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
@@ -5,6 +5,9 @@
 #include "EventAction.hh"
 #include "RunAction.hh"
 #include "Analysis.hh"
+#include "EventRecorder.hh"
+#include "TrajectoryRecorder.hh"
+#include "SensitiveDetector.hh"
 
 #include "G4Event.hh"
 #include "G4RunManager.hh"
@@ -12,25 +15,61 @@
 #include "G4HCofThisEvent.hh"
 #include "G4SDManager.hh"
 
+#include <sstream>
+
 EventAction::EventAction(RunAction* runAction)
     : G4UserEventAction(),
       fRunAction(runAction),
-      fEdep(0.)
+      fEdep(0.),
+      fStart(),
+      fDetectorEdep()
 {}
 
 EventAction::~EventAction() {}
 
 void EventAction::BeginOfEventAction(const G4Event* event) {
+    fRunAction->GetMemory()->BeginOfEvent(fRunAction->GetTimeline());
+    if (fRunAction->GetTimeline()->IsActive()) fStart = Timeline::Clock::now();
     fEdep = 0.;
-    
-    // Print progress every 100 events
+    fRunAction->GetTrajectories()->Clear();
     G4int eventID = event->GetEventID();
+    EventGuard* guard = fRunAction->GetGuard();
+    if (guard->IsActive()) guard->BeginOfEvent(eventID);
+    
+    // Report progress every 100 events
     if (eventID % 100 == 0) {
-        G4cout << "---> Event " << eventID << G4endl;
+        fRunAction->GetLog()->Log(LogSink::kInfo, "progress").Add("event", eventID);
     }
 }
 
 void EventAction::EndOfEventAction(const G4Event* event) {
+    // Tracking of the event, then its output (histograms, ntuple, trajectories)
+    Timeline* timeline = fRunAction->GetTimeline();
+    timeline->Record("event", fStart, event->GetEventID());
+    Timeline::Scope output(timeline, "end of event", event->GetEventID());
+    
+    EventGuard* guard = fRunAction->GetGuard();
+    if (guard->IsActive()) guard->EndOfEvent();
+    TrajectoryRecorder* trajectories = fRunAction->GetTrajectories();
+    
+    // A replayed event keeps the run and event numbers of the original
+    if (EventRecorder::IsReplay()) {
+        G4int runID = EventRecorder::GetReplayRun();
+        G4int eventID = EventRecorder::GetReplayEvent();
+        G4cout << "    Replayed event " << eventID << ": edep = " << fEdep/MeV << " MeV, "
+               << trajectories->GetNofTrajectories() << " tracks" << G4endl;
+        std::ostringstream fileName;
+        fileName << fRunAction->GetOutputDir() << "/replay_run" << runID << "_event" << eventID << ".json";
+        trajectories->WriteJson(fileName.str(), runID, eventID);
+        return;
+    }
+    
+    // Events aborted by the guard or the memory watchdog are incomplete
+    if (event->IsAborted()) {
+        trajectories->EndOfEvent(event->GetEventID(), false);
+        return;
+    }
+    
     // Accumulate energy deposit
     fRunAction->AddEdep(fEdep);
     
@@ -38,15 +77,52 @@ void EventAction::EndOfEventAction(const G4Event* event) {
     Analysis* analysis = Analysis::Instance();
     analysis->FillH1(0, fEdep/MeV);
     
+    // Hit count of the event, and the deposit per detector for the trigger
+    G4HCofThisEvent* hce = event->GetHCofThisEvent();
+    EventTrigger& trigger = fRunAction->GetTrigger();
+    if (hce) {
+        G4int nofHits = 0;
+        fDetectorEdep.assign(hce->GetNumberOfCollections(), 0.);
+        for (G4int i = 0; i < hce->GetNumberOfCollections(); i++) {
+            auto hits = static_cast<DetectorHitsCollection*>(hce->GetHC(i));
+            if (!hits) continue;
+            nofHits += G4int(hits->entries());
+            if (!trigger.IsActive()) continue;
+            for (std::size_t j = 0; j < hits->entries(); j++) {
+                fDetectorEdep[i] += (*hits)[j]->GetEnergyDeposit();
+            }
+        }
+        fRunAction->AddHits(nofHits);
+        MemoryWatchdog::Publish(MemoryWatchdog::kHits, nofHits * sizeof(DetectorHit));
+    }
+    fRunAction->GetDetectorStats()->AddEvent(hce);
+    
+    // Run totals and the histogram see every event; the ntuple and the
+    // printout only the triggered ones
+    G4bool accepted = !trigger.IsActive() || (hce && trigger.Accept(fDetectorEdep));
+    trajectories->EndOfEvent(event->GetEventID(), accepted);
+    
+    // Buffered output of this thread, flushed once when memory runs short
+    LogSink* log = fRunAction->GetLog();
+    MemoryWatchdog* memory = fRunAction->GetMemory();
+    MemoryWatchdog::Publish(MemoryWatchdog::kOutput, trajectories->GetBufferedBytes() +
+                            log->GetBufferedBytes() + timeline->GetBufferedBytes());
+    if (memory->FlushRequested()) {
+        log->Flush();
+        trajectories->Flush();
+    }
+    if (!accepted) return;
+    fRunAction->CountAccepted();
+    
     // Fill ntuple
     G4int eventID = event->GetEventID();
     analysis->FillNtupleIColumn(0, eventID);
     analysis->FillNtupleDColumn(1, fEdep/MeV);
     analysis->AddNtupleRow();
     
-    // Print event summary for significant events
-    if (fEdep > 0.1*MeV) {
-        G4cout << "    Event " << eventID << ": edep = " << fEdep/MeV << " MeV" << G4endl;
+    // Summary of significant events
+    if (fEdep > 0.1*MeV && !MemoryWatchdog::IsDegraded()) {
+        log->Log(LogSink::kInfo, "event").Add("event", eventID).Add("edep_mev", fEdep/MeV);
     }
 }
 
@@ -0,0 +1,273 @@
+/**
+ * Event Guard Implementation
+ */
+
+#include "EventGuard.hh"
+#include "LogSink.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+G4Mutex guardMutex = G4MUTEX_INITIALIZER;
+
+const char* const kLimitNames[] = {"track_steps", "event_steps", "event_time"};
+const char* const kActionNames[] = {"kill", "abort", "flag"};
+// Events listed per limit and volume
+const std::size_t kMaxEvents = 10;
+
+struct Merged {
+    G4long triggers = 0;
+    std::vector<G4int> events;
+};
+
+// Counts per (limit, volume), merged over the threads of a run
+std::map<std::pair<G4int, G4String>, Merged> mergedCounts;
+G4long mergedKilledTracks = 0;
+G4double mergedKilledEnergy = 0.;
+G4long mergedAbortedEvents = 0;
+G4double mergedSlowestTime = 0.;
+G4long mergedSlowestSteps = 0;
+G4int mergedSlowestEvent = -1;
+
+EventGuard::Action ParseAction(const G4String& action) {
+    if (action == "abort") return EventGuard::kAbort;
+    if (action == "flag") return EventGuard::kFlag;
+    return EventGuard::kKill;
+}
+
+}
+
+EventGuard::EventGuard(LogSink* log)
+    : fLog(log),
+      fActive(false),
+      fMaxTrackSteps(0),
+      fMaxEventSteps(0),
+      fMaxEventTime(0.),
+      fTrackAction(kKill),
+      fEventAction(kAbort),
+      fEventID(-1),
+      fTrackSteps(0),
+      fEventSteps(0),
+      fEventStart(0.),
+      fTrackTriggered(false),
+      fEventTriggered(0),
+      fEventAborted(false),
+      fCounts(),
+      fNofKilledTracks(0),
+      fKilledEnergy(0.),
+      fNofAbortedEvents(0),
+      fSlowestTime(0.),
+      fSlowestSteps(0),
+      fSlowestEvent(-1),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/guard/", "Track and event step and time limits");
+
+    fMessenger->DeclareProperty("trackSteps", fMaxTrackSteps)
+        .SetGuidance("Steps of one track before trackAction applies (0 = no limit).")
+        .SetParameterName("steps", false)
+        .SetRange("steps>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("trackAction", &EventGuard::SetTrackAction)
+        .SetGuidance("What a track over the step limit gets: kill it, abort its event,")
+        .SetGuidance("or flag it and continue.")
+        .SetParameterName("action", false)
+        .SetCandidates("kill abort flag")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("eventSteps", fMaxEventSteps)
+        .SetGuidance("Steps of one event before eventAction applies (0 = no limit).")
+        .SetParameterName("steps", false)
+        .SetRange("steps>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("eventTime", fMaxEventTime)
+        .SetGuidance("CPU seconds of one event before eventAction applies (0 = no limit).")
+        .SetParameterName("seconds", false)
+        .SetRange("seconds>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("eventAction", &EventGuard::SetEventAction)
+        .SetGuidance("What an event over the step or time limit gets: abort it,")
+        .SetGuidance("or flag it and continue.")
+        .SetParameterName("action", false)
+        .SetCandidates("abort flag")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+EventGuard::~EventGuard() {
+    delete fMessenger;
+}
+
+void EventGuard::SetTrackAction(const G4String& action) {
+    fTrackAction = ParseAction(action);
+}
+
+void EventGuard::SetEventAction(const G4String& action) {
+    fEventAction = ParseAction(action);
+}
+
+G4double EventGuard::CpuSeconds() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + 1e-9 * now.tv_nsec;
+#else
+    // Wall time where the thread's CPU time is not available
+    return std::chrono::duration<G4double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void EventGuard::BeginOfRun() {
+    fActive = fMaxTrackSteps > 0 || fMaxEventSteps > 0 || fMaxEventTime > 0.;
+    fCounts.clear();
+    fNofKilledTracks = 0;
+    fKilledEnergy = 0.;
+    fNofAbortedEvents = 0;
+    fSlowestTime = 0.;
+    fSlowestSteps = 0;
+    fSlowestEvent = -1;
+    if (!fActive) return;
+
+    // The master starts the run before the workers
+    if (G4Threading::IsMasterThread()) {
+        G4AutoLock lock(&guardMutex);
+        mergedCounts.clear();
+        mergedKilledTracks = 0;
+        mergedKilledEnergy = 0.;
+        mergedAbortedEvents = 0;
+        mergedSlowestTime = 0.;
+        mergedSlowestSteps = 0;
+        mergedSlowestEvent = -1;
+    }
+}
+
+void EventGuard::BeginOfEvent(G4int eventID) {
+    fEventID = eventID;
+    fEventSteps = 0;
+    fEventTriggered = 0;
+    fEventAborted = false;
+    fEventStart = CpuSeconds();
+}
+
+void EventGuard::EndOfEvent() {
+    G4double seconds = CpuSeconds() - fEventStart;
+    if (seconds > fSlowestTime) {
+        fSlowestTime = seconds;
+        fSlowestSteps = fEventSteps;
+        fSlowestEvent = fEventID;
+    }
+}
+
+void EventGuard::Trigger(Limit limit, const G4Step* step) {
+    Action action = (limit == kTrackSteps ? fTrackAction : fEventAction);
+    if (limit == kTrackSteps) fTrackTriggered = true;
+    else fEventTriggered |= 1 << limit;
+
+    G4Track* track = step->GetTrack();
+    const G4VPhysicalVolume* volume = step->GetPreStepPoint()->GetPhysicalVolume();
+    G4String volumeName = volume ? volume->GetLogicalVolume()->GetName() : G4String("OutOfWorld");
+
+    Count& count = fCounts[std::make_pair(G4int(limit), volumeName)];
+    count.triggers += 1;
+    if (count.events.size() < kMaxEvents && (count.events.empty() || count.events.back() != fEventID)) {
+        count.events.push_back(fEventID);
+    }
+
+    fLog->Log(LogSink::kWarning, "guard")
+        .Add("limit", G4String(kLimitNames[limit]))
+        .Add("action", G4String(kActionNames[action]))
+        .Add("event", fEventID)
+        .Add("volume", volumeName)
+        .Add("particle", track->GetParticleDefinition()->GetParticleName())
+        .Add("track", track->GetTrackID())
+        .Add("steps", limit == kTrackSteps ? fTrackSteps : fEventSteps)
+        .Add("cpu_s", CpuSeconds() - fEventStart)
+        .Add("ke_mev", track->GetKineticEnergy() / MeV);
+
+    if (action == kKill) {
+        fNofKilledTracks += 1;
+        fKilledEnergy += track->GetKineticEnergy();
+        track->SetTrackStatus(fStopAndKill);
+    } else if (action == kAbort && !fEventAborted) {
+        fEventAborted = true;
+        fNofAbortedEvents += 1;
+        G4RunManager::GetRunManager()->AbortEvent();
+    }
+}
+
+void EventGuard::EndOfRun() {
+    if (!fActive) return;
+
+    {
+        G4AutoLock lock(&guardMutex);
+        for (const auto& entry : fCounts) {
+            Merged& merged = mergedCounts[entry.first];
+            merged.triggers += entry.second.triggers;
+            merged.events.insert(merged.events.end(), entry.second.events.begin(), entry.second.events.end());
+        }
+        mergedKilledTracks += fNofKilledTracks;
+        mergedKilledEnergy += fKilledEnergy;
+        mergedAbortedEvents += fNofAbortedEvents;
+        if (fSlowestTime > mergedSlowestTime) {
+            mergedSlowestTime = fSlowestTime;
+            mergedSlowestSteps = fSlowestSteps;
+            mergedSlowestEvent = fSlowestEvent;
+        }
+    }
+    fCounts.clear();
+
+    // Workers have all finished their run when the master ends it
+    if (G4Threading::IsMasterThread()) Report();
+}
+
+void EventGuard::Report() const {
+    G4AutoLock lock(&guardMutex);
+
+    G4cout << G4endl
+           << "--------------------Event guard-------------------------------" << G4endl
+           << " Limits:";
+    if (fMaxTrackSteps > 0) G4cout << " " << fMaxTrackSteps << " steps/track (" << kActionNames[fTrackAction] << ")";
+    if (fMaxEventSteps > 0) G4cout << " " << fMaxEventSteps << " steps/event (" << kActionNames[fEventAction] << ")";
+    if (fMaxEventTime > 0.) G4cout << " " << fMaxEventTime << " s/event (" << kActionNames[fEventAction] << ")";
+    G4cout << G4endl;
+
+    for (auto& entry : mergedCounts) {
+        // Formatted apart so that G4cout keeps its format
+        std::vector<G4int>& events = entry.second.events;
+        std::sort(events.begin(), events.end());
+        events.erase(std::unique(events.begin(), events.end()), events.end());
+        std::ostringstream line;
+        line << "  " << std::left << std::setw(12) << kLimitNames[entry.first.first]
+             << std::setw(24) << entry.first.second << std::right
+             << std::setw(10) << entry.second.triggers << "  events";
+        for (std::size_t i = 0; i < events.size() && i < kMaxEvents; i++) line << " " << events[i];
+        if (events.size() > kMaxEvents) line << " ...";
+        G4cout << line.str() << G4endl;
+    }
+
+    G4cout << " Killed tracks: " << mergedKilledTracks << " (" << mergedKilledEnergy / MeV << " MeV)"
+           << ", aborted events: " << mergedAbortedEvents << G4endl;
+    if (mergedSlowestEvent >= 0) {
+        G4cout << " Slowest event: " << mergedSlowestEvent << " (" << mergedSlowestTime << " s CPU, "
+               << mergedSlowestSteps << " steps)" << G4endl;
+    }
+    G4cout << "------------------------------------------------------------" << G4endl;
+}
@@ -0,0 +1,192 @@
+/**
+ * Event Recorder Implementation
+ */
+
+#include "EventRecorder.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const char kMagic[4] = {'G', '4', 'E', 'R'};
+const std::uint32_t kVersion = 1;
+
+// Seeds are kept in [1, 2^31) so every engine accepts them
+std::uint32_t DrawSeed() {
+    return 1 + std::uint32_t(G4UniformRand() * 2147483646.);
+}
+
+}
+
+G4bool EventRecorder::fgReplay = false;
+G4int EventRecorder::fgReplayRun = -1;
+G4int EventRecorder::fgReplayEvent = -1;
+EventRecorder::Record EventRecorder::fgReplayRecord = {};
+
+EventRecorder::EventRecorder()
+    : fEnabled(true),
+      fCurrent(),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/replay/", "Per-event seeds for replay");
+
+    fMessenger->DeclareProperty("record", fEnabled)
+        .SetGuidance("Write seeds and primary vertex of every event (24 bytes/event).")
+        .SetGuidance("Events are reseeded either way, so results do not depend on it.")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+EventRecorder::~EventRecorder() {
+    EndOfRun();
+    delete fMessenger;
+}
+
+G4String EventRecorder::FileName(const G4String& outputDir, G4int runID, G4int thread) {
+    std::ostringstream name;
+    name << outputDir << "/events_run" << runID;
+    if (thread >= 0) name << "_t" << thread;
+    name << ".rec";
+    return name.str();
+}
+
+void EventRecorder::BeginOfRun(const G4String& outputDir, G4int runID) {
+    if (!fEnabled || fgReplay ||
+        (G4Threading::IsMasterThread() && G4Threading::IsMultithreadedApplication())) {
+        return;
+    }
+
+    G4String fileName = FileName(outputDir, runID, G4Threading::G4GetThreadId());
+    fFile.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!fFile) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName << "; events of this run cannot be replayed";
+        G4Exception("EventRecorder::BeginOfRun()", "RecordFile", JustWarning, msg);
+        return;
+    }
+
+    std::int32_t run = runID;
+    fFile.write(kMagic, sizeof(kMagic));
+    fFile.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    fFile.write(reinterpret_cast<const char*>(&run), sizeof(run));
+}
+
+void EventRecorder::EndOfRun() {
+    if (fFile.is_open()) fFile.close();
+}
+
+void EventRecorder::SeedEvent(G4int eventID) {
+    fCurrent.eventID = eventID;
+    if (fgReplay) {
+        fCurrent.seeds[0] = fgReplayRecord.seeds[0];
+        fCurrent.seeds[1] = fgReplayRecord.seeds[1];
+    } else {
+        fCurrent.seeds[0] = DrawSeed();
+        fCurrent.seeds[1] = DrawSeed();
+    }
+
+    long seeds[3] = {long(fCurrent.seeds[0]), long(fCurrent.seeds[1]), 0};
+    G4Random::setTheSeeds(seeds, -1);
+}
+
+void EventRecorder::RecordEvent(const G4Event* event) {
+    const G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+    G4ThreeVector position = vertex ? vertex->GetPosition() : G4ThreeVector();
+    fCurrent.vertex[0] = float(position.x()/mm);
+    fCurrent.vertex[1] = float(position.y()/mm);
+    fCurrent.vertex[2] = float(position.z()/mm);
+
+    if (fgReplay) {
+        // Same seeds and configuration must give the same primary
+        G4double distance = 0.;
+        for (G4int i = 0; i < 3; i++) {
+            distance = std::max(distance, std::abs(G4double(fCurrent.vertex[i] - fgReplayRecord.vertex[i])));
+        }
+        if (distance > 1e-3 * (1. + position.mag()/mm)) {
+            G4ExceptionDescription msg;
+            msg << "Replayed vertex (" << fCurrent.vertex[0] << ", " << fCurrent.vertex[1] << ", "
+                << fCurrent.vertex[2] << ") mm differs from the recorded one ("
+                << fgReplayRecord.vertex[0] << ", " << fgReplayRecord.vertex[1] << ", "
+                << fgReplayRecord.vertex[2] << ") mm; is the macro the one of the original run?";
+            G4Exception("EventRecorder::RecordEvent()", "ReplayMismatch", JustWarning, msg);
+        }
+        return;
+    }
+
+    if (!fFile.is_open()) return;
+    fFile.write(reinterpret_cast<const char*>(&fCurrent), sizeof(Record));
+}
+
+void EventRecorder::SetReplay(G4int runID, G4int eventID) {
+    fgReplay = true;
+    fgReplayRun = runID;
+    fgReplayEvent = eventID;
+}
+
+G4bool EventRecorder::LoadReplay(const G4String& outputDir) {
+    // Sequential runs write one file, multithreaded runs one per worker.
+    // Only one kind is read: a file of the other kind is left over from an
+    // earlier run in the other mode.
+    std::vector<G4String> files;
+    for (G4int thread = 0; ; thread++) {
+        G4String fileName = FileName(outputDir, fgReplayRun, thread);
+        if (!std::ifstream(fileName)) break;
+        files.push_back(fileName);
+    }
+    G4String sequential = FileName(outputDir, fgReplayRun, -1);
+    if (files.empty()) {
+        files.push_back(sequential);
+    } else if (std::ifstream(sequential)) {
+        G4ExceptionDescription msg;
+        msg << "Both " << sequential << " and per-thread records (events_run" << fgReplayRun
+            << "_t*.rec) exist; reading the per-thread records. Remove the files of the mode not replayed.";
+        G4Exception("EventRecorder::LoadReplay()", "ReplayRecord", JustWarning, msg);
+    }
+
+    for (const auto& fileName : files) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) continue;
+
+        char magic[4];
+        std::uint32_t version = 0;
+        std::int32_t run = -1;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(&run), sizeof(run));
+        if (!file || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion) {
+            G4ExceptionDescription msg;
+            msg << fileName << " is not an event record file";
+            G4Exception("EventRecorder::LoadReplay()", "RecordFile", JustWarning, msg);
+            continue;
+        }
+
+        Record record;
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(Record))) {
+            if (record.eventID == fgReplayEvent) {
+                fgReplayRecord = record;
+                G4cout << "Replaying run " << fgReplayRun << " event " << fgReplayEvent
+                       << " from " << fileName << ": seeds " << record.seeds[0] << " "
+                       << record.seeds[1] << G4endl;
+                return true;
+            }
+        }
+    }
+
+    G4ExceptionDescription msg;
+    msg << "No record of run " << fgReplayRun << " event " << fgReplayEvent
+        << " in " << outputDir << " (events_run" << fgReplayRun << "*.rec)";
+    G4Exception("EventRecorder::LoadReplay()", "ReplayRecord", JustWarning, msg);
+    return false;
+}
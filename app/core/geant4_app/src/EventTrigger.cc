@@ -0,0 +1,176 @@
+/**
+ * Event Trigger Implementation
+ */
+
+#include "EventTrigger.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4UnitsTable.hh"
+
+#include <sstream>
+
+EventTrigger::EventTrigger(const G4String& directory, const G4String& defaultUnit, DetectorIndex index)
+    : fDefaultUnit(defaultUnit),
+      fIndex(index),
+      fMinDetectors(0),
+      fHitThreshold(0.),
+      fResolved(false),
+      fMessenger(nullptr)
+{
+    // Created on every thread so that commands reach the workers
+    fMessenger = new G4GenericMessenger(this, directory, "Event selection before output");
+
+    fMessenger->DeclareMethod("minDetectors", &EventTrigger::SetMinDetectors)
+        .SetGuidance("Minimum number of detectors hit (0 disables).")
+        .SetParameterName("n", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclarePropertyWithUnit("threshold", "keV", fHitThreshold)
+        .SetGuidance("Deposit above which a detector counts as hit.")
+        .SetParameterName("edep", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("edepWindow", &EventTrigger::AddEdepWindow)
+        .SetGuidance("Require the deposit of one detector, or of all of them, in [min, max).")
+        .SetGuidance("Arguments: <detector|all> min max [unit], unit defaults to " + defaultUnit + ".")
+        .SetParameterName("window", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("coincidence", &EventTrigger::AddCoincidence)
+        .SetGuidance("Require all listed detectors to be hit in the same event.")
+        .SetGuidance("Each command adds one coincidence; all of them must pass.")
+        .SetParameterName("detectors", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareMethod("clear", &EventTrigger::Clear)
+        .SetGuidance("Remove all trigger conditions (accept every event).")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+EventTrigger::~EventTrigger() {
+    delete fMessenger;
+}
+
+G4bool EventTrigger::IsActive() const {
+    return fMinDetectors > 0 || !fWindows.empty() || !fCoincidences.empty();
+}
+
+void EventTrigger::AddEdepWindow(const G4String& args) {
+    std::istringstream is(args);
+    EdepWindow window;
+    G4String unit = fDefaultUnit;
+    if (!(is >> window.detector >> window.min >> window.max)) {
+        G4ExceptionDescription msg;
+        msg << "Expected \"<detector|all> min max [unit]\", got \"" << args << "\"";
+        G4Exception("EventTrigger::AddEdepWindow()", "TriggerWindow", JustWarning, msg);
+        return;
+    }
+    is >> unit;
+    // Unknown units have the value 0
+    G4double value = G4UnitDefinition::GetValueOf(unit);
+    if (value <= 0.) {
+        G4ExceptionDescription msg;
+        msg << "Unknown unit \"" << unit << "\" in \"" << args << "\"; window not added";
+        G4Exception("EventTrigger::AddEdepWindow()", "TriggerWindow", JustWarning, msg);
+        return;
+    }
+    window.min *= value;
+    window.max *= value;
+    window.index = kAll;
+    fWindows.push_back(window);
+    fResolved = false;
+}
+
+void EventTrigger::AddCoincidence(const G4String& args) {
+    std::istringstream is(args);
+    Coincidence coincidence;
+    G4String name;
+    while (is >> name) coincidence.detectors.push_back(name);
+    if (coincidence.detectors.size() < 2) {
+        G4ExceptionDescription msg;
+        msg << "A coincidence needs at least two detectors, got \"" << args << "\"";
+        G4Exception("EventTrigger::AddCoincidence()", "TriggerCoincidence", JustWarning, msg);
+        return;
+    }
+    fCoincidences.push_back(coincidence);
+    fResolved = false;
+}
+
+void EventTrigger::Clear() {
+    fMinDetectors = 0;
+    fWindows.clear();
+    fCoincidences.clear();
+    fResolved = false;
+}
+
+G4int EventTrigger::Index(const G4String& detector) const {
+    G4int index = fIndex(detector);
+    if (index < 0) {
+        G4ExceptionDescription msg;
+        msg << "Trigger detector " << detector << " is unknown";
+        G4Exception("EventTrigger::Index()", "TriggerDetector", FatalErrorInArgument, msg);
+    }
+    return index;
+}
+
+void EventTrigger::Resolve() {
+    for (auto& window : fWindows) {
+        window.index = window.detector == "all" ? kAll : Index(window.detector);
+    }
+    for (auto& coincidence : fCoincidences) {
+        coincidence.indices.clear();
+        for (const auto& detector : coincidence.detectors) {
+            coincidence.indices.push_back(Index(detector));
+        }
+    }
+    fResolved = true;
+}
+
+G4bool EventTrigger::Accept(const std::vector<G4double>& edep) {
+    if (!IsActive()) return true;
+    if (!fResolved) Resolve();
+
+    G4int nofDetectors = G4int(edep.size());
+    G4int nofHit = 0;
+    G4double total = 0.;
+    for (G4double value : edep) {
+        if (value > fHitThreshold) nofHit++;
+        total += value;
+    }
+
+    if (nofHit < fMinDetectors) return false;
+
+    for (const auto& window : fWindows) {
+        G4double value = total;
+        if (window.index != kAll) value = window.index < nofDetectors ? edep[window.index] : 0.;
+        if (value < window.min || value >= window.max) return false;
+    }
+
+    for (const auto& coincidence : fCoincidences) {
+        for (G4int index : coincidence.indices) {
+            if (index >= nofDetectors || edep[index] <= fHitThreshold) return false;
+        }
+    }
+
+    return true;
+}
+
+void EventTrigger::Print() const {
+    if (!IsActive()) {
+        G4cout << " Trigger: none (all events accepted)" << G4endl;
+        return;
+    }
+    G4cout << " Trigger: hit threshold " << G4BestUnit(fHitThreshold, "Energy") << G4endl;
+    if (fMinDetectors > 0) {
+        G4cout << "   detectors hit >= " << fMinDetectors << G4endl;
+    }
+    for (const auto& window : fWindows) {
+        G4cout << "   " << window.detector << " edep in [" << G4BestUnit(window.min, "Energy")
+               << ", " << G4BestUnit(window.max, "Energy") << ")" << G4endl;
+    }
+    for (const auto& coincidence : fCoincidences) {
+        G4cout << "   coincidence:";
+        for (const auto& detector : coincidence.detectors) G4cout << " " << detector;
+        G4cout << G4endl;
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * Fast Shower Model Implementation
+ */
+
+#include "FastShowerModel.hh"
+
+#include "G4FastHit.hh"
+#include "G4FastSimHitMaker.hh"
+#include "G4FastStep.hh"
+#include "G4FastTrack.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Gamma.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4VSolid.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Slope of the longitudinal gamma profile (per radiation length)
+const G4double kLongitudinalBeta = 0.5;
+// Relative shower-to-shower fluctuation of the depth of maximum
+const G4double kDepthFluctuation = 0.1;
+// Radial profile: fraction in the core, core and tail radii in Moliere radii
+const G4double kCoreFraction = 0.87;
+const G4double kCoreRadius = 0.2;
+const G4double kTailRadius = 1.0;
+
+}
+
+FastShowerModel::FastShowerModel(const G4String& name, G4Region* envelope, G4double threshold)
+    : G4VFastSimulationModel(name, envelope),
+      fThreshold(threshold),
+      fSpotEnergy(10.*MeV),
+      fMinSpots(20),
+      fHitMaker(new G4FastSimHitMaker())
+{}
+
+FastShowerModel::~FastShowerModel() {
+    delete fHitMaker;
+}
+
+G4bool FastShowerModel::IsApplicable(const G4ParticleDefinition& particle) {
+    return &particle == G4Electron::Definition() ||
+           &particle == G4Positron::Definition() ||
+           &particle == G4Gamma::Definition();
+}
+
+G4bool FastShowerModel::ModelTrigger(const G4FastTrack& fastTrack) {
+    return fastTrack.GetPrimaryTrack()->GetKineticEnergy() > fThreshold;
+}
+
+FastShowerModel::MaterialParameters FastShowerModel::GetParameters(const G4Material* material) const {
+    // Effective Z from electron and atom densities
+    G4double zEff = material->GetTotNbOfElectPerVolume() / material->GetTotNbOfAtomsPerVolume();
+
+    MaterialParameters params;
+    params.radLength = material->GetRadlen();
+    params.criticalEnergy = (material->GetState() == kStateGas)
+        ? 710.*MeV / (zEff + 0.92)
+        : 610.*MeV / (zEff + 1.24);
+    params.moliereRadius = 21.2052*MeV * params.radLength / params.criticalEnergy;
+    return params;
+}
+
+void FastShowerModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) {
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    G4double energy = track->GetKineticEnergy();
+
+    // The shower replaces the primary
+    fastStep.KillPrimaryTrack();
+    fastStep.ProposePrimaryTrackPathLength(0.0);
+
+    MaterialParameters params = GetParameters(fastTrack.GetEnvelopeLogicalVolume()->GetMaterial());
+
+    // Longitudinal profile: gamma distribution in t = depth/X0 with the
+    // maximum at ln(E/Ec) + C (C = -0.5 for e+-, +0.5 for photons)
+    G4double c = (track->GetDefinition() == G4Gamma::Definition()) ? 0.5 : -0.5;
+    G4double tMax = std::log(energy / params.criticalEnergy) + c;
+    tMax *= G4RandGauss::shoot(1., kDepthFluctuation);
+    if (tMax < 0.1) tMax = 0.1;
+    G4double alpha = 1. + kLongitudinalBeta * tMax;
+
+    // Shower axis in the envelope frame
+    G4ThreeVector origin = fastTrack.GetPrimaryTrackLocalPosition();
+    G4ThreeVector axis = fastTrack.GetPrimaryTrackLocalDirection();
+    G4ThreeVector u = axis.orthogonal().unit();
+    G4ThreeVector v = axis.cross(u);
+
+    const G4VSolid* envelopeSolid = fastTrack.GetEnvelopeSolid();
+    const G4AffineTransform* toGlobal = fastTrack.GetInverseAffineTransformation();
+
+    G4int nSpots = std::max(fMinSpots, G4int(energy / fSpotEnergy));
+    G4double spotEnergy = energy / nSpots;
+    G4double deposited = 0.;
+
+    for (G4int i = 0; i < nSpots; i++) {
+        G4double depth = CLHEP::RandGamma::shoot(alpha, kLongitudinalBeta) * params.radLength;
+
+        // Radial profile f(r) = 2rR^2/(r^2+R^2)^2, inverted as r = R sqrt(q/(1-q))
+        G4double radius = (G4UniformRand() < kCoreFraction ? kCoreRadius : kTailRadius)
+                          * params.moliereRadius;
+        G4double q = G4UniformRand();
+        G4double r = radius * std::sqrt(q / (1. - q));
+        G4double phi = CLHEP::twopi * G4UniformRand();
+
+        G4ThreeVector local = origin + depth * axis
+                            + r * (std::cos(phi) * u + std::sin(phi) * v);
+
+        // Spots outside the envelope are dropped; unlike full simulation,
+        // where leaking particles may deposit elsewhere, this underestimates
+        // the deposits of leaky showers
+        if (envelopeSolid->Inside(local) == kOutside) continue;
+
+        fHitMaker->make(G4FastHit(toGlobal->TransformPoint(local), spotEnergy), fastTrack);
+        deposited += spotEnergy;
+    }
+
+    // Keep the step-level energy bookkeeping consistent with full simulation
+    fastStep.ProposeTotalEnergyDeposited(deposited);
+}
@@ -0,0 +1,132 @@
+/**
+ * Log Sink Implementation
+ */
+
+#include "LogSink.hh"
+
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const char* const kLevelNames[] = {"debug", "info", "warning", "error"};
+const std::size_t kFlushSize = 16384;
+const std::chrono::milliseconds kFlushInterval(500);
+
+}
+
+LogSink::LogSink(const G4String& directory)
+    : fLevel(kInfo),
+      fRate(20.),
+      fBuckets(),
+      fBuffer(),
+      fRecordLevel(kInfo),
+      fRecordSuppressed(0),
+      fLastFlush(Clock::now()),
+      fMessenger(nullptr)
+{
+    fBuffer.reserve(kFlushSize + 256);
+
+    // Created on every thread so that commands reach the workers
+    fMessenger = new G4GenericMessenger(this, directory, "Event loop log");
+
+    fMessenger->DeclareMethod("level", &LogSink::SetLevel)
+        .SetGuidance("Lowest severity of the records written.")
+        .SetParameterName("level", false)
+        .SetCandidates("debug info warning error")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("rate", fRate)
+        .SetGuidance("Records per second per tag and thread (0 = unlimited).")
+        .SetParameterName("records", false)
+        .SetRange("records>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+LogSink::~LogSink() {
+    Flush();
+    delete fMessenger;
+}
+
+void LogSink::SetLevel(const G4String& level) {
+    for (G4int i = kDebug; i <= kError; i++) {
+        if (level == kLevelNames[i]) fLevel = Level(i);
+    }
+}
+
+G4bool LogSink::Begin(Level level, const char* tag) {
+    fRecordSuppressed = 0;
+    if (fRate > 0.) {
+        Clock::time_point now = Clock::now();
+        auto inserted = fBuckets.emplace(tag, Bucket{fRate, now, 0});
+        Bucket& bucket = inserted.first->second;
+        if (!inserted.second) {
+            G4double elapsed = std::chrono::duration<G4double>(now - bucket.last).count();
+            bucket.tokens = std::min(fRate, bucket.tokens + elapsed * fRate);
+            bucket.last = now;
+        }
+        if (bucket.tokens < 1.) {
+            bucket.suppressed += 1;
+            return false;
+        }
+        bucket.tokens -= 1.;
+        fRecordSuppressed = bucket.suppressed;
+        bucket.suppressed = 0;
+    }
+
+    fRecordLevel = level;
+    fBuffer += "LOG ";
+    fBuffer += kLevelNames[level];
+    fBuffer += ' ';
+    fBuffer += tag;
+    return true;
+}
+
+void LogSink::AddField(const char* key, G4long value) {
+    char field[96];
+    std::snprintf(field, sizeof(field), " %s=%ld", key, value);
+    fBuffer += field;
+}
+
+void LogSink::AddField(const char* key, G4double value) {
+    char field[96];
+    std::snprintf(field, sizeof(field), " %s=%.6g", key, value);
+    fBuffer += field;
+}
+
+void LogSink::AddField(const char* key, const G4String& value) {
+    fBuffer += ' ';
+    fBuffer += key;
+    fBuffer += '=';
+    // Values with blanks or quotes are quoted
+    if (value.empty() || value.find_first_of(" \t\"") != std::string::npos) {
+        fBuffer += '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') fBuffer += '\\';
+            fBuffer += (c == '\n' ? ' ' : c);
+        }
+        fBuffer += '"';
+    } else {
+        fBuffer += value;
+    }
+}
+
+void LogSink::Commit() {
+    if (fRecordSuppressed > 0) AddField("suppressed", fRecordSuppressed);
+    fBuffer += '\n';
+    if (fRecordLevel >= kWarning || fBuffer.size() >= kFlushSize ||
+        Clock::now() - fLastFlush >= kFlushInterval) {
+        Flush();
+    }
+}
+
+void LogSink::Flush() {
+    fLastFlush = Clock::now();
+    if (fBuffer.empty()) return;
+    // One write per buffer; the last newline is G4endl's
+    fBuffer.pop_back();
+    G4cout << fBuffer << G4endl;
+    fBuffer.clear();
+}
@@ -0,0 +1,210 @@
+/**
+ * Memory Watchdog Implementation
+ */
+
+#include "MemoryWatchdog.hh"
+#include "StartupMetrics.hh"
+#include "Timeline.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+G4Mutex watchdogMutex = G4MUTEX_INITIALIZER;
+
+const char* const kLevelNames[] = {"normal", "degraded", "paused", "exceeded"};
+// Degraded output is restored below this fraction of the soft limit
+const G4double kRecovery = 0.95;
+
+}
+
+std::atomic<G4int> MemoryWatchdog::fgLevel(MemoryWatchdog::kNormal);
+std::atomic<G4int> MemoryWatchdog::fgFlushGeneration(0);
+std::atomic<G4long> MemoryWatchdog::fgNofPausedEvents(0);
+G4double MemoryWatchdog::fgPeakMB = 0.;
+MemoryWatchdog::Level MemoryWatchdog::fgHighestLevel = MemoryWatchdog::kNormal;
+G4double MemoryWatchdog::fgBudgetMB = 0.;
+std::vector<MemoryWatchdog::Slot*> MemoryWatchdog::fgSlots;
+G4ThreadLocal MemoryWatchdog::Slot* MemoryWatchdog::fgSlot = nullptr;
+
+MemoryWatchdog::MemoryWatchdog()
+    : fBudget(0.),
+      fSoftLimit(0.85),
+      fPauseLimit(0.95),
+      fInterval(200),
+      fMaxPause(10.),
+      fFlushSeen(0),
+      fThread(),
+      fStopMutex(),
+      fStopCondition(),
+      fStop(false),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/memory/", "Resident memory budget");
+
+    fMessenger->DeclareProperty("budget", fBudget)
+        .SetGuidance("Resident memory budget in MB; the run is aborted and the process")
+        .SetGuidance("exits with status 75 above it (0 = no watchdog).")
+        .SetParameterName("MB", false)
+        .SetRange("MB>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("softLimit", fSoftLimit)
+        .SetGuidance("Fraction of the budget above which buffers are flushed and")
+        .SetGuidance("trajectories and event summaries are no longer written.")
+        .SetParameterName("fraction", false)
+        .SetRange("fraction>0 && fraction<=1")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("pauseLimit", fPauseLimit)
+        .SetGuidance("Fraction of the budget above which all workers but the first")
+        .SetGuidance("wait before their next event.")
+        .SetParameterName("fraction", false)
+        .SetRange("fraction>0 && fraction<=1")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("interval", fInterval)
+        .SetGuidance("Sampling interval in ms.")
+        .SetParameterName("ms", false)
+        .SetRange("ms>=10")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("maxPause", fMaxPause)
+        .SetGuidance("Longest wait of a paused worker before one event, in s.")
+        .SetParameterName("seconds", false)
+        .SetRange("seconds>=0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+MemoryWatchdog::~MemoryWatchdog() {
+    EndOfRun();
+    delete fMessenger;
+}
+
+void MemoryWatchdog::BeginOfRun() {
+    if (fBudget <= 0.) return;
+
+    if (!fgSlot) {
+        fgSlot = new Slot();
+        for (auto& bytes : fgSlot->bytes) bytes.store(0);
+        G4AutoLock lock(&watchdogMutex);
+        fgSlots.push_back(fgSlot);
+    }
+
+    // The master begins the run before its workers
+    if (!G4Threading::IsMasterThread()) return;
+    fgLevel = kNormal;
+    fgNofPausedEvents = 0;
+    fgPeakMB = 0.;
+    fgHighestLevel = kNormal;
+    fgBudgetMB = fBudget;
+    if (StartupMetrics::ResidentMB() <= 0.) {
+        G4Exception("MemoryWatchdog::BeginOfRun()", "MemoryUnknown", JustWarning,
+                    "Resident memory cannot be read on this platform; no memory budget.");
+        return;
+    }
+    fStop = false;
+    fThread = std::thread(&MemoryWatchdog::Watch, this);
+}
+
+void MemoryWatchdog::EndOfRun() {
+    if (fgSlot) {
+        for (auto& bytes : fgSlot->bytes) bytes.store(0, std::memory_order_relaxed);
+    }
+    if (!fThread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(fStopMutex);
+        fStop = true;
+    }
+    fStopCondition.notify_one();
+    fThread.join();
+
+    G4cout << "Memory: peak " << G4int(fgPeakMB) << " MB of " << G4int(fgBudgetMB)
+           << " MB budget, highest step " << kLevelNames[fgHighestLevel];
+    if (fgNofPausedEvents > 0) G4cout << ", " << fgNofPausedEvents.load() << " events paused";
+    G4cout << G4endl;
+}
+
+void MemoryWatchdog::BeginOfEvent(Timeline* timeline) {
+    // The master (sequential mode) and the first worker never wait
+    if (GetLevel() != kPaused || G4Threading::G4GetThreadId() <= 0) return;
+
+    Timeline::Scope pause(timeline, "memory pause");
+    fgNofPausedEvents += 1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<G4double>(fMaxPause);
+    while (GetLevel() == kPaused && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+void MemoryWatchdog::Watch() {
+    std::unique_lock<std::mutex> lock(fStopMutex);
+    while (!fStop) {
+        G4double residentMB = StartupMetrics::ResidentMB();
+        if (residentMB > fgPeakMB) fgPeakMB = residentMB;
+
+        Level previous = GetLevel();
+        Level level = kNormal;
+        if (previous == kExceeded || residentMB >= fBudget) level = kExceeded;
+        else if (residentMB >= fPauseLimit * fBudget) level = kPaused;
+        else if (residentMB >= fSoftLimit * fBudget) level = kDegraded;
+        else if (previous >= kDegraded && residentMB >= kRecovery * fSoftLimit * fBudget) level = kDegraded;
+
+        if (level != previous) {
+            if (level > previous && previous == kNormal) fgFlushGeneration += 1;
+            fgLevel = level;
+            if (level > fgHighestLevel) fgHighestLevel = level;
+            Report(level, residentMB);
+        }
+        if (level == kExceeded) {
+            // The event loop threads abort at their next track; nothing
+            // left to watch in this run
+            break;
+        }
+        fStopCondition.wait_for(lock, std::chrono::milliseconds(fInterval));
+    }
+}
+
+void MemoryWatchdog::Report(Level level, G4double residentMB) const {
+    std::size_t bytes[kNofComponents] = {0, 0, 0};
+    {
+        G4AutoLock lock(&watchdogMutex);
+        for (const Slot* slot : fgSlots) {
+            for (G4int i = 0; i < kNofComponents; i++) {
+                bytes[i] += slot->bytes[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Same record format as LogSink, whose buffers belong to other threads.
+    // G4cout is not safe from this thread: the line goes to stdout in one
+    // call, which stdio locks, so it cannot be torn by the event loop output
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "LOG %s memory level=%s rss_mb=%.0f budget_mb=%.0f hits_mb=%.1f output_mb=%.1f stacks_mb=%.1f\n",
+                  level == kNormal ? "info" : (level == kExceeded ? "error" : "warning"),
+                  kLevelNames[level], residentMB, fBudget,
+                  bytes[kHits] / 1048576., bytes[kOutput] / 1048576., bytes[kStacks] / 1048576.);
+    std::fputs(line, stdout);
+    std::fflush(stdout);
+}
+
+void MemoryWatchdog::ExitIfExceeded() {
+    if (!IsExceeded()) return;
+
+    G4cout << "Memory budget of " << G4int(fgBudgetMB) << " MB exceeded: run aborted, outputs written, "
+           << "exiting with status " << kExitStatus << G4endl;
+    std::cout.flush();
+    std::cerr.flush();
+    // Worker threads are still parked in the run manager; skip the static
+    // destructors that std::exit would run under them
+    std::_Exit(kExitStatus);
+}
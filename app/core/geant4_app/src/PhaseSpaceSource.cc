@@ -0,0 +1,388 @@
+/**
+ * Phase-Space Source Implementation
+ */
+
+#include "PhaseSpaceSource.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Index 0 is unused; IAEA particle codes 1..5
+const char* const kParticleNames[6] = {nullptr, "gamma", "e-", "e+", "neutron", "proton"};
+
+G4String StripExtension(const G4String& name) {
+    for (const char* ext : {".IAEAphsp", ".IAEAheader"}) {
+        std::size_t n = std::strlen(ext);
+        if (name.size() > n && name.compare(name.size() - n, n, ext) == 0) {
+            return name.substr(0, name.size() - n);
+        }
+    }
+    return name;
+}
+
+// Numbers at the start of each line of a header section
+std::vector<G4double> SectionValues(const std::string& header, const std::string& section) {
+    std::vector<G4double> values;
+    std::size_t pos = header.find("$" + section + ":");
+    if (pos == std::string::npos) return values;
+
+    std::istringstream lines(header.substr(header.find('\n', pos) + 1));
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.find('$') != std::string::npos) break;
+        std::istringstream in(line);
+        G4double value;
+        if (in >> value) values.push_back(value);
+    }
+    return values;
+}
+
+}
+
+PhaseSpaceSource::PhaseSpaceSource()
+    : fBaseName(""),
+      fRecycle(1),
+      fRotate(false),
+      fStored(),
+      fSignedW(true),
+      fConstant(),
+      fRecordLength(0),
+      fOpenName(""),
+      fData(nullptr),
+      fSize(0),
+      fNofRecords(0),
+      fPerParticle(false),
+      fFirst(0), fEnd(0),
+      fHistoryStart(0), fHistoryEnd(0),
+      fUse(0),
+      fWrapped(false),
+      fParticles(),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/source/phsp/", "IAEA phase-space source");
+
+    fMessenger->DeclareProperty("file", fBaseName)
+        .SetGuidance("IAEA phase-space file, with or without the .IAEAphsp extension.")
+        .SetGuidance("The .IAEAheader file must be next to it.")
+        .SetParameterName("file", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("recycle", fRecycle)
+        .SetGuidance("Number of events generated from each history.")
+        .SetParameterName("times", false)
+        .SetRange("times>=1")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("rotate", fRotate)
+        .SetGuidance("Rotate every use of a history by a random angle about the z axis.")
+        .SetParameterName("rotate", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+PhaseSpaceSource::~PhaseSpaceSource() {
+    Close();
+    delete fMessenger;
+}
+
+void PhaseSpaceSource::ReadHeader(const G4String& fileName) {
+    std::ifstream file(fileName);
+    if (!file) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read phase-space header " << fileName;
+        G4Exception("PhaseSpaceSource::ReadHeader()", "PhaseSpaceHeader", FatalException, msg);
+        return;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    std::string header = text.str();
+
+    std::vector<G4double> byteOrder = SectionValues(header, "BYTE_ORDER");
+    const std::uint16_t probe = 1;
+    G4bool littleEndian = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+    if (!byteOrder.empty() && (G4int(byteOrder[0]) != 1234 || !littleEndian)) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": byte order " << byteOrder[0] << " is not supported on this host";
+        G4Exception("PhaseSpaceSource::ReadHeader()", "PhaseSpaceHeader", FatalException, msg);
+        return;
+    }
+
+    // x y z u v w weight nExtraFloats nExtraLongs
+    std::vector<G4double> contents = SectionValues(header, "RECORD_CONTENTS");
+    if (contents.size() < 7) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": missing or short $RECORD_CONTENTS";
+        G4Exception("PhaseSpaceSource::ReadHeader()", "PhaseSpaceHeader", FatalException, msg);
+        return;
+    }
+    const G4int kIndex[6] = {0, 1, 2, 3, 4, 6};
+    for (G4int i = 0; i < 6; ++i) fStored[i] = contents[kIndex[i]] != 0;
+    fSignedW = contents[5] != 0;
+    G4int nExtraFloats = contents.size() > 7 ? G4int(contents[7]) : 0;
+    G4int nExtraLongs = contents.size() > 8 ? G4int(contents[8]) : 0;
+
+    // Constants follow in the order x y z u v w weight, for those not stored
+    std::vector<G4double> constants = SectionValues(header, "RECORD_CONSTANT");
+    const G4bool stored[7] = {fStored[0], fStored[1], fStored[2], fStored[3], fStored[4],
+                              fSignedW, fStored[5]};
+    std::size_t next = 0;
+    for (G4int i = 0; i < 7; ++i) {
+        fConstant[i] = (i == 6) ? 1. : 0.;
+        if (!stored[i] && next < constants.size()) fConstant[i] = constants[next++];
+    }
+
+    std::size_t length = 1 + 4;
+    for (G4bool isStored : fStored) length += isStored ? 4 : 0;
+    length += 4 * (nExtraFloats + nExtraLongs);
+
+    std::vector<G4double> recordLength = SectionValues(header, "RECORD_LENGTH");
+    fRecordLength = recordLength.empty() ? length : std::size_t(recordLength[0]);
+    if (fRecordLength < length) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": record length " << fRecordLength
+            << " is shorter than the " << length << " bytes of $RECORD_CONTENTS";
+        G4Exception("PhaseSpaceSource::ReadHeader()", "PhaseSpaceHeader", FatalException, msg);
+    }
+}
+
+void PhaseSpaceSource::Open() {
+    Close();
+
+    G4String base = StripExtension(fBaseName);
+    ReadHeader(base + ".IAEAheader");
+    G4String fileName = base + ".IAEAphsp";
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER size;
+    if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            fData = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+        fSize = std::size_t(size.QuadPart);
+    }
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd >= 0 && ::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = ::mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            // Each thread walks its range forward; let the kernel read ahead
+            ::madvise(data, std::size_t(info.st_size), MADV_SEQUENTIAL);
+            fData = static_cast<const unsigned char*>(data);
+            fSize = std::size_t(info.st_size);
+        }
+    }
+    if (fd >= 0) ::close(fd);
+#endif
+
+    if (!fData) {
+        fSize = 0;
+        G4ExceptionDescription msg;
+        msg << "Cannot map phase-space file " << fileName;
+        G4Exception("PhaseSpaceSource::Open()", "PhaseSpaceFile", FatalException, msg);
+        return;
+    }
+    fNofRecords = fSize / fRecordLength;
+    if (fNofRecords == 0) {
+        G4ExceptionDescription msg;
+        msg << fileName << " holds no complete record";
+        G4Exception("PhaseSpaceSource::Open()", "PhaseSpaceFile", FatalException, msg);
+        return;
+    }
+    if (fSize % fRecordLength != 0) {
+        G4ExceptionDescription msg;
+        msg << fileName << ": " << fSize % fRecordLength << " trailing bytes ignored";
+        G4Exception("PhaseSpaceSource::Open()", "PhaseSpaceFile", JustWarning, msg);
+    }
+
+    G4ParticleTable* table = G4ParticleTable::GetParticleTable();
+    for (G4int type = 1; type < 6; ++type) fParticles[type] = table->FindParticle(kParticleNames[type]);
+
+    // A file whose first record does not open a history carries no markers
+    fPerParticle = !IsNewHistory(0);
+    fOpenName = fBaseName;
+    SelectRange();
+}
+
+void PhaseSpaceSource::Close() {
+    if (!fData) return;
+#ifdef _WIN32
+    UnmapViewOfFile(fData);
+#else
+    ::munmap(const_cast<unsigned char*>(fData), fSize);
+#endif
+    fData = nullptr;
+    fSize = 0;
+    fNofRecords = 0;
+    fOpenName = "";
+}
+
+void PhaseSpaceSource::SelectRange() {
+    // Sequential runs read the whole file
+    G4int thread = G4Threading::G4GetThreadId();
+    G4int nThreads = G4Threading::GetNumberOfRunningWorkerThreads();
+    if (thread < 0 || nThreads < 1) {
+        thread = 0;
+        nThreads = 1;
+    }
+
+    // Split by record count, then move both ends to history starts so that
+    // a history is never shared between threads
+    fFirst = NextHistory(fNofRecords * thread / nThreads);
+    fEnd = NextHistory(fNofRecords * (thread + 1) / nThreads);
+    if (fFirst >= fEnd) {
+        // More threads than histories: this thread shares the first one
+        fFirst = 0;
+        fEnd = NextHistory(1);
+        G4ExceptionDescription msg;
+        msg << "Thread " << thread << " has no history of its own in " << fOpenName
+            << "; it reuses the first one";
+        G4Exception("PhaseSpaceSource::SelectRange()", "PhaseSpaceRange", JustWarning, msg);
+    }
+    fHistoryStart = fHistoryEnd = fFirst;
+    fUse = fRecycle;
+    fWrapped = false;
+
+    G4cout << "Phase space " << fOpenName << ": " << fNofRecords << " records of "
+           << fRecordLength << " bytes, thread " << thread << " reads ["
+           << fFirst << ", " << fEnd << ")" << G4endl;
+}
+
+G4bool PhaseSpaceSource::IsNewHistory(std::size_t index) const {
+    if (fPerParticle) return true;
+    float energy;
+    std::memcpy(&energy, fData + index * fRecordLength + 1, sizeof(energy));
+    return energy < 0;
+}
+
+std::size_t PhaseSpaceSource::NextHistory(std::size_t index) const {
+    while (index < fNofRecords && !IsNewHistory(index)) ++index;
+    return index;
+}
+
+PhaseSpaceSource::Particle PhaseSpaceSource::Decode(std::size_t index) const {
+    const unsigned char* record = fData + index * fRecordLength;
+    Particle particle;
+
+    G4int type = static_cast<signed char>(record[0]);
+    particle.type = std::abs(type);
+
+    std::size_t offset = 1;
+    auto next = [&]() {
+        float value;
+        std::memcpy(&value, record + offset, sizeof(value));
+        offset += sizeof(value);
+        return G4double(value);
+    };
+
+    G4double energy = next();
+    particle.newHistory = energy < 0;
+    particle.energy = std::abs(energy)*MeV;
+
+    G4double values[6];
+    for (G4int i = 0; i < 6; ++i) {
+        G4int constant = (i == 5) ? 6 : i;
+        values[i] = fStored[i] ? next() : fConstant[constant];
+    }
+    for (G4int i = 0; i < 3; ++i) particle.position[i] = values[i]*cm;
+
+    G4double u = values[3], v = values[4];
+    G4double w = fConstant[5];
+    if (fSignedW) {
+        w = std::sqrt(std::max(0., 1. - u*u - v*v));
+        if (type < 0) w = -w;
+    }
+    particle.direction[0] = u;
+    particle.direction[1] = v;
+    particle.direction[2] = w;
+    particle.weight = values[5];
+    return particle;
+}
+
+void PhaseSpaceSource::GeneratePrimaries(G4Event* event) {
+    if (fBaseName.empty()) {
+        G4Exception("PhaseSpaceSource::GeneratePrimaries()", "PhaseSpaceFile", FatalException,
+                    "No phase-space file set; use /geant4api/source/phsp/file");
+        return;
+    }
+    if (fOpenName != fBaseName) Open();
+
+    // Move to the next history once the current one is used up
+    if (fUse >= fRecycle) {
+        fHistoryStart = fHistoryEnd;
+        if (fHistoryStart >= fEnd) {
+            fHistoryStart = fFirst;
+            if (!fWrapped) {
+                G4ExceptionDescription msg;
+                msg << "Thread " << G4Threading::G4GetThreadId() << " used all "
+                    << fEnd - fFirst << " records of its range; starting over";
+                G4Exception("PhaseSpaceSource::GeneratePrimaries()", "PhaseSpaceWrap",
+                            JustWarning, msg);
+                fWrapped = true;
+            }
+        }
+        fHistoryEnd = std::min(NextHistory(fHistoryStart + 1), fEnd);
+        fUse = 0;
+    }
+    ++fUse;
+
+    G4double phi = fRotate ? twopi*G4UniformRand() : 0.;
+    G4double cosPhi = std::cos(phi), sinPhi = std::sin(phi);
+
+    for (std::size_t index = fHistoryStart; index < fHistoryEnd; ++index) {
+        Particle particle = Decode(index);
+        if (particle.type < 1 || particle.type > 5 || !fParticles[particle.type]) {
+            G4ExceptionDescription msg;
+            msg << "Record " << index << " has unknown particle type " << particle.type << "; skipped";
+            G4Exception("PhaseSpaceSource::GeneratePrimaries()", "PhaseSpaceRecord", JustWarning, msg);
+            continue;
+        }
+
+        const G4double* p = particle.position;
+        const G4double* d = particle.direction;
+        G4ThreeVector position(cosPhi*p[0] - sinPhi*p[1], sinPhi*p[0] + cosPhi*p[1], p[2]);
+        G4ThreeVector direction(cosPhi*d[0] - sinPhi*d[1], sinPhi*d[0] + cosPhi*d[1], d[2]);
+
+        G4PrimaryParticle* primary = new G4PrimaryParticle(fParticles[particle.type]);
+        primary->SetKineticEnergy(particle.energy);
+        primary->SetMomentumDirection(direction.unit());
+        primary->SetWeight(particle.weight);
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(position, 0.);
+        vertex->SetPrimary(primary);
+        event->AddPrimaryVertex(vertex);
+    }
+}
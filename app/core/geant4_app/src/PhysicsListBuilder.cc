@@ -0,0 +1,170 @@
+/**
+ * Physics List Builder Implementation
+ */
+
+#include "PhysicsListBuilder.hh"
+
+#include "G4PhysListFactory.hh"
+#include "G4VModularPhysicsList.hh"
+
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4EmStandardPhysics_option2.hh"
+#include "G4EmStandardPhysics_option3.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4EmLivermorePhysics.hh"
+#include "G4EmPenelopePhysics.hh"
+
+#include "G4StepLimiterPhysics.hh"
+#include "G4RadioactiveDecayPhysics.hh"
+#include "G4OpticalPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+struct PhysicsPreset {
+    const char* name;
+    const char* baseList;
+    const char* emOption;
+    const char* builders;
+    const char* description;
+};
+
+// The step limiter is part of every preset so that region and volume
+// G4UserLimits keep working whatever the trade-off
+const PhysicsPreset kPresets[] = {
+    {"fast",      "FTFP_BERT", "standard",  "steplimiter",
+     "throughput: opt0 EM, step limiter only"},
+    {"balanced",  "FTFP_BERT", "option3",   "steplimiter",
+     "opt3 EM, finer multiple scattering"},
+    {"accurate",  "FTFP_BERT", "option4",   "steplimiter",
+     "most accurate standard EM"},
+    {"medical",   "QGSP_BIC",  "option4",   "steplimiter,radioactive",
+     "hadron therapy and dosimetry"},
+    {"lowenergy", "QGSP_BIC",  "livermore", "steplimiter,radioactive",
+     "low-energy photons and electrons (Livermore)"},
+    {"penelope",  "QGSP_BIC",  "penelope",  "steplimiter,radioactive",
+     "low-energy photons and electrons (Penelope)"},
+    {"shielding", "Shielding", "standard",  "steplimiter",
+     "deep penetration and activation"},
+};
+
+}
+
+PhysicsListBuilder::PhysicsListBuilder()
+    : fBaseList("FTFP_BERT"),
+      fEmOption(""),
+      fBuilders({"steplimiter"})
+{}
+
+PhysicsListBuilder::~PhysicsListBuilder() {}
+
+G4bool PhysicsListBuilder::ApplyPreset(const G4String& name) {
+    for (const auto& preset : kPresets) {
+        if (name != preset.name) continue;
+        fBaseList = preset.baseList;
+        fEmOption = preset.emOption;
+        fBuilders.clear();
+        AddBuilders(preset.builders);
+        return true;
+    }
+    return false;
+}
+
+void PhysicsListBuilder::AddBuilders(const G4String& names) {
+    std::size_t start = 0;
+    while (start <= names.size()) {
+        std::size_t end = names.find(',', start);
+        if (end == std::string::npos) end = names.size();
+        G4String name = names.substr(start, end - start);
+        // Shower and Woodcock models share one fast simulation process
+        if (name == "fastshower" || name == "woodcock") name = "fastsim";
+        if (!name.empty() && std::find(fBuilders.begin(), fBuilders.end(), name) == fBuilders.end()) {
+            fBuilders.push_back(name);
+        }
+        start = end + 1;
+    }
+}
+
+G4VModularPhysicsList* PhysicsListBuilder::Build() const {
+    G4PhysListFactory factory;
+    factory.SetVerbose(0);
+    if (!factory.IsReferencePhysList(fBaseList)) {
+        G4ExceptionDescription msg;
+        msg << "Unknown reference physics list: " << fBaseList;
+        G4Exception("PhysicsListBuilder::Build()", "UnknownPhysicsList",
+                    FatalErrorInArgument, msg);
+        return nullptr;
+    }
+    G4VModularPhysicsList* physicsList = factory.GetReferencePhysList(fBaseList);
+
+    // Swap the EM constructor of the reference list
+    if (!fEmOption.empty()) {
+        physicsList->ReplacePhysics(CreateEmPhysics());
+    }
+
+    for (const auto& name : fBuilders) {
+        physicsList->RegisterPhysics(CreateBuilder(name));
+    }
+
+    return physicsList;
+}
+
+G4VPhysicsConstructor* PhysicsListBuilder::CreateEmPhysics() const {
+    if (fEmOption == "standard" || fEmOption == "opt0") return new G4EmStandardPhysics();
+    if (fEmOption == "option1" || fEmOption == "opt1") return new G4EmStandardPhysics_option1();
+    if (fEmOption == "option2" || fEmOption == "opt2") return new G4EmStandardPhysics_option2();
+    if (fEmOption == "option3" || fEmOption == "opt3") return new G4EmStandardPhysics_option3();
+    if (fEmOption == "option4" || fEmOption == "opt4") return new G4EmStandardPhysics_option4();
+    if (fEmOption == "livermore") return new G4EmLivermorePhysics();
+    if (fEmOption == "penelope") return new G4EmPenelopePhysics();
+
+    G4ExceptionDescription msg;
+    msg << "Unknown EM option: " << fEmOption;
+    G4Exception("PhysicsListBuilder::CreateEmPhysics()", "UnknownEmOption",
+                FatalErrorInArgument, msg);
+    return nullptr;
+}
+
+G4VPhysicsConstructor* PhysicsListBuilder::CreateBuilder(const G4String& name) const {
+    if (name == "steplimiter") return new G4StepLimiterPhysics();
+    if (name == "radioactive") return new G4RadioactiveDecayPhysics();
+    if (name == "optical") return new G4OpticalPhysics();
+    if (name == "fastsim") {
+        // Used by FastShowerModel and WoodcockModel envelopes
+        auto* fastSimPhysics = new G4FastSimulationPhysics();
+        fastSimPhysics->ActivateFastSimulation("e-");
+        fastSimPhysics->ActivateFastSimulation("e+");
+        fastSimPhysics->ActivateFastSimulation("gamma");
+        return fastSimPhysics;
+    }
+
+    G4ExceptionDescription msg;
+    msg << "Unknown physics builder: " << name
+        << " (known: steplimiter, radioactive, optical, fastshower, woodcock)";
+    G4Exception("PhysicsListBuilder::CreateBuilder()", "UnknownPhysicsBuilder",
+                FatalErrorInArgument, msg);
+    return nullptr;
+}
+
+void PhysicsListBuilder::Print() const {
+    G4cout << "Physics: " << fBaseList
+           << ", EM " << (fEmOption.empty() ? G4String("(list default)") : fEmOption);
+    if (!fBuilders.empty()) {
+        G4cout << ", builders:";
+        for (const auto& name : fBuilders) G4cout << " " << name;
+    }
+    G4cout << G4endl;
+}
+
+void PhysicsListBuilder::PrintPresets() {
+    G4cerr << "Physics presets:" << G4endl;
+    for (const auto& preset : kPresets) {
+        G4cerr << "  " << std::setw(10) << std::left << preset.name
+               << preset.baseList << " + " << preset.emOption
+               << " [" << preset.builders << "]  " << preset.description << G4endl;
+    }
+}
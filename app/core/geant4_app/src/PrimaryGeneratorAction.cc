@@ -3,25 +3,56 @@
  */
 
 #include "PrimaryGeneratorAction.hh"
+#include "EventRecorder.hh"
+#include "PhaseSpaceSource.hh"
+#include "BeamSource.hh"
 
 #include "G4GeneralParticleSource.hh"
+#include "G4GenericMessenger.hh"
 #include "G4Event.hh"
 
-PrimaryGeneratorAction::PrimaryGeneratorAction()
+PrimaryGeneratorAction::PrimaryGeneratorAction(EventRecorder* recorder)
     : G4VUserPrimaryGeneratorAction(),
-      fGPS(nullptr)
+      fGPS(nullptr),
+      fPhaseSpace(nullptr),
+      fBeam(nullptr),
+      fRecorder(recorder),
+      fSourceType("gps"),
+      fMessenger(nullptr)
 {
     fGPS = new G4GeneralParticleSource();
+    fPhaseSpace = new PhaseSpaceSource();
+    fBeam = new BeamSource();
     
     // Default configuration (will be overridden by macro)
     // GPS is fully controlled via macro commands like /gps/particle, /gps/energy, etc.
+    
+    fMessenger = new G4GenericMessenger(this, "/geant4api/source/", "Primary source selection");
+    
+    fMessenger->DeclareProperty("type", fSourceType)
+        .SetGuidance("Primary source: gps (/gps/ commands), phsp (/geant4api/source/phsp/)")
+        .SetGuidance("or beam (/geant4api/source/beam/).")
+        .SetParameterName("type", false)
+        .SetCandidates("gps phsp beam")
+        .SetStates(G4State_PreInit, G4State_Idle);
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction() {
+    delete fMessenger;
+    delete fBeam;
+    delete fPhaseSpace;
     delete fGPS;
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* event) {
-    fGPS->GeneratePrimaryVertex(event);
+    // Each event starts from its own recorded seeds, so it can be replayed alone
+    fRecorder->SeedEvent(event->GetEventID());
+    if (fSourceType == "beam") {
+        fBeam->GeneratePrimaries(event);
+    } else if (fSourceType == "phsp") {
+        fPhaseSpace->GeneratePrimaries(event);
+    } else {
+        fGPS->GeneratePrimaryVertex(event);
+    }
+    fRecorder->RecordEvent(event);
 }
-
@@ -4,22 +4,41 @@
 
 #include "RunAction.hh"
 #include "Analysis.hh"
+#include "StartupMetrics.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
+#include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
 #include "G4AccumulableManager.hh"
 
+namespace {
+
+// Trigger detectors are sensitive volumes, whose hits collections are
+// named after them (DetectorConstruction)
+G4int CollectionIndex(const G4String& detector) {
+    return G4SDManager::GetSDMpointer()->GetCollectionID(detector + "_HC");
+}
+
+}
+
 RunAction::RunAction(const G4String& outputDir)
     : G4UserRunAction(),
       fOutputDir(outputDir),
       fEdep(0.),
-      fEdep2(0.)
+      fEdep2(0.),
+      fNofAccepted(0),
+      fNofHits(0),
+      fTrigger("/geant4api/trigger/", "MeV", CollectionIndex),
+      fGuard(&fLog)
 {
     // Register accumulables
     G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
     accumulableManager->RegisterAccumulable(fEdep);
     accumulableManager->RegisterAccumulable(fEdep2);
+    accumulableManager->RegisterAccumulable(fNofAccepted);
+    accumulableManager->RegisterAccumulable(fNofHits);
 }
 
 RunAction::~RunAction() {}
@@ -29,22 +48,51 @@ void RunAction::BeginOfRunAction(const G4Run* run) {
     G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
     accumulableManager->Reset();
     
-    // Initialize analysis
-    Analysis* analysis = Analysis::Instance();
-    analysis->SetOutputDirectory(fOutputDir);
-    analysis->Book();
+    fRecorder.BeginOfRun(fOutputDir, run->GetRunID());
+    fTrajectories.BeginOfRun(fOutputDir, run->GetRunID());
+    fProfiler.BeginOfRun();
+    fTimeline.BeginOfRun();
+    fMemory.BeginOfRun();
+    fGuard.BeginOfRun();
+    fDetectorStats.BeginOfRun();
+    
+    // A replayed event only writes its trajectories
+    if (!EventRecorder::IsReplay()) {
+        Analysis* analysis = Analysis::Instance();
+        analysis->SetOutputDirectory(fOutputDir);
+        analysis->Book();
+    }
+    
+    StartupMetrics::BeginOfRun();
+    if (IsMaster()) fTimer.Start();
     
     G4cout << "### Run " << run->GetRunID() << " starts." << G4endl;
     G4cout << "    Output directory: " << fOutputDir << G4endl;
 }
 
 void RunAction::EndOfRunAction(const G4Run* run) {
+    fLog.Flush();
+    fMemory.EndOfRun();
+    fRecorder.EndOfRun();
+    fTrajectories.EndOfRun();
+    fProfiler.EndOfRun(fOutputDir, run->GetRunID());
+    fGuard.EndOfRun();
+    
+    // Runs without output still write their timeline; the others end it
+    // after the merge and save spans below
     G4int nofEvents = run->GetNumberOfEvent();
-    if (nofEvents == 0) return;
+    if (EventRecorder::IsReplay() || nofEvents == 0) {
+        fTimeline.EndOfRun(fOutputDir, run->GetRunID());
+        if (IsMaster() && !EventRecorder::IsReplay()) MemoryWatchdog::ExitIfExceeded();
+        return;
+    }
     
     // Merge accumulables
     G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
-    accumulableManager->Merge();
+    {
+        Timeline::Scope merge(&fTimeline, "merge");
+        accumulableManager->Merge();
+    }
     
     // Calculate statistics
     G4double edep = fEdep;
@@ -55,17 +103,46 @@ void RunAction::EndOfRunAction(const G4Run* run) {
     
     // Print results
     if (IsMaster()) {
+        fTimer.Stop();
+        G4double realTime = fTimer.GetRealElapsed();
+        
         G4cout << G4endl
                << "--------------------End of Run------------------------------" << G4endl
                << " Total energy deposited: " << G4BestUnit(edep, "Energy") << G4endl
                << " Mean energy per event:  " << G4BestUnit(edep/nofEvents, "Energy")
-               << " +/- " << G4BestUnit(rms/nofEvents, "Energy") << G4endl
+               << " +/- " << G4BestUnit(rms/nofEvents, "Energy") << G4endl;
+        if (fTrigger.IsActive()) {
+            fTrigger.Print();
+            G4int accepted = fNofAccepted;
+            G4cout << " Accepted events: " << accepted << " of " << nofEvents
+                   << " (" << 100.*accepted/nofEvents << " %)" << G4endl;
+        }
+        G4cout << " Event loop time: " << realTime << " s";
+        if (realTime > 0.) {
+            G4cout << " (" << nofEvents/realTime << " events/s)";
+        }
+        G4cout << G4endl;
+        G4int nofHits = fNofHits;
+        G4cout << " Hits: " << nofHits;
+        if (realTime > 0.) {
+            G4cout << " (" << nofHits/realTime << " hits/s)";
+        }
+        G4cout << G4endl
                << "------------------------------------------------------------" << G4endl;
+        StartupMetrics::EndOfRun(run->GetRunID(), nofEvents, realTime);
+    }
+    fDetectorStats.EndOfRun(fOutputDir, run->GetRunID());
+    
+    // Save analysis output (workers merge their histograms into the master's)
+    {
+        Timeline::Scope save(&fTimeline, "save");
+        Analysis* analysis = Analysis::Instance();
+        analysis->Save();
     }
+    fTimeline.EndOfRun(fOutputDir, run->GetRunID());
     
-    // Save analysis output
-    Analysis* analysis = Analysis::Instance();
-    analysis->Save();
+    // Everything of an aborted run is written; leave before the next one
+    if (IsMaster()) MemoryWatchdog::ExitIfExceeded();
 }
 
 void RunAction::AddEdep(G4double edep) {
@@ -11,6 +11,10 @@
 #include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4RunManager.hh"
+#include "G4Event.hh"
+#include "G4FastHit.hh"
+#include "G4FastTrack.hh"
+#include "G4VProcess.hh"
 
 G4ThreadLocal G4Allocator<DetectorHit>* DetectorHitAllocator = nullptr;
 
@@ -22,7 +26,8 @@ DetectorHit::DetectorHit()
       fPosition(0,0,0), fMomentum(0,0,0),
       fKineticEnergy(0), fEnergyDeposit(0),
       fGlobalTime(0), fLocalTime(0),
-      fProcessName("")
+      fProcessName(""),
+      fWeight(1.)
 {}
 
 DetectorHit::DetectorHit(const DetectorHit& right) : G4VHit() {
@@ -38,6 +43,7 @@ DetectorHit::DetectorHit(const DetectorHit& right) : G4VHit() {
     fGlobalTime = right.fGlobalTime;
     fLocalTime = right.fLocalTime;
     fProcessName = right.fProcessName;
+    fWeight = right.fWeight;
 }
 
 DetectorHit::~DetectorHit() {}
@@ -55,6 +61,7 @@ const DetectorHit& DetectorHit::operator=(const DetectorHit& right) {
     fGlobalTime = right.fGlobalTime;
     fLocalTime = right.fLocalTime;
     fProcessName = right.fProcessName;
+    fWeight = right.fWeight;
     return *this;
 }
 
@@ -77,7 +84,8 @@ void DetectorHit::Print() {
 SensitiveDetector::SensitiveDetector(const G4String& name, const G4String& hcName)
     : G4VSensitiveDetector(name),
       fHitsCollection(nullptr),
-      fHCID(-1)
+      fHCID(-1),
+      fEventID(0)
 {
     collectionName.insert(hcName);
 }
@@ -91,6 +99,12 @@ void SensitiveDetector::Initialize(G4HCofThisEvent* hce) {
         fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
     }
     hce->AddHitsCollection(fHCID, fHitsCollection);
+    
+    // Looked up once per event rather than per hit; there is no run
+    // manager when the detector is driven directly (bench/hotpath_bench)
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    const G4Event* event = runManager ? runManager->GetCurrentEvent() : nullptr;
+    fEventID = event ? event->GetEventID() : 0;
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
@@ -99,12 +113,16 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
     // Skip if no energy deposit (optional: can record all steps)
     if (edep <= 0) return false;
     
+    // Parameterised showers report their deposits as fast hits instead
+    const G4VProcess* process = step->GetPostStepPoint()->GetProcessDefinedStep();
+    if (process && process->GetProcessType() == fParameterisation) return false;
+    
     G4Track* track = step->GetTrack();
     G4StepPoint* preStep = step->GetPreStepPoint();
     
     DetectorHit* hit = new DetectorHit();
     
-    hit->SetEventID(G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID());
+    hit->SetEventID(fEventID);
     hit->SetTrackID(track->GetTrackID());
     hit->SetParentID(track->GetParentID());
     hit->SetParticleName(track->GetParticleDefinition()->GetParticleName());
@@ -115,6 +133,7 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
     hit->SetEnergyDeposit(edep);
     hit->SetGlobalTime(preStep->GetGlobalTime());
     hit->SetLocalTime(preStep->GetLocalTime());
+    hit->SetWeight(preStep->GetWeight());
     
     if (step->GetPostStepPoint()->GetProcessDefinedStep()) {
         hit->SetProcessName(step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName());
@@ -125,6 +144,34 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
     return true;
 }
 
+G4bool SensitiveDetector::ProcessHits(const G4FastHit* fastHit, const G4FastTrack* fastTrack,
+                                      G4TouchableHistory*) {
+    G4double edep = fastHit->GetEnergy();
+    if (edep <= 0) return false;
+    
+    const G4Track* track = fastTrack->GetPrimaryTrack();
+    
+    DetectorHit* hit = new DetectorHit();
+    
+    hit->SetEventID(fEventID);
+    hit->SetTrackID(track->GetTrackID());
+    hit->SetParentID(track->GetParentID());
+    hit->SetParticleName(track->GetParticleDefinition()->GetParticleName());
+    hit->SetParticlePDG(track->GetParticleDefinition()->GetPDGEncoding());
+    hit->SetPosition(fastHit->GetPosition());
+    hit->SetMomentum(track->GetMomentum());
+    hit->SetKineticEnergy(track->GetKineticEnergy());
+    hit->SetEnergyDeposit(edep);
+    hit->SetGlobalTime(track->GetGlobalTime());
+    hit->SetLocalTime(track->GetLocalTime());
+    hit->SetProcessName("FastShower");
+    hit->SetWeight(track->GetWeight());
+    
+    fHitsCollection->insert(hit);
+    
+    return true;
+}
+
 void SensitiveDetector::EndOfEvent(G4HCofThisEvent*) {
     // Can print summary here
     if (verboseLevel > 0) {
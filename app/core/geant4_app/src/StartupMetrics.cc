@@ -0,0 +1,244 @@
+/**
+ * Startup Metrics Implementation
+ */
+
+#include "StartupMetrics.hh"
+
+#include "G4VStateDependent.hh"
+#include "G4StateManager.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+#include "G4Version.hh"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+G4Mutex metricsMutex = G4MUTEX_INITIALIZER;
+
+// Turns the master's state changes into phase marks
+class StateObserver : public G4VStateDependent {
+public:
+    StateObserver() : G4VStateDependent(), fState(G4State_PreInit), fInitialized(false) {}
+
+    G4bool Notify(G4ApplicationState requestedState) override {
+        G4ApplicationState previous = fState;
+        fState = requestedState;
+        if (requestedState == G4State_Init && previous == G4State_PreInit) {
+            StartupMetrics::Mark("macro commands");
+        } else if (requestedState == G4State_Init && previous == G4State_Idle) {
+            StartupMetrics::Mark("macro commands");
+        } else if (requestedState == G4State_Idle && previous == G4State_Init) {
+            StartupMetrics::Mark(fInitialized ? "physics tables and geometry closing" : "physics construction");
+            fInitialized = true;
+        } else if (requestedState == G4State_Idle && previous == G4State_GeomClosed) {
+            // End of the BeamOn(0) with which /run/initialize creates and
+            // initialises the MT and tasking workers; later runs are ignored
+            StartupMetrics::Mark("worker initialisation");
+        }
+        return true;
+    }
+
+private:
+    G4ApplicationState fState;
+    G4bool fInitialized;
+};
+
+G4double Seconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<G4double>(duration).count();
+}
+
+G4String JsonString(const G4String& value) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << G4int(c) << std::dec;
+        else out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+}
+
+std::vector<G4String> StartupMetrics::fgCommandLine;
+G4String StartupMetrics::fgOutputDir = ".";
+G4String StartupMetrics::fgStartDate = "";
+StartupMetrics::Clock::time_point StartupMetrics::fgStart;
+StartupMetrics::Clock::time_point StartupMetrics::fgLast;
+G4double StartupMetrics::fgLastResidentMB = 0.;
+G4bool StartupMetrics::fgStarted = false;
+G4bool StartupMetrics::fgDone = false;
+std::vector<StartupMetrics::Phase> StartupMetrics::fgPhases;
+G4String StartupMetrics::fgStartupJson = "";
+StartupMetrics::Clock::time_point StartupMetrics::fgRunBegin;
+StartupMetrics::Clock::time_point StartupMetrics::fgLastWorker;
+G4double StartupMetrics::fgLastWorkerResidentMB = 0.;
+G4int StartupMetrics::fgNofWorkers = 0;
+std::vector<StartupMetrics::RunRecord> StartupMetrics::fgRuns;
+
+void StartupMetrics::Start(int argc, char** argv, const G4String& outputDir) {
+    fgStart = fgLast = Clock::now();
+    fgLastResidentMB = ResidentMB();
+    fgStarted = true;
+    fgOutputDir = outputDir;
+    fgCommandLine.assign(argv, argv + argc);
+
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    fgStartDate = date;
+
+    // Registers itself; the state manager deletes it
+    new StateObserver();
+}
+
+void StartupMetrics::Mark(const G4String& phase) {
+    if (!fgStarted || fgDone || !G4Threading::IsMasterThread()) return;
+    Clock::time_point now = Clock::now();
+    G4double resident = ResidentMB();
+    AddPhase(phase, Seconds(now - fgLast), resident - fgLastResidentMB);
+    fgLast = now;
+    fgLastResidentMB = resident;
+}
+
+void StartupMetrics::AddPhase(const G4String& name, G4double seconds, G4double residentMB) {
+    // Repeated phases (macro commands between runs) add up in first-seen order
+    for (Phase& phase : fgPhases) {
+        if (phase.name == name) {
+            phase.seconds += seconds;
+            phase.residentMB += residentMB;
+            return;
+        }
+    }
+    fgPhases.push_back({name, seconds, residentMB});
+}
+
+void StartupMetrics::BeginOfRun() {
+    if (!fgStarted) return;
+    if (G4Threading::IsMasterThread()) {
+        if (fgDone) return;
+        Mark("run setup");
+        fgDone = true;
+        fgRunBegin = fgLastWorker = fgLast;
+        fgLastWorkerResidentMB = fgLastResidentMB;
+        return;
+    }
+
+    // Workers of the first run only; the master records a run at its end
+    G4AutoLock lock(&metricsMutex);
+    if (!fgRuns.empty()) return;
+    fgNofWorkers += 1;
+    Clock::time_point now = Clock::now();
+    if (now > fgLastWorker) {
+        fgLastWorker = now;
+        fgLastWorkerResidentMB = ResidentMB();
+    }
+}
+
+void StartupMetrics::EndOfRun(G4int runID, G4int nofEvents, G4double loopTime) {
+    if (!fgStarted || !G4Threading::IsMasterThread()) return;
+
+    G4AutoLock lock(&metricsMutex);
+    if (fgRuns.empty()) {
+        if (fgNofWorkers > 0) {
+            AddPhase("worker run start", Seconds(fgLastWorker - fgRunBegin),
+                     fgLastWorkerResidentMB - fgLastResidentMB);
+        }
+        fgStartupJson = StartupJson();
+        G4cout << "METRICS " << fgStartupJson << G4endl;
+    }
+    fgRuns.push_back({runID, nofEvents, loopTime});
+    WriteManifest();
+}
+
+G4String StartupMetrics::StartupJson() {
+    G4double total = 0.;
+    std::ostringstream out;
+    out << std::setprecision(6) << "{\"record\": \"startup\", \"phases\": [";
+    for (std::size_t i = 0; i < fgPhases.size(); i++) {
+        const Phase& phase = fgPhases[i];
+        total += phase.seconds;
+        out << (i ? ", " : "") << "{\"name\": " << JsonString(phase.name)
+            << ", \"wall_s\": " << phase.seconds
+            << ", \"rss_delta_mb\": " << phase.residentMB << "}";
+    }
+    out << "], \"startup_s\": " << total
+        << ", \"rss_mb\": " << fgLastWorkerResidentMB
+        << ", \"workers\": " << fgNofWorkers << "}";
+    return out.str();
+}
+
+void StartupMetrics::WriteManifest() {
+    G4String fileName = fgOutputDir + "/run_manifest.json";
+    std::ofstream out(fileName);
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName;
+        G4Exception("StartupMetrics::WriteManifest()", "ManifestFile", JustWarning, msg);
+        return;
+    }
+
+    out << std::setprecision(6)
+        << "{\n  \"schema\": 1"
+        << ",\n  \"geant4\": " << JsonString(G4Version)
+        << ",\n  \"started\": " << JsonString(fgStartDate)
+        << ",\n  \"command\": [";
+    for (std::size_t i = 0; i < fgCommandLine.size(); i++) {
+        out << (i ? ", " : "") << JsonString(fgCommandLine[i]);
+    }
+    out << "],\n  \"output\": " << JsonString(fgOutputDir)
+        << ",\n  \"startup\": " << fgStartupJson
+        << ",\n  \"runs\": [";
+    for (std::size_t i = 0; i < fgRuns.size(); i++) {
+        const RunRecord& run = fgRuns[i];
+        out << (i ? ",\n" : "\n") << "    {\"run\": " << run.runID
+            << ", \"events\": " << run.nofEvents
+            << ", \"event_loop_s\": " << run.loopTime << "}";
+    }
+    out << "\n  ],\n  \"wall_s\": " << Seconds(Clock::now() - fgStart)
+        << ",\n  \"peak_rss_mb\": " << PeakResidentMB() << "\n}\n";
+}
+
+G4double StartupMetrics::ResidentMB() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0.;
+    return G4double(resident) * sysconf(_SC_PAGESIZE) / 1048576.;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) return 0.;
+    return G4double(info.resident_size) / 1048576.;
+#else
+    return 0.;
+#endif
+}
+
+G4double StartupMetrics::PeakResidentMB() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.;
+#if defined(__APPLE__)
+    return G4double(usage.ru_maxrss) / 1048576.;
+#else
+    return G4double(usage.ru_maxrss) / 1024.;
+#endif
+#else
+    return 0.;
+#endif
+}
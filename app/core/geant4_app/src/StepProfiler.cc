@@ -0,0 +1,239 @@
+/**
+ * Step Profiler Implementation
+ */
+
+#include "StepProfiler.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+G4Mutex profileMutex = G4MUTEX_INITIALIZER;
+
+struct Totals {
+    G4long steps = 0;
+    G4double seconds = 0.;
+};
+
+// (volume, particle, process) names, merged over the threads of a run
+std::map<std::tuple<G4String, G4String, G4String>, Totals> mergedTable;
+G4int mergedThreads = 0;
+// Sum of the threads' run times, which the step times are a share of
+G4double mergedRunSeconds = 0.;
+
+template <typename K>
+std::vector<std::pair<K, Totals>> Ranked(const std::map<K, Totals>& table) {
+    std::vector<std::pair<K, Totals>> ranked(table.begin(), table.end());
+    std::sort(ranked.begin(), ranked.end(), [](const std::pair<K, Totals>& a, const std::pair<K, Totals>& b) {
+        return a.second.seconds > b.second.seconds;
+    });
+    return ranked;
+}
+
+void PrintLine(const G4String& name, const Totals& totals, G4double total) {
+    // Formatted apart so that G4cout keeps its precision
+    std::ostringstream line;
+    line << "  " << std::left << std::setw(48) << name << std::right
+         << std::setw(12) << totals.steps
+         << std::setw(12) << std::setprecision(4) << totals.seconds
+         << std::setw(8) << std::fixed << std::setprecision(1)
+         << (total > 0. ? 100. * totals.seconds / total : 0.)
+         << std::setw(10) << (totals.steps > 0 ? 1e9 * totals.seconds / totals.steps : 0.);
+    G4cout << line.str() << G4endl;
+}
+
+template <typename K>
+void PrintRanking(const char* title, const std::map<K, Totals>& table, G4double total, G4int top,
+                  G4String (*name)(const K&)) {
+    G4cout << " " << title << G4endl
+           << "  " << std::left << std::setw(48) << "" << std::right
+           << std::setw(12) << "steps" << std::setw(12) << "time [s]"
+           << std::setw(8) << "%" << std::setw(10) << "ns/step" << G4endl;
+    G4int n = 0;
+    for (const auto& entry : Ranked(table)) {
+        if (top > 0 && n++ == top) break;
+        PrintLine(name(entry.first), entry.second, total);
+    }
+}
+
+G4String TupleName(const std::tuple<G4String, G4String, G4String>& key) {
+    return std::get<0>(key) + " / " + std::get<1>(key) + " / " + std::get<2>(key);
+}
+
+G4String PlainName(const G4String& key) {
+    return key;
+}
+
+G4String JsonString(const G4String& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+}
+
+StepProfiler::StepProfiler()
+    : fEnabled(false),
+      fTop(20),
+      fTable(),
+      fLastKey{nullptr, nullptr, nullptr},
+      fLastEntry(nullptr),
+      fLast(0),
+      fStartTicks(0),
+      fStartTime(),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/profile/", "Per-volume stepping profiler");
+
+    fMessenger->DeclareProperty("enable", fEnabled)
+        .SetGuidance("Attribute step time to (volume, particle, process) and report it per run.")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("top", fTop)
+        .SetGuidance("Number of entries printed per ranking (0 = all); the JSON file has all.")
+        .SetParameterName("entries", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+StepProfiler::~StepProfiler() {
+    delete fMessenger;
+}
+
+void StepProfiler::BeginOfRun() {
+    fTable.clear();
+    fLastKey = {nullptr, nullptr, nullptr};
+    fLastEntry = nullptr;
+    if (!fEnabled) return;
+
+    // The master starts the run before the workers
+    if (G4Threading::IsMasterThread()) {
+        G4AutoLock lock(&profileMutex);
+        mergedTable.clear();
+        mergedThreads = 0;
+        mergedRunSeconds = 0.;
+    }
+    fStartTime = std::chrono::steady_clock::now();
+    fStartTicks = Ticks();
+    fLast = fStartTicks;
+}
+
+void StepProfiler::AddStep(const G4Step* step) {
+    std::uint64_t now = Ticks();
+    const G4VPhysicalVolume* volume = step->GetPreStepPoint()->GetPhysicalVolume();
+    Key key{volume ? volume->GetLogicalVolume() : nullptr,
+            step->GetTrack()->GetParticleDefinition(),
+            step->GetPostStepPoint()->GetProcessDefinedStep()};
+    if (!fLastEntry || !(key == fLastKey)) {
+        fLastEntry = &fTable[key];
+        fLastKey = key;
+    }
+    fLastEntry->steps += 1;
+    fLastEntry->ticks += now - fLast;
+    // The profiler's own lookup is not charged to the next step
+    fLast = Ticks();
+}
+
+void StepProfiler::EndOfRun(const G4String& outputDir, G4int runID) {
+    if (!fEnabled) return;
+
+    std::uint64_t ticks = Ticks() - fStartTicks;
+    G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStartTime).count();
+    G4double secondsPerTick = ticks > 0 ? seconds / G4double(ticks) : 0.;
+
+    // Pointers are per thread (processes) or not unique (names), so merge by name
+    {
+        G4AutoLock lock(&profileMutex);
+        for (const auto& entry : fTable) {
+            const Key& key = entry.first;
+            Totals& totals = mergedTable[std::make_tuple(
+                key.volume ? key.volume->GetName() : G4String("OutOfWorld"),
+                key.particle ? key.particle->GetParticleName() : G4String("unknown"),
+                key.process ? key.process->GetProcessName() : G4String("none"))];
+            totals.steps += entry.second.steps;
+            totals.seconds += entry.second.ticks * secondsPerTick;
+        }
+        if (!fTable.empty()) {
+            mergedThreads += 1;
+            mergedRunSeconds += seconds;
+        }
+    }
+    fTable.clear();
+    fLastEntry = nullptr;
+
+    // Workers have all finished their run when the master ends it
+    if (G4Threading::IsMasterThread()) Report(outputDir, runID);
+}
+
+void StepProfiler::Report(const G4String& outputDir, G4int runID) const {
+    G4AutoLock lock(&profileMutex);
+
+    std::map<G4String, Totals> volumes;
+    std::map<G4String, Totals> particles;
+    Totals total;
+    for (const auto& entry : mergedTable) {
+        const Totals& totals = entry.second;
+        for (Totals* sum : {&volumes[std::get<0>(entry.first)], &particles[std::get<1>(entry.first)], &total}) {
+            sum->steps += totals.steps;
+            sum->seconds += totals.seconds;
+        }
+    }
+
+    G4cout << G4endl
+           << "--------------------Step profile------------------------------" << G4endl
+           << " Steps: " << total.steps << " in " << total.seconds << " s of "
+           << mergedRunSeconds << " s thread time (" << mergedThreads << " threads)" << G4endl;
+    PrintRanking("Volume / particle / process", mergedTable, total.seconds, fTop, &TupleName);
+    PrintRanking("Volume", volumes, total.seconds, fTop, &PlainName);
+    PrintRanking("Particle", particles, total.seconds, fTop, &PlainName);
+    G4cout << "------------------------------------------------------------" << G4endl;
+
+    std::ostringstream fileName;
+    fileName << outputDir << "/profile_run" << runID << ".json";
+    std::ofstream out(fileName.str());
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName.str();
+        G4Exception("StepProfiler::Report()", "ProfileFile", JustWarning, msg);
+        return;
+    }
+    out << std::setprecision(9)
+        << "{\n  \"run\": " << runID
+        << ",\n  \"threads\": " << mergedThreads
+        << ",\n  \"thread_seconds\": " << mergedRunSeconds
+        << ",\n  \"steps\": " << total.steps
+        << ",\n  \"seconds\": " << total.seconds
+        << ",\n  \"entries\": [";
+    G4bool first = true;
+    for (const auto& entry : Ranked(mergedTable)) {
+        out << (first ? "\n" : ",\n")
+            << "    {\"volume\": " << JsonString(std::get<0>(entry.first))
+            << ", \"particle\": " << JsonString(std::get<1>(entry.first))
+            << ", \"process\": " << JsonString(std::get<2>(entry.first))
+            << ", \"steps\": " << entry.second.steps
+            << ", \"seconds\": " << entry.second.seconds << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    G4cout << "Step profile written to " << fileName.str() << G4endl;
+}
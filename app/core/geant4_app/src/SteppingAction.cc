@@ -4,21 +4,36 @@
 
 #include "SteppingAction.hh"
 #include "EventAction.hh"
+#include "TrajectoryRecorder.hh"
+#include "StepProfiler.hh"
+#include "EventGuard.hh"
 
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4SystemOfUnits.hh"
 
-SteppingAction::SteppingAction(EventAction* eventAction)
+SteppingAction::SteppingAction(EventAction* eventAction, TrajectoryRecorder* trajectories,
+                               StepProfiler* profiler, EventGuard* guard)
     : G4UserSteppingAction(),
-      fEventAction(eventAction)
+      fEventAction(eventAction),
+      fTrajectories(trajectories),
+      fProfiler(profiler),
+      fGuard(guard)
 {}
 
 SteppingAction::~SteppingAction() {}
 
 void SteppingAction::UserSteppingAction(const G4Step* step) {
-    // Accumulate energy deposit
-    G4double edep = step->GetTotalEnergyDeposit();
+    // First, so that the step time excludes the user actions
+    if (fProfiler && fProfiler->IsActive()) fProfiler->AddStep(step);
+    
+    // Accumulate energy deposit, weighted for phase-space primaries
+    G4double edep = step->GetTotalEnergyDeposit() * step->GetPreStepPoint()->GetWeight();
     fEventAction->AddEdep(edep);
+    
+    if (fTrajectories && fTrajectories->IsRecording()) fTrajectories->AddStep(step);
+    
+    // Last, since it may kill the track or abort the event
+    if (fGuard && fGuard->IsActive()) fGuard->AddStep(step);
 }
 
@@ -0,0 +1,123 @@
+/**
+ * T-Digest Implementation
+ */
+
+#include "TDigest.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Scale function k1 of the t-digest paper and its inverse: a centroid may
+// span at most one unit of k, which is fine-grained near q = 0 and q = 1
+G4double Scale(G4double q, G4double compression) {
+    return compression / (2. * M_PI) * std::asin(2. * q - 1.);
+}
+
+G4double InverseScale(G4double k, G4double compression) {
+    return (std::sin(k * 2. * M_PI / compression) + 1.) / 2.;
+}
+
+}
+
+TDigest::TDigest(G4double compression)
+    : fCompression(compression),
+      fCentroids(),
+      fBuffer(),
+      fTotal(0.),
+      fMin(std::numeric_limits<G4double>::max()),
+      fMax(std::numeric_limits<G4double>::lowest())
+{
+    fBuffer.reserve(std::size_t(5 * compression));
+}
+
+void TDigest::Add(G4double value, G4double weight) {
+    if (!(weight > 0.)) return;
+    fBuffer.push_back({value, weight});
+    fTotal += weight;
+    fMin = std::min(fMin, value);
+    fMax = std::max(fMax, value);
+    if (fBuffer.size() >= std::size_t(5 * fCompression)) Compress();
+}
+
+void TDigest::Merge(const TDigest& other) {
+    fBuffer.insert(fBuffer.end(), other.fCentroids.begin(), other.fCentroids.end());
+    fBuffer.insert(fBuffer.end(), other.fBuffer.begin(), other.fBuffer.end());
+    fTotal += other.fTotal;
+    fMin = std::min(fMin, other.fMin);
+    fMax = std::max(fMax, other.fMax);
+    Compress();
+}
+
+void TDigest::Clear() {
+    fCentroids.clear();
+    fBuffer.clear();
+    fTotal = 0.;
+    fMin = std::numeric_limits<G4double>::max();
+    fMax = std::numeric_limits<G4double>::lowest();
+}
+
+void TDigest::Compress() {
+    if (fBuffer.empty()) return;
+
+    fBuffer.insert(fBuffer.end(), fCentroids.begin(), fCentroids.end());
+    std::sort(fBuffer.begin(), fBuffer.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+
+    // One pass in order of value, merging neighbours while the merged
+    // centroid stays within one unit of the scale function
+    fCentroids.clear();
+    Centroid current = fBuffer[0];
+    G4double before = 0.;
+    G4double limit = fTotal * InverseScale(Scale(0., fCompression) + 1., fCompression);
+    for (std::size_t i = 1; i < fBuffer.size(); i++) {
+        const Centroid& next = fBuffer[i];
+        if (before + current.weight + next.weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            fCentroids.push_back(current);
+            before += current.weight;
+            limit = fTotal * InverseScale(Scale(before / fTotal, fCompression) + 1., fCompression);
+            current = next;
+        }
+    }
+    fCentroids.push_back(current);
+    fBuffer.clear();
+}
+
+const std::vector<TDigest::Centroid>& TDigest::GetCentroids() {
+    Compress();
+    return fCentroids;
+}
+
+G4double TDigest::Quantile(G4double q) {
+    Compress();
+    if (fCentroids.empty()) return 0.;
+    if (fCentroids.size() == 1) return fCentroids[0].mean;
+
+    // Each centroid is taken to hold its weight spread evenly around its
+    // mean; between the centres of neighbours the value is interpolated,
+    // and beyond the outer centres towards the minimum and maximum
+    G4double target = std::min(std::max(q, 0.), 1.) * fTotal;
+    const Centroid& first = fCentroids.front();
+    if (target < first.weight / 2.) {
+        return fMin + (first.mean - fMin) * target / (first.weight / 2.);
+    }
+    G4double cumulative = first.weight / 2.;
+    for (std::size_t i = 0; i + 1 < fCentroids.size(); i++) {
+        const Centroid& left = fCentroids[i];
+        const Centroid& right = fCentroids[i + 1];
+        G4double step = (left.weight + right.weight) / 2.;
+        if (target < cumulative + step) {
+            return left.mean + (right.mean - left.mean) * (target - cumulative) / step;
+        }
+        cumulative += step;
+    }
+    const Centroid& last = fCentroids.back();
+    G4double rest = last.weight / 2.;
+    return last.mean + (fMax - last.mean) * std::min((target - cumulative) / rest, 1.);
+}
@@ -0,0 +1,126 @@
+/**
+ * Timeline Implementation
+ */
+
+#include "Timeline.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+G4Mutex timelineMutex = G4MUTEX_INITIALIZER;
+
+}
+
+Timeline::Clock::time_point Timeline::fgEpoch = Timeline::Clock::now();
+std::vector<std::pair<G4int, std::vector<Timeline::Span>>> Timeline::fgCollected;
+G4long Timeline::fgNofDropped = 0;
+
+Timeline::Timeline()
+    : fEnabled(false),
+      fMaxSpans(1000000),
+      fSpans(),
+      fNofDropped(0),
+      fRunStart(),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/timeline/", "Per-thread event timeline");
+
+    fMessenger->DeclareProperty("enable", fEnabled)
+        .SetGuidance("Write a Chrome trace of runs, events and end-of-run merges per thread.")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("maxSpans", fMaxSpans)
+        .SetGuidance("Spans kept per thread and run (32 bytes each); later ones are counted and dropped.")
+        .SetParameterName("spans", false)
+        .SetRange("spans>0")
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+Timeline::~Timeline() {
+    delete fMessenger;
+}
+
+void Timeline::BeginOfRun() {
+    fSpans.clear();
+    fNofDropped = 0;
+    if (!fEnabled) return;
+
+    if (G4Threading::IsMasterThread()) {
+        G4AutoLock lock(&timelineMutex);
+        fgEpoch = Clock::now();
+        fgCollected.clear();
+        fgNofDropped = 0;
+    }
+    // Two spans per event; growing the buffer during the run would be
+    // charged to the event that triggers it
+    fSpans.reserve(std::min<std::size_t>(fMaxSpans, 65536));
+    fRunStart = Clock::now();
+}
+
+void Timeline::EndOfRun(const G4String& outputDir, G4int runID) {
+    if (!fEnabled) return;
+    Record("run", fRunStart, runID);
+
+    {
+        G4AutoLock lock(&timelineMutex);
+        fgCollected.emplace_back(G4Threading::G4GetThreadId(), std::move(fSpans));
+        fgNofDropped += fNofDropped;
+    }
+    fSpans = std::vector<Span>();
+
+    // Workers have all handed over their spans when the master ends the run
+    if (G4Threading::IsMasterThread()) Write(outputDir, runID);
+}
+
+void Timeline::Write(const G4String& outputDir, G4int runID) const {
+    G4AutoLock lock(&timelineMutex);
+
+    std::ostringstream fileName;
+    fileName << outputDir << "/timeline_run" << runID << ".json";
+    std::ofstream out(fileName.str());
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName.str();
+        G4Exception("Timeline::Write()", "TimelineFile", JustWarning, msg);
+        return;
+    }
+
+    // Trace times are in microseconds; the master is thread 0, worker n is n+1
+    std::size_t nofSpans = 0;
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+        << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"geant4api run "
+        << runID << "\"}}";
+    for (const auto& thread : fgCollected) {
+        G4int tid = thread.first + 1;
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"";
+        if (thread.first < 0) out << "master";
+        else out << "worker " << thread.first;
+        out << "\"}}";
+        for (const Span& span : thread.second) {
+            out << ",\n{\"name\": \"" << span.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+                << ", \"ts\": " << span.start / 1000 << '.' << (span.start % 1000) / 100
+                << ", \"dur\": " << span.duration / 1000 << '.' << (span.duration % 1000) / 100;
+            if (span.id >= 0) out << ", \"args\": {\"id\": " << span.id << "}";
+            out << "}";
+        }
+        nofSpans += thread.second.size();
+    }
+    out << "\n]}\n";
+
+    G4cout << "Timeline: " << nofSpans << " spans of " << fgCollected.size()
+           << " threads written to " << fileName.str();
+    if (fgNofDropped > 0) {
+        G4cout << " (" << fgNofDropped << " dropped, see /geant4api/timeline/maxSpans)";
+    }
+    G4cout << G4endl;
+}
@@ -0,0 +1,43 @@
+/**
+ * Tracking Action Implementation
+ */
+
+#include "TrackingAction.hh"
+#include "TrajectoryRecorder.hh"
+#include "StepProfiler.hh"
+#include "MemoryWatchdog.hh"
+#include "EventGuard.hh"
+
+#include "G4Track.hh"
+#include "G4EventManager.hh"
+#include "G4StackManager.hh"
+#include "G4RunManager.hh"
+
+TrackingAction::TrackingAction(TrajectoryRecorder* recorder, StepProfiler* profiler,
+                               EventGuard* guard)
+    : G4UserTrackingAction(),
+      fRecorder(recorder),
+      fProfiler(profiler),
+      fGuard(guard),
+      fNofTracks(0)
+{}
+
+TrackingAction::~TrackingAction() {}
+
+void TrackingAction::PreUserTrackingAction(const G4Track* track) {
+    // Kills the rest of the event and ends the run of this thread
+    if (MemoryWatchdog::IsExceeded()) G4RunManager::GetRunManager()->AbortRun(false);
+    // Tracks waiting in the stack, sampled every 256 tracks
+    if ((++fNofTracks & 255) == 0) {
+        G4int nofStacked = G4EventManager::GetEventManager()->GetStackManager()->GetNTotalTrack();
+        MemoryWatchdog::Publish(MemoryWatchdog::kStacks,
+                                nofStacked * (sizeof(G4Track) + sizeof(G4DynamicParticle)));
+    }
+    if (fRecorder->IsActive()) fRecorder->BeginTrack(track);
+    if (fProfiler && fProfiler->IsActive()) fProfiler->BeginTrack();
+    if (fGuard && fGuard->IsActive()) fGuard->BeginTrack();
+}
+
+void TrackingAction::PostUserTrackingAction(const G4Track* track) {
+    if (fRecorder->IsRecording()) fRecorder->EndTrack(track);
+}
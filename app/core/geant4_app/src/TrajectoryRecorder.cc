@@ -0,0 +1,369 @@
+/**
+ * Trajectory Recorder Implementation
+ */
+
+#include "TrajectoryRecorder.hh"
+#include "MemoryWatchdog.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char kMagic[4] = {'G', '4', 'T', 'J'};
+const std::uint32_t kVersion = 1;
+const G4double kTimeQuantum = 1.*picosecond;
+const G4double kEnergyQuantum = 1.*keV;
+
+void PutVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+// Zigzag keeps small negative deltas small
+void PutSigned(std::string& out, std::int64_t value) {
+    PutVarint(out, (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63));
+}
+
+void PutFloat(std::string& out, float value) {
+    char bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(float));
+    out.append(bytes, sizeof(float));
+}
+
+G4double SegmentDistance(const G4ThreeVector& p, const G4ThreeVector& a, const G4ThreeVector& b) {
+    G4ThreeVector ab = b - a;
+    G4double length2 = ab.mag2();
+    if (length2 <= 0.) return (p - a).mag();
+    G4double t = std::min(1., std::max(0., (p - a).dot(ab) / length2));
+    return (p - (a + t * ab)).mag();
+}
+
+}
+
+TrajectoryRecorder::TrajectoryRecorder()
+    : fFull(false),
+      fCompact(false),
+      fRecording(false),
+      fMinEnergy(1.*MeV),
+      fMaxGeneration(-1),
+      fTolerance(1.*mm),
+      fQuantum(0.1*mm),
+      fCurrent(0),
+      fTrack(),
+      fNofBlockTracks(0),
+      fNofBlockInputPoints(0),
+      fNofBlockKeptPoints(0),
+      fNofTracks(0),
+      fNofInputPoints(0),
+      fNofKeptPoints(0),
+      fNofBytes(0),
+      fMessenger(nullptr)
+{
+    fMessenger = new G4GenericMessenger(this, "/geant4api/trajectories/", "Compact trajectory output");
+
+    fMessenger->DeclareProperty("enable", fCompact)
+        .SetGuidance("Write simplified, quantised track polylines of every event.")
+        .SetParameterName("enable", true)
+        .SetDefaultValue("true")
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclarePropertyWithUnit("minEnergy", "MeV", fMinEnergy)
+        .SetGuidance("Only record tracks starting above this kinetic energy.")
+        .SetParameterName("energy", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclareProperty("maxGeneration", fMaxGeneration)
+        .SetGuidance("Only record tracks up to this generation (0 = primaries, -1 = all).")
+        .SetParameterName("generation", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclarePropertyWithUnit("tolerance", "mm", fTolerance)
+        .SetGuidance("Largest distance of a dropped step point from the simplified polyline.")
+        .SetParameterName("distance", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+
+    fMessenger->DeclarePropertyWithUnit("quantum", "mm", fQuantum)
+        .SetGuidance("Position quantisation step of the stored points.")
+        .SetParameterName("step", false)
+        .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    EndOfRun();
+    delete fMessenger;
+}
+
+void TrajectoryRecorder::BeginOfRun(const G4String& outputDir, G4int runID) {
+    fNofTracks = fNofInputPoints = fNofKeptPoints = fNofBytes = 0;
+    fStrings.clear();
+    if (!fCompact || fFull ||
+        (G4Threading::IsMasterThread() && G4Threading::IsMultithreadedApplication())) {
+        return;
+    }
+    if (fQuantum <= 0.) fQuantum = 0.1*mm;
+
+    std::ostringstream fileName;
+    fileName << outputDir << "/trajectories_run" << runID;
+    if (G4Threading::G4GetThreadId() >= 0) fileName << "_t" << G4Threading::G4GetThreadId();
+    fileName << ".trj";
+    fFile.open(fileName.str(), std::ios::binary | std::ios::trunc);
+    if (!fFile) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName.str();
+        G4Exception("TrajectoryRecorder::BeginOfRun()", "TrajectoryFile", JustWarning, msg);
+        return;
+    }
+
+    std::string header(kMagic, sizeof(kMagic));
+    header.append(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    std::int32_t run = runID;
+    header.append(reinterpret_cast<const char*>(&run), sizeof(run));
+    PutFloat(header, float(fQuantum/mm));
+    PutFloat(header, float(kTimeQuantum/ns));
+    PutFloat(header, float(kEnergyQuantum/MeV));
+    fFile.write(header.data(), header.size());
+    fNofBytes += header.size();
+}
+
+void TrajectoryRecorder::EndOfRun() {
+    if (!fFile.is_open()) return;
+    fFile.close();
+    G4cout << "Trajectories: " << fNofTracks << " tracks, " << fNofKeptPoints << " of "
+           << fNofInputPoints << " points kept, " << fNofBytes << " bytes" << G4endl;
+}
+
+void TrajectoryRecorder::Clear() {
+    fTrajectories.clear();
+    fCurrent = 0;
+    fGenerations.clear();
+    fBlock.clear();
+    fNofBlockTracks = 0;
+    fNofBlockInputPoints = fNofBlockKeptPoints = 0;
+    fPendingStrings.clear();
+    fRecording = false;
+}
+
+void TrajectoryRecorder::BeginTrack(const G4Track* track) {
+    // Parents are always started before their secondaries
+    G4int trackID = track->GetTrackID();
+    G4int parentID = track->GetParentID();
+    G4int generation = 0;
+    if (parentID > 0 && parentID < G4int(fGenerations.size())) generation = fGenerations[parentID] + 1;
+    if (trackID >= G4int(fGenerations.size())) fGenerations.resize(trackID + 1, 0);
+    fGenerations[trackID] = generation;
+
+    fRecording = fFull ||
+        (fFile.is_open() && !MemoryWatchdog::IsDegraded() && track->GetKineticEnergy() >= fMinEnergy &&
+         (fMaxGeneration < 0 || generation <= fMaxGeneration));
+    if (!fRecording) return;
+
+    if (fFull) {
+        fCurrent = fTrajectories.size();
+        fTrajectories.emplace_back();
+    }
+    Trajectory& trajectory = Current();
+    trajectory.trackID = trackID;
+    trajectory.parentID = parentID;
+    trajectory.generation = generation;
+    trajectory.particleName = track->GetParticleDefinition()->GetParticleName();
+    trajectory.pdg = track->GetParticleDefinition()->GetPDGEncoding();
+    trajectory.initialEnergy = track->GetKineticEnergy();
+    const G4VProcess* creator = track->GetCreatorProcess();
+    trajectory.creatorProcess = creator ? creator->GetProcessName() : G4String("primary");
+    trajectory.endProcess = "";
+    trajectory.points.clear();
+    trajectory.points.push_back({track->GetPosition(), track->GetGlobalTime(),
+                                 track->GetKineticEnergy(), track->GetMomentumDirection()});
+}
+
+void TrajectoryRecorder::AddPoint(Trajectory& trajectory, const G4StepPoint* point) {
+    trajectory.points.push_back({point->GetPosition(), point->GetGlobalTime(),
+                                 point->GetKineticEnergy(), point->GetMomentumDirection()});
+}
+
+void TrajectoryRecorder::AddStep(const G4Step* step) {
+    if (!fRecording) return;
+    AddPoint(Current(), step->GetPostStepPoint());
+}
+
+void TrajectoryRecorder::EndTrack(const G4Track* track) {
+    if (!fRecording) return;
+    fRecording = false;
+
+    Trajectory& trajectory = Current();
+    const G4Step* step = track->GetStep();
+    const G4VProcess* process = step ? step->GetPostStepPoint()->GetProcessDefinedStep() : nullptr;
+    trajectory.endProcess = process ? process->GetProcessName() : G4String("");
+
+    if (!fFull) Encode(trajectory);
+}
+
+void TrajectoryRecorder::Simplify(const std::vector<Point>& points) {
+    std::size_t n = points.size();
+    fKeep.assign(n, 0);
+    if (n == 0) return;
+    fKeep[0] = fKeep[n - 1] = 1;
+
+    // Douglas-Peucker with an explicit stack of open intervals
+    fStack.clear();
+    if (n > 2) fStack.emplace_back(0, n - 1);
+    while (!fStack.empty()) {
+        std::size_t first = fStack.back().first;
+        std::size_t last = fStack.back().second;
+        fStack.pop_back();
+
+        const G4ThreeVector& a = points[first].position;
+        const G4ThreeVector& b = points[last].position;
+        G4double maxDistance = 0.;
+        std::size_t farthest = first;
+        for (std::size_t i = first + 1; i < last; i++) {
+            G4double distance = SegmentDistance(points[i].position, a, b);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+        if (maxDistance <= fTolerance) continue;
+
+        fKeep[farthest] = 1;
+        if (farthest - first > 1) fStack.emplace_back(first, farthest);
+        if (last - farthest > 1) fStack.emplace_back(farthest, last);
+    }
+}
+
+void TrajectoryRecorder::PutString(const G4String& value) {
+    auto it = fStrings.find(value);
+    if (it != fStrings.end()) {
+        PutVarint(fBlock, it->second);
+        return;
+    }
+    // A new index is followed by the name itself
+    std::size_t index = fStrings.size();
+    fStrings[value] = index;
+    fPendingStrings.push_back(value);
+    PutVarint(fBlock, index);
+    PutVarint(fBlock, value.size());
+    fBlock.append(value);
+}
+
+void TrajectoryRecorder::Encode(const Trajectory& trajectory) {
+    Simplify(trajectory.points);
+
+    PutVarint(fBlock, trajectory.trackID);
+    PutVarint(fBlock, trajectory.parentID);
+    PutVarint(fBlock, trajectory.generation);
+    PutString(trajectory.particleName);
+    PutSigned(fBlock, trajectory.pdg);
+    PutFloat(fBlock, float(trajectory.initialEnergy/MeV));
+    PutString(trajectory.creatorProcess);
+    PutString(trajectory.endProcess);
+
+    std::size_t nofKept = std::count(fKeep.begin(), fKeep.end(), 1);
+    PutVarint(fBlock, nofKept);
+
+    // Deltas between quantised points, so rounding errors do not accumulate
+    std::int64_t previous[5] = {0, 0, 0, 0, 0};
+    for (std::size_t i = 0; i < trajectory.points.size(); i++) {
+        if (!fKeep[i]) continue;
+        const Point& point = trajectory.points[i];
+        std::int64_t q[5] = {std::llround(point.position.x() / fQuantum),
+                             std::llround(point.position.y() / fQuantum),
+                             std::llround(point.position.z() / fQuantum),
+                             std::llround(point.time / kTimeQuantum),
+                             std::llround(point.kineticEnergy / kEnergyQuantum)};
+        for (G4int c = 0; c < 5; c++) {
+            PutSigned(fBlock, q[c] - previous[c]);
+            previous[c] = q[c];
+        }
+    }
+
+    fNofBlockTracks++;
+    fNofBlockInputPoints += trajectory.points.size();
+    fNofBlockKeptPoints += nofKept;
+}
+
+void TrajectoryRecorder::EndOfEvent(G4int eventID, G4bool accepted) {
+    if (fFull || !fFile.is_open()) return;
+
+    if (!accepted) {
+        for (const auto& name : fPendingStrings) fStrings.erase(name);
+    } else if (fNofBlockTracks > 0) {
+        std::string header;
+        PutVarint(header, eventID);
+        PutVarint(header, fNofBlockTracks);
+        std::uint32_t length = std::uint32_t(header.size() + fBlock.size());
+        fFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        fFile.write(header.data(), header.size());
+        fFile.write(fBlock.data(), fBlock.size());
+        fNofTracks += fNofBlockTracks;
+        fNofInputPoints += fNofBlockInputPoints;
+        fNofKeptPoints += fNofBlockKeptPoints;
+        fNofBytes += sizeof(length) + length;
+    }
+    Clear();
+}
+
+std::size_t TrajectoryRecorder::GetBufferedBytes() const {
+    std::size_t bytes = fBlock.capacity() + fTrack.points.capacity() * sizeof(Point);
+    for (const Trajectory& trajectory : fTrajectories) {
+        bytes += sizeof(Trajectory) + trajectory.points.capacity() * sizeof(Point);
+    }
+    return bytes;
+}
+
+void TrajectoryRecorder::WriteJson(const G4String& fileName, G4int runID, G4int eventID) const {
+    std::ofstream out(fileName);
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write " << fileName;
+        G4Exception("TrajectoryRecorder::WriteJson()", "TrajectoryFile", JustWarning, msg);
+        return;
+    }
+
+    out << std::setprecision(9);
+    out << "{\n  \"run_id\": " << runID << ",\n  \"event_id\": " << eventID << ",\n  \"trajectories\": [";
+    for (std::size_t i = 0; i < fTrajectories.size(); i++) {
+        const Trajectory& trajectory = fTrajectories[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"event_id\": " << eventID
+            << ", \"track_id\": " << trajectory.trackID
+            << ", \"parent_id\": " << trajectory.parentID
+            << ", \"particle_name\": \"" << trajectory.particleName << "\""
+            << ", \"particle_pdg\": " << trajectory.pdg
+            << ", \"initial_energy\": " << trajectory.initialEnergy/MeV
+            << ", \"process_name\": \"" << trajectory.creatorProcess << "\"";
+        if (trajectory.endProcess.empty()) out << ", \"end_process\": null";
+        else out << ", \"end_process\": \"" << trajectory.endProcess << "\"";
+        out << ", \"points\": [";
+        for (std::size_t p = 0; p < trajectory.points.size(); p++) {
+            const Point& point = trajectory.points[p];
+            out << (p ? ", " : "")
+                << "{\"x\": " << point.position.x()/mm
+                << ", \"y\": " << point.position.y()/mm
+                << ", \"z\": " << point.position.z()/mm
+                << ", \"t\": " << point.time/ns
+                << ", \"kinetic_energy\": " << point.kineticEnergy/MeV
+                << ", \"momentum_direction\": [" << point.direction.x() << ", "
+                << point.direction.y() << ", " << point.direction.z() << "]}";
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+
+    G4cout << "Wrote " << fTrajectories.size() << " trajectories to " << fileName << G4endl;
+}
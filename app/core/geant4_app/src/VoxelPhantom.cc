@@ -0,0 +1,251 @@
+/**
+ * Voxel Phantom Implementation
+ */
+
+#include "VoxelPhantom.hh"
+
+#include "G4NistManager.hh"
+#include "G4Material.hh"
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4PhantomParameterisation.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// HU ramp: upper HU bound of each interval and its base material
+struct RampEntry {
+    G4int huMax;
+    const char* material;
+};
+
+const RampEntry kRamp[] = {
+    {-950,  "G4_AIR"},
+    {-120,  "G4_LUNG_ICRP"},
+    {-20,   "G4_ADIPOSE_TISSUE_ICRP"},
+    {100,   "G4_TISSUE_SOFT_ICRP"},
+    {300,   "G4_BONE_COMPACT_ICRU"},
+    {32767, "G4_BONE_CORTICAL_ICRP"}
+};
+const G4int kNRamp = sizeof(kRamp) / sizeof(kRamp[0]);
+
+// HU to mass density calibration (g/cm3), linearly interpolated
+const G4double kCalibration[][2] = {
+    {-1000., 0.00121},
+    {0.,     1.0},
+    {100.,   1.1},
+    {1600.,  1.96},
+    {3071.,  2.8}
+};
+const G4int kNCalibration = sizeof(kCalibration) / sizeof(kCalibration[0]);
+
+G4double DensityFromHU(G4int hu) {
+    if (hu <= kCalibration[0][0]) return kCalibration[0][1]*g/cm3;
+    for (G4int i = 1; i < kNCalibration; i++) {
+        if (hu <= kCalibration[i][0]) {
+            G4double f = (hu - kCalibration[i-1][0]) / (kCalibration[i][0] - kCalibration[i-1][0]);
+            return (kCalibration[i-1][1] + f * (kCalibration[i][1] - kCalibration[i-1][1]))*g/cm3;
+        }
+    }
+    return kCalibration[kNCalibration-1][1]*g/cm3;
+}
+
+G4int RampIndex(G4int hu) {
+    for (G4int i = 0; i < kNRamp; i++) {
+        if (hu <= kRamp[i].huMax) return i;
+    }
+    return kNRamp - 1;
+}
+
+const G4int kHUOffset = 32768;
+
+}
+
+VoxelPhantom::VoxelPhantom(const G4String& headerFile)
+    : fHeaderFile(headerFile),
+      fDataFile(""),
+      fNVoxels{0, 0, 0},
+      fVoxelHalf{0., 0., 0.},
+      fDensityStep(0.1*g/cm3),
+      fContainerLogical(nullptr)
+{}
+
+VoxelPhantom::~VoxelPhantom() {}
+
+void VoxelPhantom::ReadHeader() {
+    std::ifstream header(fHeaderFile);
+    if (!header) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open CT header " << fHeaderFile;
+        G4Exception("VoxelPhantom::ReadHeader()", "CTHeader", FatalException, msg);
+        return;
+    }
+
+    std::string line;
+    while (std::getline(header, line)) {
+        std::istringstream is(line);
+        std::string key;
+        if (!(is >> key) || key[0] == '#') continue;
+
+        if (key == "dimensions") {
+            is >> fNVoxels[0] >> fNVoxels[1] >> fNVoxels[2];
+        } else if (key == "voxel_size") {
+            for (G4int i = 0; i < 3; i++) {
+                G4double size;
+                is >> size;
+                fVoxelHalf[i] = 0.5 * size * mm;
+            }
+        } else if (key == "data") {
+            is >> fDataFile;
+        }
+    }
+
+    if (fNVoxels[0] <= 0 || fNVoxels[1] <= 0 || fNVoxels[2] <= 0 ||
+        fVoxelHalf[0] <= 0. || fVoxelHalf[1] <= 0. || fVoxelHalf[2] <= 0. || fDataFile.empty()) {
+        G4ExceptionDescription msg;
+        msg << "CT header " << fHeaderFile << " needs dimensions, voxel_size and data";
+        G4Exception("VoxelPhantom::ReadHeader()", "CTHeader", FatalException, msg);
+    }
+
+    // Data path is relative to the header
+    std::size_t slash = fHeaderFile.rfind('/');
+    if (fDataFile[0] != '/' && slash != std::string::npos) {
+        fDataFile = fHeaderFile.substr(0, slash + 1) + fDataFile;
+    }
+}
+
+std::size_t VoxelPhantom::KeyIndex(G4int hu, std::vector<std::pair<G4int, G4int>>& keys) {
+    std::pair<G4int, G4int> key(RampIndex(hu), G4int(DensityFromHU(hu) / fDensityStep));
+    auto it = std::find(keys.begin(), keys.end(), key);
+    if (it != keys.end()) return it - keys.begin();
+    keys.push_back(key);
+    return keys.size() - 1;
+}
+
+void VoxelPhantom::Load() {
+    ReadHeader();
+
+    std::ifstream data(fDataFile, std::ios::binary);
+    if (!data) {
+        G4ExceptionDescription msg;
+        msg << "Cannot open CT data " << fDataFile;
+        G4Exception("VoxelPhantom::Load()", "CTData", FatalException, msg);
+        return;
+    }
+
+    const std::size_t sliceSize = std::size_t(fNVoxels[0]) * fNVoxels[1];
+    fMaterialIndices.resize(sliceSize * fNVoxels[2]);
+
+    // HU values are only resolved once each; voxels store the slot index.
+    // Counts per HU give the mean density of every slot afterwards.
+    std::vector<G4int> huToIndex(65536, -1);
+    std::vector<std::size_t> huCount(65536, 0);
+    std::vector<std::pair<G4int, G4int>> keys;
+
+    // Stream one slice at a time so the HU volume is never held in memory
+    std::vector<std::int16_t> slice(sliceSize);
+    for (G4int iz = 0; iz < fNVoxels[2]; iz++) {
+        data.read(reinterpret_cast<char*>(slice.data()), sliceSize * sizeof(std::int16_t));
+        if (!data) {
+            G4ExceptionDescription msg;
+            msg << "CT data " << fDataFile << " ends at slice " << iz;
+            G4Exception("VoxelPhantom::Load()", "CTData", FatalException, msg);
+            return;
+        }
+
+        std::size_t* indices = fMaterialIndices.data() + iz * sliceSize;
+        for (std::size_t i = 0; i < sliceSize; i++) {
+            G4int hu = slice[i];
+            G4int& index = huToIndex[hu + kHUOffset];
+            if (index < 0) index = G4int(KeyIndex(hu, keys));
+            indices[i] = index;
+            huCount[hu + kHUOffset]++;
+        }
+    }
+
+    // One material per slot, with the mean density of its voxels
+    std::vector<G4double> densitySum(keys.size(), 0.);
+    std::vector<std::size_t> voxelSum(keys.size(), 0);
+    for (G4int hu = -kHUOffset; hu < kHUOffset; hu++) {
+        G4int index = huToIndex[hu + kHUOffset];
+        if (index < 0) continue;
+        densitySum[index] += huCount[hu + kHUOffset] * DensityFromHU(hu);
+        voxelSum[index] += huCount[hu + kHUOffset];
+    }
+
+    G4NistManager* nist = G4NistManager::Instance();
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        G4Material* base = nist->FindOrBuildMaterial(kRamp[keys[i].first].material);
+        G4double density = densitySum[i] / voxelSum[i];
+        std::ostringstream name;
+        name << base->GetName() << "_" << keys[i].second;
+        fMaterials.push_back(new G4Material(name.str(), density, base));
+    }
+
+    G4cout << "Loaded CT " << fHeaderFile << ": "
+           << fNVoxels[0] << "x" << fNVoxels[1] << "x" << fNVoxels[2] << " voxels, "
+           << fMaterials.size() << " materials" << G4endl;
+}
+
+std::vector<G4LogicalVolume*> VoxelPhantom::Build(G4LogicalVolume* mother, G4bool regularNavigation) {
+    G4Material* air = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
+
+    G4Box* containerSolid = new G4Box("PhantomContainer", GetHalfX(), GetHalfY(), GetHalfZ());
+    fContainerLogical = new G4LogicalVolume(containerSolid, air, "PhantomContainer");
+    G4VPhysicalVolume* containerPhysical = new G4PVPlacement(
+        nullptr, G4ThreeVector(), fContainerLogical, "PhantomContainer", mother, false, 0);
+
+    G4Box* voxelSolid = new G4Box("Voxel", fVoxelHalf[0], fVoxelHalf[1], fVoxelHalf[2]);
+
+    std::vector<G4LogicalVolume*> voxelVolumes;
+
+    if (regularNavigation) {
+        G4LogicalVolume* voxelLogical = new G4LogicalVolume(voxelSolid, fMaterials[0], "Phantom");
+
+        auto* param = new G4PhantomParameterisation();
+        param->SetVoxelDimensions(fVoxelHalf[0], fVoxelHalf[1], fVoxelHalf[2]);
+        param->SetNoVoxels(fNVoxels[0], fNVoxels[1], fNVoxels[2]);
+        param->SetMaterials(fMaterials);
+        param->SetMaterialIndices(fMaterialIndices.data());
+        param->SetSkipEqualMaterials(true);
+        param->BuildContainerSolid(containerPhysical);
+        param->CheckVoxelsFillContainer(GetHalfX(), GetHalfY(), GetHalfZ());
+
+        G4PVParameterised* voxelPhysical = new G4PVParameterised(
+            "Phantom", voxelLogical, fContainerLogical, kUndefined,
+            G4int(param->GetNoVoxels()), param);
+        voxelPhysical->SetRegularStructureId(1);
+
+        voxelVolumes.push_back(voxelLogical);
+        G4cout << "Voxel phantom: regular navigation, " << GetNoVoxels() << " voxels" << G4endl;
+        return voxelVolumes;
+    }
+
+    // Reference build: one logical volume per material, one placement per voxel
+    for (std::size_t i = 0; i < fMaterials.size(); i++) {
+        voxelVolumes.push_back(new G4LogicalVolume(voxelSolid, fMaterials[i], "Phantom_" + std::to_string(i)));
+    }
+
+    std::size_t copyNo = 0;
+    for (G4int iz = 0; iz < fNVoxels[2]; iz++) {
+        for (G4int iy = 0; iy < fNVoxels[1]; iy++) {
+            for (G4int ix = 0; ix < fNVoxels[0]; ix++, copyNo++) {
+                G4ThreeVector position((2*ix + 1) * fVoxelHalf[0] - GetHalfX(),
+                                       (2*iy + 1) * fVoxelHalf[1] - GetHalfY(),
+                                       (2*iz + 1) * fVoxelHalf[2] - GetHalfZ());
+                new G4PVPlacement(nullptr, position, voxelVolumes[fMaterialIndices[copyNo]],
+                                  "Voxel", fContainerLogical, false, G4int(copyNo), false);
+            }
+        }
+    }
+
+    G4cout << "Voxel phantom: one placement per voxel, " << GetNoVoxels() << " voxels" << G4endl;
+    return voxelVolumes;
+}
@@ -0,0 +1,180 @@
+/**
+ * Woodcock Model Implementation
+ */
+
+#include "WoodcockModel.hh"
+#include "VoxelPhantom.hh"
+
+#include "G4FastStep.hh"
+#include "G4FastTrack.hh"
+#include "G4Gamma.hh"
+#include "G4EmCalculator.hh"
+#include "G4VEmProcess.hh"
+#include "G4ProcessManager.hh"
+#include "G4ParticleChangeForGamma.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Region.hh"
+#include "G4Material.hh"
+#include "G4VSolid.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+WoodcockModel::WoodcockModel(const G4String& name, G4Region* envelope, const VoxelPhantom* phantom)
+    : G4VFastSimulationModel(name, envelope),
+      fPhantom(phantom),
+      fMinEnergy(1.*keV),
+      fMaxEnergy(100.*MeV),
+      fNBins(241),
+      fLogMin(std::log(fMinEnergy)),
+      fLogStep((std::log(fMaxEnergy) - std::log(fMinEnergy)) / (fNBins - 1)),
+      fLastTrackID(-1),
+      fLastPosition(),
+      fInteractionPending(false)
+{}
+
+WoodcockModel::~WoodcockModel() {}
+
+G4bool WoodcockModel::IsApplicable(const G4ParticleDefinition& particle) {
+    return &particle == G4Gamma::Definition();
+}
+
+G4bool WoodcockModel::ModelTrigger(const G4FastTrack& fastTrack) {
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    // At the point of the previous step: interact there, or leave the step
+    // after a handover to standard transport, which moves the photon on
+    if (AtLastPoint(track)) return fInteractionPending;
+    G4double energy = track->GetKineticEnergy();
+    return energy >= fMinEnergy && energy < fMaxEnergy;
+}
+
+G4bool WoodcockModel::AtLastPoint(const G4Track* track) const {
+    return track->GetTrackID() == fLastTrackID && (track->GetPosition() - fLastPosition).mag() < 1.*nm;
+}
+
+void WoodcockModel::BuildTables() {
+    G4EmCalculator calculator;
+    const std::vector<G4Material*>& materials = fPhantom->GetMaterials();
+
+    fMu.assign(materials.size(), std::vector<G4double>(fNBins, 0.));
+    fMuMax.assign(fNBins, 0.);
+
+    for (std::size_t m = 0; m < materials.size(); m++) {
+        for (G4int i = 0; i < fNBins; i++) {
+            G4double energy = std::exp(fLogMin + i * fLogStep);
+            G4double length = calculator.ComputeGammaAttenuationLength(energy, materials[m]);
+            fMu[m][i] = (length > 0. && length < DBL_MAX) ? 1. / length : 0.;
+            fMuMax[i] = std::max(fMuMax[i], fMu[m][i]);
+        }
+    }
+
+    G4ProcessVector* processes = G4Gamma::Definition()->GetProcessManager()->GetPostStepProcessVector();
+    for (std::size_t i = 0; i < processes->size(); i++) {
+        G4VEmProcess* process = dynamic_cast<G4VEmProcess*>((*processes)[i]);
+        if (!process) continue;
+        if (process->GetProcessName() == "GammaGeneralProc") {
+            G4ExceptionDescription msg;
+            msg << "Woodcock tracking needs the separate gamma processes; "
+                << "add /process/em/UseGeneralProcess false before /run/initialize";
+            G4Exception("WoodcockModel::BuildTables()", "WoodcockProcess", FatalException, msg);
+        }
+        fProcesses.push_back(process);
+    }
+    fCrossSections.assign(fProcesses.size(), 0.);
+}
+
+G4double WoodcockModel::Attenuation(const std::vector<G4double>& table, G4double logEnergy) const {
+    G4double x = (logEnergy - fLogMin) / fLogStep;
+    G4int i = std::min(std::max(G4int(x), 0), fNBins - 2);
+    G4double f = x - i;
+    return table[i] + f * (table[i+1] - table[i]);
+}
+
+void WoodcockModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) {
+    if (fMu.empty()) BuildTables();
+
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    if (fInteractionPending && AtLastPoint(track)) {
+        Interact(fastTrack, fastStep);
+        return;
+    }
+
+    G4double logEnergy = std::log(track->GetKineticEnergy());
+    // Interpolated mu_max bounds every interpolated mu on the same grid
+    G4double muMax = Attenuation(fMuMax, logEnergy);
+
+    G4ThreeVector start = fastTrack.GetPrimaryTrackLocalPosition();
+    G4ThreeVector direction = fastTrack.GetPrimaryTrackLocalDirection();
+    G4double exitDistance = fastTrack.GetEnvelopeSolid()->DistanceToOut(start, direction);
+
+    G4double distance = SampleDistance(exitDistance, muMax, [&](G4double s) {
+        return Attenuation(fMu[fPhantom->GetMaterialIndex(start + s * direction)], logEnergy);
+    });
+
+    // Stop just short of the envelope surface when the photon escapes
+    fInteractionPending = distance < exitDistance;
+    if (!fInteractionPending) distance = std::max(0., exitDistance - 1.*nm);
+
+    G4ThreeVector local = start + distance * direction;
+    fastStep.ProposePrimaryTrackFinalPosition(local, true);
+    fastStep.ProposePrimaryTrackPathLength(distance);
+    fastStep.ProposePrimaryTrackFinalTime(track->GetGlobalTime() + distance / c_light);
+
+    fLastTrackID = track->GetTrackID();
+    fLastPosition = fastTrack.GetInverseAffineTransformation()->TransformPoint(local);
+}
+
+void WoodcockModel::Interact(const G4FastTrack& fastTrack, G4FastStep& fastStep) {
+    fInteractionPending = false;
+    fLastTrackID = -1;
+
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    G4double energy = track->GetKineticEnergy();
+    G4double logEnergy = std::log(energy);
+
+    // Couple of the material the accept test used, with the envelope cuts
+    const G4Material* material =
+        fPhantom->GetMaterials()[fPhantom->GetMaterialIndex(fastTrack.GetPrimaryTrackLocalPosition())];
+    const G4MaterialCutsCouple* couple = G4ProductionCutsTable::GetProductionCutsTable()
+        ->GetMaterialCutsCouple(material, fastTrack.GetEnvelope()->GetProductionCuts());
+    if (!couple) couple = track->GetMaterialCutsCouple();
+
+    // Cross sections also set each process's current couple for PostStepDoIt
+    G4double total = 0.;
+    for (std::size_t k = 0; k < fProcesses.size(); k++) {
+        total += fProcesses[k]->CrossSectionPerVolume(energy, couple, logEnergy);
+        fCrossSections[k] = total;
+    }
+    fastStep.ProposePrimaryTrackPathLength(0.);
+    if (total <= 0.) return;
+
+    G4double r = G4UniformRand() * total;
+    std::size_t k = std::lower_bound(fCrossSections.begin(), fCrossSections.end(), r) - fCrossSections.begin();
+    k = std::min(k, fProcesses.size() - 1);
+
+    G4ParticleChangeForGamma* change =
+        static_cast<G4ParticleChangeForGamma*>(fProcesses[k]->PostStepDoIt(*track, *track->GetStep()));
+
+    fastStep.ProposeTotalEnergyDeposited(change->GetLocalEnergyDeposit());
+    if (change->GetTrackStatus() == fStopAndKill || change->GetProposedKineticEnergy() <= 0.) {
+        fastStep.KillPrimaryTrack();
+    } else {
+        fastStep.ProposePrimaryTrackFinalKineticEnergy(change->GetProposedKineticEnergy());
+        fastStep.ProposePrimaryTrackFinalMomentumDirection(change->GetProposedMomentumDirection(), false);
+        fastStep.ProposePrimaryTrackFinalPolarization(change->GetProposedPolarization(), false);
+    }
+
+    // The secondaries are copied into the fast step, which owns the copies
+    G4int nofSecondaries = change->GetNumberOfSecondaries();
+    fastStep.SetNumberOfSecondaryTracks(nofSecondaries);
+    for (G4int i = 0; i < nofSecondaries; i++) {
+        G4Track* secondary = change->GetSecondary(i);
+        fastStep.CreateSecondaryTrack(*secondary->GetDynamicParticle(), secondary->GetPosition(),
+                                      secondary->GetGlobalTime(), false);
+        delete secondary;
+    }
+    change->Clear();
+}
@@ -14,36 +14,77 @@
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
 
-#include "FTFP_BERT.hh"
-#include "QGSP_BERT.hh"
-#include "QGSP_BIC.hh"
-#include "Shielding.hh"
-#include "G4EmStandardPhysics_option4.hh"
+#include "PhysicsListBuilder.hh"
+#include "EventRecorder.hh"
+#include "StartupMetrics.hh"
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 void PrintUsage() {
     G4cerr << "Usage: geant4api [options] [macro.mac]" << G4endl;
     G4cerr << "Options:" << G4endl;
     G4cerr << "  -g, --gdml <file>    Load geometry from GDML file" << G4endl;
-    G4cerr << "  -p, --physics <name> Physics list (FTFP_BERT, QGSP_BERT, QGSP_BIC, Shielding)" << G4endl;
+    G4cerr << "  -p, --physics <name> Reference physics list (FTFP_BERT, QGSP_BERT, QGSP_BIC, Shielding, ...)" << G4endl;
+    G4cerr << "  -P, --preset <name>  Physics preset (see below)" << G4endl;
+    G4cerr << "  -e, --em <option>    EM physics (standard, option1-4, livermore, penelope)" << G4endl;
+    G4cerr << "  -w, --with <list>    Extra physics builders (steplimiter, radioactive, optical, fastshower, woodcock)" << G4endl;
     G4cerr << "  -t, --threads <n>    Number of threads (for MT build)" << G4endl;
     G4cerr << "  -o, --output <dir>   Output directory" << G4endl;
+    G4cerr << "  -f, --fast-shower    Parameterise EM showers in GDML FastShower volumes" << G4endl;
     G4cerr << "  -v, --vis            Enable visualization" << G4endl;
     G4cerr << "  -i, --interactive    Interactive mode" << G4endl;
+    G4cerr << "  -r, --replay <r>:<e> Re-run event e of run r of the macro with full trajectories" << G4endl;
     G4cerr << "  -h, --help           Print this help" << G4endl;
+    PhysicsListBuilder::PrintPresets();
+}
+
+// Applies the macro up to the /run/beamOn of the replayed run, which is
+// skipped like all earlier ones; nested macros are followed
+G4bool ExecuteUntilRun(G4UImanager* UImanager, const G4String& macroFile, G4int targetRun, G4int& runCount) {
+    std::ifstream macro(macroFile);
+    if (!macro) {
+        G4cerr << "Cannot open macro file: " << macroFile << G4endl;
+        return false;
+    }
+    
+    std::string line;
+    while (std::getline(macro, line)) {
+        std::istringstream is(line);
+        std::string command;
+        if (!(is >> command) || command[0] == '#') continue;
+        
+        if (command == "/run/beamOn") {
+            if (runCount++ == targetRun) return true;
+        } else if (command == "/control/execute") {
+            std::string nested;
+            is >> nested;
+            if (ExecuteUntilRun(UImanager, nested, targetRun, runCount)) return true;
+        } else {
+            UImanager->ApplyCommand(line);
+        }
+    }
+    return false;
 }
 
 int main(int argc, char** argv) {
     // Parse command line arguments
     G4String macroFile = "";
     G4String gdmlFile = "";
-    G4String physicsName = "FTFP_BERT";
+    G4String physicsName = "";
+    G4String presetName = "";
+    G4String emOption = "";
+    G4String extraBuilders = "";
     G4String outputDir = ".";
     G4int nThreads = 1;
     G4bool useVis = false;
     G4bool interactive = false;
+    G4bool fastShower = false;
+    G4int replayRun = -1;
+    G4int replayEvent = -1;
     
     for (int i = 1; i < argc; i++) {
         G4String arg = argv[i];
@@ -58,23 +99,54 @@ int main(int argc, char** argv) {
         else if (arg == "-p" || arg == "--physics") {
             if (i + 1 < argc) physicsName = argv[++i];
         }
+        else if (arg == "-P" || arg == "--preset") {
+            if (i + 1 < argc) presetName = argv[++i];
+        }
+        else if (arg == "-e" || arg == "--em") {
+            if (i + 1 < argc) emOption = argv[++i];
+        }
+        else if (arg == "-w" || arg == "--with") {
+            if (i + 1 < argc) extraBuilders = argv[++i];
+        }
         else if (arg == "-t" || arg == "--threads") {
             if (i + 1 < argc) nThreads = std::stoi(argv[++i]);
         }
         else if (arg == "-o" || arg == "--output") {
             if (i + 1 < argc) outputDir = argv[++i];
         }
+        else if (arg == "-f" || arg == "--fast-shower") {
+            fastShower = true;
+        }
         else if (arg == "-v" || arg == "--vis") {
             useVis = true;
         }
         else if (arg == "-i" || arg == "--interactive") {
             interactive = true;
         }
+        else if (arg == "-r" || arg == "--replay") {
+            if (i + 1 >= argc || std::sscanf(argv[++i], "%d:%d", &replayRun, &replayEvent) != 2 ||
+                replayRun < 0 || replayEvent < 0) {
+                G4cerr << "--replay expects <run>:<event>, both >= 0" << G4endl;
+                return 1;
+            }
+        }
         else if (arg[0] != '-') {
             macroFile = arg;
         }
     }
     
+    // Phases before the first event, reported with the first run
+    StartupMetrics::Start(argc, argv, outputDir);
+    
+    if (replayRun >= 0) {
+        if (macroFile.empty()) {
+            G4cerr << "--replay needs the macro of the original run" << G4endl;
+            return 1;
+        }
+        EventRecorder::SetReplay(replayRun, replayEvent);
+        if (!EventRecorder::LoadReplay(outputDir)) return 1;
+    }
+    
     // Create run manager
     auto* runManager = G4RunManagerFactory::CreateRunManager(
         G4RunManagerType::Default
@@ -86,6 +158,7 @@ int main(int argc, char** argv) {
         G4cout << "Using " << nThreads << " threads" << G4endl;
     }
     #endif
+    StartupMetrics::Mark("run manager");
     
     // Detector construction
     DetectorConstruction* detector = nullptr;
@@ -96,25 +169,28 @@ int main(int argc, char** argv) {
         detector = new DetectorConstruction();
     }
     runManager->SetUserInitialization(detector);
+    StartupMetrics::Mark("detector construction");
     
-    // Physics list
-    G4VModularPhysicsList* physicsList = nullptr;
-    if (physicsName == "QGSP_BERT") {
-        physicsList = new QGSP_BERT;
-    }
-    else if (physicsName == "QGSP_BIC") {
-        physicsList = new QGSP_BIC;
-    }
-    else if (physicsName == "Shielding") {
-        physicsList = new Shielding;
-    }
-    else {
-        physicsList = new FTFP_BERT;
+    // Physics list: preset first, explicit options override it
+    PhysicsListBuilder physicsBuilder;
+    if (!presetName.empty() && !physicsBuilder.ApplyPreset(presetName)) {
+        G4cerr << "Unknown physics preset: " << presetName << G4endl;
+        PhysicsListBuilder::PrintPresets();
+        return 1;
     }
+    if (!physicsName.empty()) physicsBuilder.SetBaseList(physicsName);
+    if (!emOption.empty()) physicsBuilder.SetEmOption(emOption);
+    if (!extraBuilders.empty()) physicsBuilder.AddBuilders(extraBuilders);
+    if (fastShower) physicsBuilder.AddBuilders("fastshower");
+    physicsBuilder.Print();
+    
+    G4VModularPhysicsList* physicsList = physicsBuilder.Build();
     runManager->SetUserInitialization(physicsList);
+    StartupMetrics::Mark("physics list");
     
     // User actions
     runManager->SetUserInitialization(new ActionInitialization(outputDir));
+    StartupMetrics::Mark("user actions");
     
     // Visualization
     G4VisManager* visManager = nullptr;
@@ -126,7 +202,16 @@ int main(int argc, char** argv) {
     // UI manager
     G4UImanager* UImanager = G4UImanager::GetUIpointer();
     
-    if (!macroFile.empty()) {
+    if (EventRecorder::IsReplay()) {
+        // Same configuration as the original run, then one event with its seeds
+        G4int runCount = 0;
+        if (!ExecuteUntilRun(UImanager, macroFile, replayRun, runCount)) {
+            G4cerr << "Macro " << macroFile << " has no run " << replayRun << G4endl;
+        } else {
+            UImanager->ApplyCommand("/run/beamOn 1");
+        }
+    }
+    else if (!macroFile.empty()) {
         // Batch mode
         G4cout << "Executing macro: " << macroFile << G4endl;
         G4String command = "/control/execute ";
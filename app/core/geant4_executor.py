@@ -11,8 +11,10 @@ Supports:
 """
 
 import asyncio
+import json
 import os
 import re
+import shlex
 import subprocess
 import tempfile
 from pathlib import Path
@@ -23,6 +25,10 @@ from loguru import logger
 from app.config import settings
 
 
+# Exit status of geant4api after /geant4api/memory/budget was exceeded
+MEMORY_BUDGET_EXIT_CODE = 75
+
+
 class Geant4Environment:
     """Manages Geant4 environment variables and paths."""
     
@@ -254,6 +260,18 @@ class Geant4Executor:
                         "event_type": "hit",
                         "data": parsed
                     }
+                
+                elif parsed.get("type") == "log" and parsed.get("level") in ("warning", "error"):
+                    yield {
+                        "event_type": "log",
+                        "data": parsed
+                    }
+                
+                elif parsed.get("type") == "metrics":
+                    yield {
+                        "event_type": "metrics",
+                        "data": parsed.get("record", {})
+                    }
             
             # Forward output for logging
             if output_callback:
@@ -274,6 +292,16 @@ class Geant4Executor:
                     "events_per_second": events_completed / elapsed if elapsed > 0 else 0
                 }
             }
+        elif return_code == MEMORY_BUDGET_EXIT_CODE:
+            yield {
+                "event_type": "error",
+                "data": {
+                    "status": "failed",
+                    "return_code": return_code,
+                    "total_events": events_completed,
+                    "message": "Geant4 exceeded its memory budget; the outputs of the aborted run were saved"
+                }
+            }
         else:
             yield {
                 "event_type": "error",
@@ -298,6 +326,26 @@ class Geant4Executor:
     def _parse_output_line(self, line: str) -> Optional[Dict[str, Any]]:
         """Parse Geant4 output line for relevant information."""
         
+        # Structured record, e.g. the startup phases after the first run:
+        # "METRICS {"record": "startup", "phases": [...], ...}"
+        # (worker output carries a "G4WTn > " prefix)
+        match = re.search(r"METRICS\s+(\{.*\})\s*$", line)
+        if match:
+            try:
+                return {"type": "metrics", "record": json.loads(match.group(1))}
+            except json.JSONDecodeError:
+                return None
+        
+        # Log records of the event loop:
+        # "LOG info progress event=1200" (geant4api),
+        # "LOG info event event=12 hits=42 edep_kev=123.45" (B2a)
+        match = re.search(r"\bLOG (debug|info|warning|error) (\w+)(.*)$", line)
+        if match:
+            record = self._parse_log_fields(match.group(3))
+            if match.group(2) in ("progress", "event") and "event" in record:
+                return {"type": "event", "event_id": int(record["event"]), "record": record}
+            return {"type": "log", "level": match.group(1), "tag": match.group(2), "record": record}
+        
         # Match event processing output
         # Common formats:
         # ">>> Event 100" or "Event: 100" or "Processing event 100"
@@ -339,6 +387,28 @@ class Geant4Executor:
         
         return None
     
+    @staticmethod
+    def _parse_log_fields(text: str) -> Dict[str, Any]:
+        """Parse the key=value fields of a log record; numbers become numbers."""
+        fields: Dict[str, Any] = {}
+        try:
+            tokens = shlex.split(text)
+        except ValueError:
+            tokens = text.split()
+        for token in tokens:
+            key, sep, value = token.partition("=")
+            if not sep:
+                continue
+            for convert in (int, float):
+                try:
+                    fields[key] = convert(value)
+                    break
+                except ValueError:
+                    continue
+            else:
+                fields[key] = value
+        return fields
+    
     async def terminate(self):
         """Terminate the running process."""
         if self._process:
@@ -3,6 +3,7 @@ Result collector for aggregating and storing simulation results.
 """
 
 import json
+import math
 import numpy as np
 from pathlib import Path
 from typing import Dict, List, Any, Optional
@@ -16,6 +17,55 @@ from app.models.results import (
 )
 
 
+# Hits kept per simulation for the results; later hits only update the statistics
+HIT_SAMPLE_SIZE = 1000
+
+
+class RunningStats:
+    """
+    Running count, mean, M2, min and max (Welford), in constant memory.
+    """
+    
+    __slots__ = ("count", "mean", "m2", "min", "max")
+    
+    def __init__(self, count: int = 0, mean: float = 0.0, m2: float = 0.0,
+                 min: float = math.inf, max: float = -math.inf):
+        self.count = count
+        self.mean = mean
+        self.m2 = m2
+        self.min = min
+        self.max = max
+    
+    def add(self, value: float):
+        self.count += 1
+        delta = value - self.mean
+        self.mean += delta / self.count
+        self.m2 += delta * (value - self.mean)
+        self.min = min(self.min, value)
+        self.max = max(self.max, value)
+    
+    def merge(self, other: "RunningStats"):
+        """Combine with the moments of another sample (Chan et al.)."""
+        if other.count == 0:
+            return
+        total = self.count + other.count
+        delta = other.mean - self.mean
+        self.mean += delta * other.count / total
+        self.m2 += other.m2 + delta * delta * self.count * other.count / total
+        self.count = total
+        self.min = min(self.min, other.min)
+        self.max = max(self.max, other.max)
+    
+    @property
+    def total(self) -> float:
+        return self.mean * self.count
+    
+    @property
+    def std(self) -> float:
+        """Population standard deviation, as np.std."""
+        return math.sqrt(self.m2 / self.count) if self.count > 1 else 0.0
+
+
 class ResultCollector:
     """
     Collects, aggregates, and stores simulation results.
@@ -37,10 +87,12 @@ class ResultCollector:
     def create_collector(self, simulation_id: str):
         """Initialize a new result collector for a simulation."""
         self._active_collectors[simulation_id] = {
-            "hits": [],
+            "hits": [],  # first HIT_SAMPLE_SIZE hits
+            "total_hits": 0,
             "trajectories": [],
             "event_summaries": [],
-            "energy_deposits": {},  # detector_name -> list of deposits
+            "energy_deposits": {},  # detector_name -> RunningStats of hit deposits
+            "detector_statistics": None,  # last "detectors" record of geant4api
             "particle_counts": {},
             "start_time": datetime.utcnow(),
             "events_processed": 0
@@ -53,15 +105,17 @@ class ResultCollector:
             self.create_collector(simulation_id)
         
         collector = self._active_collectors[simulation_id]
-        collector["hits"].append(hit)
+        collector["total_hits"] += 1
+        if len(collector["hits"]) < HIT_SAMPLE_SIZE:
+            collector["hits"].append(hit)
         
         # Update aggregates
         detector = hit.get("detector_name", "unknown")
         energy = hit.get("energy_deposit", 0)
         
         if detector not in collector["energy_deposits"]:
-            collector["energy_deposits"][detector] = []
-        collector["energy_deposits"][detector].append(energy)
+            collector["energy_deposits"][detector] = RunningStats()
+        collector["energy_deposits"][detector].add(energy)
         
         # Count particles
         particle = hit.get("particle_name", "unknown")
@@ -89,6 +143,17 @@ class ResultCollector:
         collector["event_summaries"].append(summary)
         collector["events_processed"] += 1
     
+    def add_detector_statistics(self, simulation_id: str, record: Dict[str, Any]):
+        """
+        Add the per-detector summaries that geant4api prints at the end of a
+        run ("METRICS {"record": "detectors", ...}"); they replace the
+        statistics of the hit stream in the results.
+        """
+        if simulation_id not in self._active_collectors:
+            self.create_collector(simulation_id)
+        
+        self._active_collectors[simulation_id]["detector_statistics"] = record
+    
     def get_current_stats(self, simulation_id: str) -> Dict[str, Any]:
         """Get current statistics for an active simulation."""
         if simulation_id not in self._active_collectors:
@@ -98,19 +163,19 @@ class ResultCollector:
         
         stats = {
             "events_processed": collector["events_processed"],
-            "total_hits": len(collector["hits"]),
+            "total_hits": collector["total_hits"],
             "particle_counts": collector["particle_counts"],
             "detectors": {}
         }
         
         # Detector statistics
         for detector, deposits in collector["energy_deposits"].items():
-            if deposits:
+            if deposits.count:
                 stats["detectors"][detector] = {
-                    "hits": len(deposits),
-                    "total_energy": sum(deposits),
-                    "mean_energy": np.mean(deposits),
-                    "max_energy": max(deposits)
+                    "hits": deposits.count,
+                    "total_energy": deposits.total,
+                    "mean_energy": deposits.mean,
+                    "max_energy": deposits.max
                 }
         
         return stats
@@ -127,26 +192,24 @@ class ResultCollector:
         elapsed = (end_time - collector["start_time"]).total_seconds()
         
         # Generate detector summaries
-        detector_summaries = []
-        total_energy = 0
-        
-        for detector, deposits in collector["energy_deposits"].items():
-            if deposits:
-                total_dep = sum(deposits)
-                total_energy += total_dep
-                
-                events = collector["events_processed"] or 1
-                mean_per_event = total_dep / events
-                std_per_event = np.std(deposits) if len(deposits) > 1 else 0
-                
-                detector_summaries.append(DetectorSummary(
-                    name=detector,
-                    total_hits=len(deposits),
-                    total_energy_deposit=total_dep,
-                    mean_energy_per_event=mean_per_event,
-                    std_energy_per_event=float(std_per_event),
-                    hit_efficiency=len(deposits) / events if events > 0 else 0
-                ))
+        if collector["detector_statistics"]:
+            detector_summaries = self._summaries_from_record(
+                collector["detector_statistics"], collector["events_processed"]
+            )
+        else:
+            detector_summaries = []
+            for detector, deposits in collector["energy_deposits"].items():
+                if deposits.count:
+                    events = collector["events_processed"] or 1
+                    detector_summaries.append(DetectorSummary(
+                        name=detector,
+                        total_hits=deposits.count,
+                        total_energy_deposit=deposits.total,
+                        mean_energy_per_event=deposits.total / events,
+                        std_energy_per_event=deposits.std,
+                        hit_efficiency=deposits.count / events if events > 0 else 0
+                    ))
+        total_energy = sum(summary.total_energy_deposit for summary in detector_summaries)
         
         # Create results object
         results = SimulationResults(
@@ -162,7 +225,7 @@ class ResultCollector:
             primary_particles_generated=collector["events_processed"],
             total_secondaries_created=sum(collector["particle_counts"].values()),
             particle_statistics=collector["particle_counts"],
-            hits=[HitData(**h) for h in collector["hits"][:1000]] if collector["hits"] else None,
+            hits=[HitData(**h) for h in collector["hits"]] if collector["hits"] else None,
         )
         
         # Save to file
@@ -173,6 +236,32 @@ class ResultCollector:
         
         return results
     
+    @staticmethod
+    def _summaries_from_record(record: Dict[str, Any], events_processed: int) -> List[DetectorSummary]:
+        """
+        Detector summaries from the moments of the events with hits; the
+        events without hits are merged in as zeros.
+        """
+        events = record.get("events") or events_processed or 1
+        summaries = []
+        for detector in record.get("detectors", []):
+            with_hits = RunningStats(detector["count"], detector["mean"], detector["m2"],
+                                     detector["min"], detector["max"])
+            per_event = RunningStats(with_hits.count, with_hits.mean, with_hits.m2)
+            per_event.merge(RunningStats(max(events - with_hits.count, 0)))
+            summaries.append(DetectorSummary(
+                name=detector["name"],
+                total_hits=detector["hits"],
+                total_energy_deposit=with_hits.total,
+                mean_energy_per_event=per_event.mean,
+                std_energy_per_event=per_event.std,
+                hit_efficiency=with_hits.count / events,
+                min_energy_per_event=with_hits.min,
+                max_energy_per_event=with_hits.max,
+                energy_quantiles=detector.get("quantiles")
+            ))
+        return summaries
+    
     def _save_results(self, simulation_id: str, results: SimulationResults):
         """Save results to file."""
         sim_path = self.results_path / simulation_id
@@ -27,6 +27,7 @@ from app.models.geometry import DetectorGeometry
 from app.models.physics import PhysicsConfig
 from app.models.particle import ParticleSource
 from app.models.results import SimulationResults, StreamingEvent, HitData
+from app.core.result_collector import result_collector
 
 # Import the real Geant4 executor
 from app.core.geant4_executor import (
@@ -274,6 +275,10 @@ class SimulationEngine:
                     data = event.get("data", {})
                     job.events_completed = data.get("events_completed", 0)
                 
+                # Per-detector statistics of the run replace those of the hit stream
+                if event.get("event_type") == "metrics" and event.get("data", {}).get("record") == "detectors":
+                    result_collector.add_detector_statistics(job.id, event["data"])
+                
                 yield StreamingEvent(
                     event_type=event.get("event_type", "unknown"),
                     simulation_id=job.id,
@@ -93,6 +93,12 @@ class DetectorSummary(BaseModel):
     mean_energy_per_event: float
     std_energy_per_event: float
     hit_efficiency: float  # fraction of events with hits
+    
+    # Energy of the events with hits (MeV), from the online statistics of
+    # geant4api (DetectorStats); quantiles keyed "p05" ... "p99"
+    min_energy_per_event: Optional[float] = None
+    max_energy_per_event: Optional[float] = None
+    energy_quantiles: Optional[Dict[str, float]] = None
 
 
 class ScoringResult(BaseModel):
@@ -150,7 +156,7 @@ class SimulationResults(BaseModel):
 
 class StreamingEvent(BaseModel):
     """Real-time streaming event data."""
-    event_type: str  # "progress", "event", "hit", "summary", "error"
+    event_type: str  # "progress", "event", "hit", "summary", "metrics", "log", "error"
     simulation_id: str
     timestamp: datetime = Field(default_factory=datetime.utcnow)
     data: Dict[str, Any]
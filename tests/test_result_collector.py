@@ -0,0 +1,70 @@
+"""
+Tests for the detector summaries built from the geant4api "detectors" record.
+
+Run from the repository root: python -m unittest discover tests
+"""
+
+import math
+import tempfile
+import unittest
+
+from app.core.result_collector import ResultCollector, RunningStats
+
+
+# Two events with hits out of four: 2 MeV and 4 MeV
+RECORD = {
+    "record": "detectors", "run": 0, "events": 4, "unit": "MeV",
+    "detectors": [{
+        "name": "Tracker", "hits": 7, "count": 2, "mean": 3.0, "m2": 2.0,
+        "min": 2.0, "max": 4.0, "quantiles": {"p50": 3.0, "p99": 4.0}
+    }]
+}
+
+
+class RunningStatsTest(unittest.TestCase):
+
+    def test_merge_matches_single_pass(self):
+        values = [0.5, 2.0, 2.0, 7.25, 3.0, 0.0, 1.5]
+        whole, left, right = RunningStats(), RunningStats(), RunningStats()
+        for i, value in enumerate(values):
+            whole.add(value)
+            (left if i < 3 else right).add(value)
+        left.merge(right)
+        self.assertEqual(left.count, whole.count)
+        self.assertAlmostEqual(left.mean, whole.mean)
+        self.assertAlmostEqual(left.m2, whole.m2)
+        self.assertEqual((left.min, left.max), (0.0, 7.25))
+
+
+class SummariesFromRecordTest(unittest.TestCase):
+
+    def test_events_without_hits_count_as_zero(self):
+        [summary] = ResultCollector._summaries_from_record(RECORD, events_processed=0)
+        # Per event over [2, 4, 0, 0], not per event with hits over [2, 4]
+        self.assertAlmostEqual(summary.mean_energy_per_event, 1.5)
+        self.assertAlmostEqual(summary.std_energy_per_event, math.sqrt(11.0 / 4))
+        self.assertAlmostEqual(summary.total_energy_deposit, 6.0)
+        self.assertAlmostEqual(summary.hit_efficiency, 0.5)
+        self.assertEqual(summary.total_hits, 7)
+        self.assertEqual((summary.min_energy_per_event, summary.max_energy_per_event), (2.0, 4.0))
+        self.assertEqual(summary.energy_quantiles, {"p50": 3.0, "p99": 4.0})
+
+    def test_events_processed_when_record_has_none(self):
+        record = dict(RECORD, events=None)
+        [summary] = ResultCollector._summaries_from_record(record, events_processed=2)
+        self.assertAlmostEqual(summary.mean_energy_per_event, 3.0)
+        self.assertAlmostEqual(summary.std_energy_per_event, 1.0)
+        self.assertAlmostEqual(summary.hit_efficiency, 1.0)
+
+    def test_finalize_uses_the_record(self):
+        with tempfile.TemporaryDirectory() as results_path:
+            collector = ResultCollector(results_path)
+            collector.add_detector_statistics("sim", RECORD)
+            results = collector.finalize("sim")
+        [summary] = results.detector_summaries
+        self.assertEqual(summary.name, "Tracker")
+        self.assertAlmostEqual(summary.mean_energy_per_event, 1.5)
+
+
+if __name__ == "__main__":
+    unittest.main()